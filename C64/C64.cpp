@@ -102,6 +102,7 @@ C64::C64()
         &drive2,
         &datasette,
         &mouse,
+        &input,
         NULL };
     
     registerSubComponents(subcomponents, sizeof(subcomponents));
@@ -127,9 +128,6 @@ C64::C64()
     drive1.powerOn();
     drive2.powerOff();
     
-    // Initialize mach timer info
-    mach_timebase_info(&timebase);
-
     reset();
 }
 
@@ -157,7 +155,11 @@ C64::reset()
     debug("Setting PC to %04X\n", cpu.regPC);
     
     rasterCycle = 1;
-    nanoTargetTime = 0UL;
+    driveLag = 0;
+    driveCycle = cpu.cycle;
+    pacer.invalidate();
+    warpPolicy.reset();
+    bootCache.cancelRecording();
     ping();
 }
 
@@ -216,9 +218,17 @@ C64::dump() {
     msg("             Current frame : %d\n", frame);
     msg("        Current rasterline : %d\n", rasterLine);
     msg("  Current rasterline cycle : %d\n", rasterCycle);
-    msg("              Ultimax mode : %s\n\n", getUltimax() ? "YES" : "NO");
+    msg("              Ultimax mode : %s\n", getUltimax() ? "YES" : "NO");
+    msg("       Drive lag (max lag) : %d (%d) cycles\n", driveLag, maxDriveLag);
+    msg("           Parallel drives : %s\n", getParallelDrives() ? "YES" : "NO");
+    msg("            Frame pipeline : %s\n\n", getFramePipeline() ? "YES" : "NO");
     msg("warp, warpLoad, alwaysWarp : %d %d %d\n", warp, warpLoad, alwaysWarp);
     msg("\n");
+    warpPolicy.dump();
+    pacer.dump();
+    bootCache.dump();
+    fingerprints.dump();
+    cpuTrace.dump();
 }
 
 C64Model
@@ -371,6 +381,7 @@ C64::powerUp()
 {    
     suspend();
     reset();
+    bootCache.restore(this);
     resume();
     run();
 }
@@ -482,7 +493,7 @@ C64::executeOneLine()
     
     int lastCycle = vic.getCyclesPerRasterline();
     for (unsigned i = rasterCycle; i <= lastCycle; i++) {
-        if (!_executeOneCycle()) {
+        if (!(unlikely(profiling) ? _executeOneCycleProfiled() : _executeOneCycle())) {
             if (i == lastCycle)
             endRasterLine();
             return false;
@@ -512,6 +523,13 @@ C64::executeOneCycle()
     bool result = _executeOneCycle();
     if (isLastCycle) endRasterLine();
     
+    // Leave the drives in a consistent state (e.g., for the debugger)
+    synchronizeDrives();
+    if (driveHalted) {
+        driveHalted = false;
+        result = false;
+    }
+    
     return result;
 }
 
@@ -543,19 +561,189 @@ C64::_executeOneCycle()
     (vic.*vicfunc[rasterCycle])();
     if (cycle >= cia1.wakeUpCycle) cia1.executeOneCycle(); else cia1.idleCounter++;
     if (cycle >= cia2.wakeUpCycle) cia2.executeOneCycle(); else cia2.idleCounter++;
-    if (iec.isDirtyC64Side) iec.updateIecLinesC64Side();
+    if (iec.isDirtyC64Side) {
+        synchronizeDrives();
+        iec.updateIecLinesC64Side();
+    }
     
     // Second clock phase (o2 high)
     result &= cpu.executeOneCycle();
-    if (drive1.isPoweredOn()) result &= drive1.execute(durationOfOneCycle);
-    if (drive2.isPoweredOn()) result &= drive2.execute(durationOfOneCycle);
+    if (++driveLag > maxDriveLag) _synchronizeDrives();
     // if (iec.isDirtyDriveSide) iec.updateIecLinesDriveSide();
     datasette.execute();
     
+    if (unlikely(driveHalted)) {
+        driveHalted = false;
+        result = false;
+    }
+    
+    rasterCycle++;
+    return result;
+}
+
+bool
+C64::_executeOneCycleProfiled()
+{
+    // Keep in sync with _executeOneCycle()
+    uint8_t result = true;
+    uint64_t cycle = ++cpu.cycle;
+    
+    // First clock phase (o2 low)
+    profilePhase = PROF_VIC;
+    (vic.*vicfunc[rasterCycle])();
+    profilePhase = PROF_CIA;
+    if (cycle >= cia1.wakeUpCycle) cia1.executeOneCycle(); else cia1.idleCounter++;
+    if (cycle >= cia2.wakeUpCycle) cia2.executeOneCycle(); else cia2.idleCounter++;
+    if (iec.isDirtyC64Side) {
+        profilePhase = PROF_DRIVE;
+        synchronizeDrives();
+        iec.updateIecLinesC64Side();
+    }
+    
+    // Second clock phase (o2 high)
+    profilePhase = PROF_CPU;
+    result &= cpu.executeOneCycle();
+    profilePhase = PROF_DRIVE;
+    if (++driveLag > maxDriveLag) _synchronizeDrives();
+    profilePhase = PROF_DATASETTE;
+    datasette.execute();
+    profilePhase = PROF_OTHER;
+    
+    if (unlikely(driveHalted)) {
+        driveHalted = false;
+        result = false;
+    }
+    
     rasterCycle++;
     return result;
 }
 
+void
+C64::_synchronizeDrives()
+{
+    VC1541 *d1 = drive1.isPoweredOn() ? &drive1 : NULL;
+    VC1541 *d2 = drive2.isPoweredOn() ? &drive2 : NULL;
+    
+    if (!driveScheduler.execute(d1, d2, driveCycle + 1, driveLag, durationOfOneCycle)) {
+        driveHalted = true;
+    }
+    driveCycle += driveLag;
+    driveLag = 0;
+}
+
+void
+C64::setMaxDriveLag(unsigned cycles)
+{
+    suspend();
+    synchronizeDrives();
+    maxDriveLag = cycles;
+    resume();
+}
+
+void
+C64::setParallelDrives(bool value)
+{
+    suspend();
+    synchronizeDrives();
+    driveScheduler.setParallel(value);
+    resume();
+}
+
+void
+C64::setFramePipeline(bool value)
+{
+    suspend();
+    pipeline.setEnabled(value);
+    pipelineSamples.clear();
+    sid.setAudioTap(pipeline.isEnabled() ? &pipelineSamples : NULL);
+    resume();
+}
+
+bool
+C64::startCPUTrace(const char *path)
+{
+    uint8_t lengths[256];
+    for (unsigned i = 0; i < 256; i++) {
+        lengths[i] = cpu.getLengthOfInstruction(i);
+    }
+    
+    suspend();
+    bool result = cpuTrace.startRecording(path, lengths);
+    if (result) {
+        cpu.connectTraceFile(&cpuTrace, TRACE_C64);
+        drive1.cpu.connectTraceFile(&cpuTrace, TRACE_DRIVE1);
+        drive2.cpu.connectTraceFile(&cpuTrace, TRACE_DRIVE2);
+        driveScheduler.setSerialized(true);
+    }
+    resume();
+    
+    return result;
+}
+
+void
+C64::stopCPUTrace()
+{
+    suspend();
+    cpu.connectTraceFile(NULL, TRACE_C64);
+    drive1.cpu.connectTraceFile(NULL, TRACE_DRIVE1);
+    drive2.cpu.connectTraceFile(NULL, TRACE_DRIVE2);
+    driveScheduler.setSerialized(false);
+    cpuTrace.stopRecording();
+    resume();
+}
+
+void
+C64::submitFrame()
+{
+    FrameRecord *record = pipeline.acquire();
+    
+    record->frame = frame;
+    record->cycle = cpu.cycle;
+    record->warp = warp;
+    
+    int *pixels = (int *)vic.screenBuffer();
+    record->pixels.assign(pixels, pixels + PAL_RASTERLINES * NTSC_PIXELS);
+    record->samples.swap(pipelineSamples);
+    
+    pipeline.submit(record);
+}
+
+void
+C64::computeFingerprint(FrameFingerprint *fp)
+{
+    fp->frame = frame;
+    fp->cycle = cpu.cycle;
+    fp->component[FP_CPU] = cpu.fingerprint();
+    fp->component[FP_MEMORY] = mem.fingerprint();
+    fp->component[FP_VIC] = vic.fingerprint();
+    fp->component[FP_CIA1] = cia1.fingerprint();
+    fp->component[FP_CIA2] = cia2.fingerprint();
+    fp->component[FP_SID] = sid.fingerprint();
+    fp->component[FP_DRIVE1] = drive1.fingerprint();
+    fp->component[FP_DRIVE2] = drive2.fingerprint();
+    
+    // All remaining components and the C64 itself
+    VirtualComponent *others[] = {
+        &processorPort, &keyboard, &port1, &port2, &expansionport,
+        &iec, &datasette, &mouse, &input };
+    
+    uint64_t hash = fingerprintItems(0xcbf29ce484222325);
+    for (unsigned i = 0; i < sizeof(others) / sizeof(others[0]); i++) {
+        hash = combineFingerprints(hash, others[i]->fingerprint());
+    }
+    fp->component[FP_OTHER] = hash;
+    
+    fp->combined = fnv_1a((uint8_t *)fp->component, sizeof(fp->component));
+}
+
+uint64_t
+C64::fingerprint()
+{
+    FrameFingerprint fp;
+    computeFingerprint(&fp);
+    return fp.combined;
+}
+
 void
 C64::beginRasterLine()
 {
@@ -564,12 +752,22 @@ C64::beginRasterLine()
         vic.beginFrame();
     }
     vic.beginRasterline(rasterLine);
+    
+    // Apply pending keyboard and joystick events
+    if (input.needsService()) input.execute();
+    
+    // Cache the boot state if the Kernal is ready
+    if (unlikely(bootCache.isRecording())) serviceBootCache();
+    
+    // Start a program if the Kernal is ready
+    if (unlikely(injection != nullptr)) serviceInjection();
 }
 
 void
 C64::endRasterLine()
 {
     vic.endRasterline();
+    if (warpPolicy.tracksIdle()) warpPolicy.samplePC(cpu.getPC());
     rasterCycle = 1;
     rasterLine++;
     
@@ -585,6 +783,9 @@ C64::endFrame()
     frame++;
     vic.endFrame();
     
+    // Bring the drives up to date
+    synchronizeDrives();
+    
     // Increment time of day clocks every tenth of a second
     cia1.incrementTOD();
     cia2.incrementTOD();
@@ -601,6 +802,16 @@ C64::endFrame()
     // Update mouse coordinates
     mouse.execute();
     
+    // Record the state of the finished frame
+    if (fingerprints.isEnabled()) {
+        FrameFingerprint fp;
+        computeFingerprint(&fp);
+        fingerprints.record(fp);
+    }
+    
+    // Hand off the finished frame to the presentation thread
+    if (pipeline.isEnabled()) submitFrame();
+    
     // Take a snapshot once in a while
     if (takeAutoSnapshots && autoSnapshotInterval > 0) {
         unsigned fps = (unsigned)vic.getFramesPerSecond();
@@ -610,6 +821,7 @@ C64::endFrame()
     }
     
     // Count some sheep (zzzzzz) ...
+    updateWarpPolicy();
     if (!getWarp()) {
             synchronizeTiming();
     }
@@ -618,7 +830,7 @@ C64::endFrame()
 bool
 C64::getWarp()
 {
-    bool newValue = (warpLoad && iec.isBusy()) || alwaysWarp;
+    bool newValue = warpPolicy.shouldWarp();
     
     if (newValue != warp) {
         warp = newValue;
@@ -645,12 +857,34 @@ C64::getWarp()
     return warp;
 }
 
+void
+C64::updateWarpPolicy()
+{
+    uint32_t signals = 0;
+    
+    if (iec.isBusy()) {
+        signals |= 1 << WARP_IEC;
+    }
+    if (datasette.getPlayKey() && datasette.getMotor()) {
+        signals |= 1 << WARP_TAPE;
+    }
+    if (warpPolicy.tracksIdle() && warpPolicy.idleLoopDetected()) {
+        signals |= 1 << WARP_IDLE;
+    }
+    if (warpPolicy.isEnabled(WARP_SILENCE) && sid.isSilent()) {
+        signals |= 1 << WARP_SILENCE;
+    }
+    
+    warpPolicy.update(signals);
+}
+
 void
 C64::setAlwaysWarp(bool b)
 {
     if (alwaysWarp != b) {
         
         alwaysWarp = b;
+        warpPolicy.setAlways(b);
         putMessage(b ? MSG_ALWAYS_WARP_ON : MSG_ALWAYS_WARP_OFF);
     }
 }
@@ -659,53 +893,23 @@ void
 C64::setWarpLoad(bool b)
 {
     warpLoad = b;
+    warpPolicy.setEnabled(WARP_IEC, b);
 }
 
 void
 C64::restartTimer()
 {
-    uint64_t kernelNow = mach_absolute_time();
-    uint64_t nanoNow = abs_to_nanos(kernelNow);
-    
-    nanoTargetTime = nanoNow + vic.getFrameDelay();
+    pacer.restart(vic.getFrameDelay());
 }
 
 void
 C64::synchronizeTiming()
 {
-    const uint64_t earlyWakeup = 1500000; /* 1.5 milliseconds */
-    
-    // Get current time in nano seconds
-    uint64_t nanoAbsTime = abs_to_nanos(mach_absolute_time());
-    
-    // Check how long we're supposed to sleep
-    int64_t timediff = (int64_t)nanoTargetTime - (int64_t)nanoAbsTime;
-    if (timediff > 200000000 || timediff < -200000000 /* 0.2 sec */) {
-        
-        // The emulator seems to be out of sync, so we better reset the
-        // synchronization timer
-        
-        debug(2, "Emulator lost synchronization (%lld). Restarting timer.\n", timediff);
-        restartTimer();
-    }
+    // Keep the audio buffer at its target fill level
+    pacer.feedAudio(sid.getReadPtr(), sid.fillLevel(), sid.targetFillLevel());
     
-    // Convert nanoTargetTime into kernel unit
-    int64_t kernelTargetTime = nanos_to_abs(nanoTargetTime);
-    
-    // Sleep and update target timer
-    // debug(2, "%p Sleeping for %lld\n", this, kernelTargetTime - mach_absolute_time());
-    int64_t jitter = sleepUntil(kernelTargetTime, earlyWakeup);
-    nanoTargetTime += vic.getFrameDelay();
-    
-    // debug(2, "Jitter = %d", jitter);
-    if (jitter > 1000000000 /* 1 sec */) {
-        
-        // The emulator did not keep up with the real time clock. Instead of
-        // running behind for a long time, we reset the synchronization timer
-        
-        debug(2, "Jitter exceeds limit (%lld). Restarting synchronization timer.\n", jitter);
-        restartTimer();
-    }
+    // Sleep until the current frame is due
+    pacer.pace(vic.getFrameDelay());
 }
 
 void C64::loadFromSnapshotUnsafe(Snapshot *snapshot)
@@ -714,6 +918,8 @@ void C64::loadFromSnapshotUnsafe(Snapshot *snapshot)
     
     if (snapshot && (ptr = snapshot->getData())) {
         loadFromBuffer(&ptr);
+        driveLag = 0;
+        driveCycle = cpu.cycle;
         keyboard.releaseAll(); // Avoid constantly pressed keys
         ping();
     }
@@ -812,6 +1018,9 @@ C64::flash(AnyC64File *file)
         assert(false);
         result = false;
     }
+    mem.markAllDirty();
+    drive1.mem.markAllDirty();
+    drive2.mem.markAllDirty();
     resume();
     return result;
 }
@@ -828,8 +1037,7 @@ C64::flash(AnyArchive *file, unsigned item)
         case T64_FILE:
         case PRG_FILE:
         case P00_FILE:
-        file->selectItem(item);
-        file->flashItem(mem.ram);
+        result = flash(FlashLoader::shared().prepare(file, item).get());
         break;
         
         default:
@@ -840,6 +1048,124 @@ C64::flash(AnyArchive *file, unsigned item)
     return result;
 }
 
+bool
+C64::flash(const FlashPayload *payload)
+{
+    if (payload == NULL)
+        return false;
+    
+    assert(payload->addr + payload->data.size() <= 0x10000);
+    
+    suspend();
+    memcpy(mem.ram + payload->addr, payload->data.data(), payload->data.size());
+    mem.markDirty(payload->addr, payload->data.size());
+    resume();
+    return true;
+}
+
+bool
+C64::injectAndRun(AnyArchive *file, unsigned item)
+{
+    return injectAndRun(FlashLoader::shared().prepare(file, item));
+}
+
+bool
+C64::injectAndRun(FlashPayloadRef payload)
+{
+    if (!payload || payload->data.empty())
+        return false;
+    
+    suspend();
+    if (!injection) requestWarp();
+    injection = payload;
+    resume();
+    return true;
+}
+
+void
+C64::cancelInjection()
+{
+    suspend();
+    if (injection) {
+        injection.reset();
+        releaseWarp();
+    }
+    resume();
+}
+
+void
+C64::serviceBootCache()
+{
+    uint16_t pc = cpu.getPC();
+    if (pc < KERNAL_INPUT_LOOP_START || pc > KERNAL_INPUT_LOOP_END || mem.ram[0xC6] != 0)
+        return;
+    
+    bootCache.record(this);
+}
+
+void
+C64::serviceInjection()
+{
+    uint8_t *ram = mem.ram;
+    
+    // Wait until the Kernal is idle and the keyboard buffer is empty
+    uint16_t pc = cpu.getPC();
+    if (pc < KERNAL_INPUT_LOOP_START || pc > KERNAL_INPUT_LOOP_END || ram[0xC6] != 0)
+        return;
+    
+    FlashPayloadRef payload = injection;
+    injection.reset();
+    releaseWarp();
+    
+    uint16_t addr = payload->addr;
+    uint32_t end = addr + (uint32_t)payload->data.size();
+    memcpy(ram + addr, payload->data.data(), payload->data.size());
+    mem.markDirty(addr, payload->data.size());
+    mem.markDirty(0x0000);
+    mem.markDirty(0x0277);
+    
+    // Set the end of program pointer like LOAD does
+    uint16_t end16 = (uint16_t)MIN(end, 0xFFFF);
+    ram[0xAE] = LO_BYTE(end16);
+    ram[0xAF] = HI_BYTE(end16);
+    
+    char command[16];
+    uint16_t basicStart = LO_HI(ram[0x2B], ram[0x2C]);
+    
+    if (addr == basicStart) {
+        
+        // Relink the program lines (same as LINKPRG at $A533)
+        uint32_t line = addr;
+        while (line + 4 < end && ram[line + 1]) {
+            uint32_t next = line + 4;
+            while (next < end && ram[next]) next++;
+            next++;
+            ram[line] = LO_BYTE(next);
+            ram[line + 1] = HI_BYTE(next);
+            line = next;
+        }
+        
+        // Let VARTAB, ARYTAB, and STREND point behind the program
+        for (uint16_t ptr = 0x2D; ptr <= 0x31; ptr += 2) {
+            ram[ptr] = LO_BYTE(end16);
+            ram[ptr + 1] = HI_BYTE(end16);
+        }
+        strcpy(command, "RUN\r");
+        
+    } else {
+        
+        snprintf(command, sizeof(command), "SYS%d\r", addr);
+    }
+    
+    // Put the command into the keyboard buffer
+    size_t length = strlen(command);
+    memcpy(ram + 0x277, command, length);
+    ram[0xC6] = (uint8_t)length;
+    
+    debug(2, "Injected %d bytes at %04X and typed %s\n", payload->data.size(), addr, command);
+    putMessage(MSG_PROGRAM_STARTED, addr);
+}
+
 bool
 C64::loadRom(const char *filename)
 {
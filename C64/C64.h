@@ -41,12 +41,19 @@
 #include "ROMFile.h"
 #include "TAPFile.h"
 #include "CRTFile.h"
+#include "FlashLoader.h"
+#include "BootCache.h"
+#include "FramePacer.h"
+#include "FramePipeline.h"
 
 // Sub components
 #include "ProcessorPort.h"
 #include "ExpansionPort.h"
 #include "IEC.h"
+#include "WarpPolicy.h"
+#include "StateFingerprint.h"
 #include "Keyboard.h"
+#include "InputQueue.h"
 #include "ControlPort.h"
 #include "Memory.h"
 #include "C64Memory.h"
@@ -64,6 +71,7 @@
 
 // Peripherals
 #include "Drive.h"
+#include "DriveScheduler.h"
 #include "Datasette.h"
 #include "Mouse.h"
 
@@ -127,12 +135,30 @@ class C64 : public VirtualComponent {
     //! @brief    A second VC1541 floppy drive (with device number 9)
     VC1541 drive2 = VC1541(2);
     
+    //! @brief    Executes the pending cycles of both drives
+    DriveScheduler driveScheduler;
+    
     //! @brief    A Commodore 1530 (C2N) Datasette
     Datasette datasette;
     
     //! @brief    An external mouse
     Mouse mouse;
     
+    //! @brief    Feeds keyboard and joystick input in at defined points in time
+    InputQueue input;
+    
+    //! @brief    Decides when to run at maximum speed
+    WarpPolicy warpPolicy;
+    
+    //! @brief    Skips the Kernal boot by restoring a cached snapshot
+    BootCache bootCache;
+    
+    //! @brief    Fingerprints of the emulator state of the most recent frames
+    StateFingerprint fingerprints;
+    
+    //! @brief    Records the instructions of all CPUs in a file
+    CPUTrace cpuTrace;
+    
     
     //
     // Frame, rasterline, and rasterline cycle information
@@ -166,6 +192,38 @@ class C64 : public VirtualComponent {
      */
     uint64_t durationOfOneCycle;
     
+    /*! @brief    Number of C64 cycles the drives are lagging behind
+     *  @details  The drives are not executed in lockstep with the C64. They
+     *            are caught up in slices by synchronizeDrives() instead.
+     *  @see      synchronizeDrives()
+     */
+    unsigned driveLag = 0;
+    
+    //! @brief    The last C64 cycle that has been executed by the drives
+    uint64_t driveCycle = 0;
+    
+    /*! @brief    Maximum number of cycles the drives may lag behind
+     *  @details  A value of 0 executes the drives in lockstep with the C64.
+     */
+    unsigned maxDriveLag = 1024;
+    
+    //! @brief    Indicates that a drive CPU has halted while catching up
+    bool driveHalted = false;
+    
+    /*! @brief    Indicates that the emulator is being profiled
+     *  @details  If true, executeOneLine() keeps profilePhase up to date.
+     *  @see      Benchmark
+     */
+    bool profiling = false;
+    
+    //! @brief    Component that is currently executed (ProfiledComponent)
+    volatile uint8_t profilePhase = PROF_OTHER;
+    
+    /*! @brief    Program waiting to be injected by injectAndRun()
+     *  @details  NULL, if no injection is pending.
+     */
+    FlashPayloadRef injection;
+    
     //! @brief    VICII function table.
     /*! @details  Stores a pointer to the VICII method that is executed
      *            in a certain rasterline cycle.
@@ -188,19 +246,17 @@ class C64 : public VirtualComponent {
      */
     pthread_t p;
     
+    //! @brief    Puts the emulation thread to sleep for the proper amount of time
+    FramePacer pacer;
+    
+    //! @brief    Hands off finished frames to a presentation thread
+    FramePipeline pipeline;
+    
     private:
     
-    /*! @brief    System timer information
-     *  @details  Used to put the emulation thread to sleep for the proper
-     *            amount of time.
-     */
-    mach_timebase_info_data_t timebase;
+    //! @brief    Audio samples of the current frame (collected for the pipeline)
+    std::vector<float> pipelineSamples;
     
-    /*! @brief    Wake-up time of the synchronization timer in nanoseconds
-     *  @details  This value is recomputed each time the emulator thread is
-     *            put to sleep.
-     */
-    uint64_t nanoTargetTime;
     
     /*! @brief    Indicates if c64 is currently running at maximum speed
      *            (with timing synchronization disabled)
@@ -287,6 +343,14 @@ class C64 : public VirtualComponent {
     void resume();
     void dump();
     
+    /*! @brief    Method from VirtualComponent
+     *  @details  The drives are caught up first. Otherwise, a snapshot taken
+     *            in the middle of a frame would contain drives lagging behind
+     *            the CPU, and the lag would be lost when the snapshot is
+     *            restored.
+     */
+    void willSaveToBuffer(uint8_t **buffer) { synchronizeDrives(); }
+    
  
     //
     //! @functiongroup Configuring the emulator
@@ -328,7 +392,9 @@ class C64 : public VirtualComponent {
     Message getMessage() { return queue.getMessage(); }
     
     //! @brief    Feeds a notification message into message queue
-    void putMessage(MessageType msg, uint64_t data = 0) { queue.putMessage(msg, data); }
+    void putMessage(MessageType msg, uint64_t data = 0) {
+        queue.putMessage(msg, data);
+        if (pipeline.isEnabled()) pipeline.recordMessage(msg, (long)data); }
     
     
     //
@@ -337,7 +403,9 @@ class C64 : public VirtualComponent {
     
     /*! @brief    Cold starts the virtual C64.
      *  @details  The emulator and all of its sub components are reset and
-     *            the execution thread is started.
+     *            the execution thread is started. If the boot cache is
+     *            enabled and holds a snapshot for the current configuration,
+     *            the emulator continues from the end of the Kernal boot.
      *  @note     It it safe to call this function on a running emulator.
      */
     void powerUp();
@@ -399,14 +467,66 @@ class C64 : public VirtualComponent {
      */
     bool executeOneFrame();
     
+    /*! @brief    Lets the drives catch up with the C64
+     *  @details  The drives only influence the C64 via the IEC bus. Hence,
+     *            they may run behind as long as the C64 does not look at the
+     *            bus. This function is called whenever the C64 is about to do
+     *            so, i.e., before the C64 side of the bus is updated and
+     *            before the CPU reads the data port of CIA 2. It executes all
+     *            pending drive cycles, which yields exactly the same results
+     *            as executing the drives in lockstep.
+     */
+    void synchronizeDrives() { if (driveLag) _synchronizeDrives(); }
+    
+    //! @brief    Returns the maximum number of cycles the drives may lag behind
+    unsigned getMaxDriveLag() { return maxDriveLag; }
+    
+    //! @brief    Sets the maximum number of cycles the drives may lag behind
+    void setMaxDriveLag(unsigned cycles);
+    
+    //! @brief    Returns true if both drives are executed in parallel
+    bool getParallelDrives() { return driveScheduler.getParallel(); }
+    
+    /*! @brief    Executes both drives in parallel or serially
+     *  @details  Both modes yield identical results. Parallel execution pays
+     *            off if both drives are busy and maxDriveLag is large.
+     *  @see      DriveScheduler
+     */
+    void setParallelDrives(bool value);
+    
+    //! @brief    Returns true if finished frames are passed to the frame pipeline
+    bool getFramePipeline() { return pipeline.isEnabled(); }
+    
+    /*! @brief    Enables or disables the frame pipeline
+     *  @details  Install a consumer with pipeline.setConsumer() first.
+     */
+    void setFramePipeline(bool value);
+    
+    /*! @brief    Computes the fingerprints of all component groups
+     *  @details  If fingerprints.isEnabled() is true, this function is
+     *            called at the end of each frame and the result is recorded.
+     *  @see      StateFingerprint
+     */
+    void computeFingerprint(FrameFingerprint *fp);
+    
+    //! @brief    Method from VirtualComponent
+    uint64_t fingerprint();
+    
     private:
     
+    //! @brief    Work horse for synchronizeDrives()
+    void _synchronizeDrives();
+    
+    
     //! @brief    Executes a single CPU cycle
     bool executeOneCycle();
     
     //! @brief    Work horse for executeOneCycle()
     bool _executeOneCycle();
     
+    //! @brief    Variant of _executeOneCycle() that updates profilePhase
+    bool _executeOneCycleProfiled();
+    
     //! @brief    Invoked before executing the first cycle of a rasterline
     void beginRasterLine();
     
@@ -416,27 +536,32 @@ class C64 : public VirtualComponent {
     //! @brief    Invoked after executing the last rasterline of a frame
     void endFrame();
     
+    //! @brief    Passes the finished frame to the frame pipeline
+    void submitFrame();
+    
     
     //
     //! @functiongroup Managing the execution thread
     //
     
-    private:
-    
-    //! @brief    Converts kernel time to nanoseconds.
-    uint64_t abs_to_nanos(uint64_t abs) { return abs * timebase.numer / timebase.denom; }
-    
-    //! @brief    Converts nanoseconds to kernel time.
-    uint64_t nanos_to_abs(uint64_t nanos) { return nanos * timebase.denom / timebase.numer; }
-    
     public:
     
     //! @brief    Updates variable warp and returns the new value.
     /*! @details  As a side effect, messages are sent to the GUI if the
      *            variable has changed its value.
+     *  @see      WarpPolicy
      */
     bool getWarp();
     
+    //! @brief    Feeds the warp signals of the current frame into the warp policy
+    void updateWarpPolicy();
+    
+    //! @brief    Requests warp mode until releaseWarp() is called
+    void requestWarp() { warpPolicy.request(); }
+    
+    //! @brief    Releases a request made with requestWarp()
+    void releaseWarp() { warpPolicy.release(); }
+    
     //! @brief    Returns if the emulator should always run full speed.
     bool getAlwaysWarp() { return alwaysWarp; }
     
@@ -459,9 +584,8 @@ class C64 : public VirtualComponent {
     
     /*! @brief    Puts the emulation the thread to sleep for a while.
      *  @details  This function is called inside endFrame(). It makes the
-     *            emulation thread wait until nanoTargetTime has been reached.
-     *            Before returning, nanoTargetTime is assigned with a new target
-     *            value.
+     *            emulation thread wait until the current frame is due.
+     *  @see      FramePacer
      */
     void synchronizeTiming();
     
@@ -561,6 +685,41 @@ class C64 : public VirtualComponent {
     //! @brief    Flashes a single item of an archive into memory
     bool flash(AnyArchive *file, unsigned item);
     
+    /*! @brief    Flashes a prepared item into memory
+     *  @details  The payload is copied into RAM with a single memcpy.
+     *  @seealso  FlashLoader
+     */
+    bool flash(const FlashPayload *payload);
+    
+    /*! @brief    Injects a program and starts it
+     *  @details  The program is copied into RAM as soon as the Kernal waits
+     *            for keyboard input. Until then, warp mode is requested.
+     *            A program loaded to the start of BASIC is relinked, the
+     *            BASIC pointers are set to its end, and RUN is put into the
+     *            keyboard buffer. Otherwise, SYS with the load address is
+     *            put into the keyboard buffer.
+     *            Call this function right after a reset to skip
+     *            LOAD"*",8,1 and RUN altogether.
+     */
+    bool injectAndRun(AnyArchive *file, unsigned item = 0);
+    bool injectAndRun(FlashPayloadRef payload);
+    
+    //! @brief    Returns true if an injected program hasn't been started yet
+    bool isInjecting() { return injection != nullptr; }
+    
+    //! @brief    Cancels a pending injection
+    void cancelInjection();
+    
+    private:
+    
+    //! @brief    Takes the boot cache snapshot once the Kernal has booted
+    void serviceBootCache();
+    
+    //! @brief    Injects and starts the pending program if the Kernal is ready
+    void serviceInjection();
+    
+    public:
+    
  
     //
     //! @functiongroup Set and query ultimax mode
@@ -582,6 +741,16 @@ class C64 : public VirtualComponent {
     //! @functiongroup Debugging
     //
     
+    /*! @brief    Records all instructions of the C64 CPU and the drive CPUs
+     *  @details  The instructions are written to a trace file which can be
+     *            analyzed with a CPUTraceReader.
+     *  @see      CPUTrace
+     */
+    bool startCPUTrace(const char *path);
+    
+    //! @brief    Stops recording and completes the trace file
+    void stopCPUTrace();
+    
     /*! @brief    Returns true if the executable was compiled for development
      *  @details  In release mode, assertion checking should be switched off
      */
@@ -11,6 +11,9 @@
 #include "SID_types.h"
 #include "ControlPort_types.h"
 #include "ExpansionPort_types.h"
+#include "WarpPolicy_types.h"
+#include "StateFingerprint_types.h"
+#include "Benchmark_types.h"
 #include "Cartridge_types.h"
 #include "Drive_types.h"
 #include "Disk_types.h"
@@ -90,12 +93,14 @@ typedef enum {
     MSG_VC1541_ROM_LOADED,
     MSG_ROM_MISSING,
     MSG_SNAPSHOT_TAKEN,
+    MSG_PROGRAM_STARTED,
 
     // CPU related messages
     MSG_CPU_OK,
     MSG_CPU_SOFT_BREAKPOINT_REACHED,
     MSG_CPU_HARD_BREAKPOINT_REACHED,
     MSG_CPU_ILLEGAL_INSTRUCTION,
+    MSG_CPU_WATCHPOINT_REACHED,
     MSG_WARP_ON,
     MSG_WARP_OFF,
     MSG_ALWAYS_WARP_ON,
@@ -21,7 +21,7 @@
 
 #include "C64.h"
 
-CPU::CPU(CPUModel model, Memory *mem)
+CPU::CPU(CPUModel model, Memory *mem) : disassembler(this)
 {
     this->model = model;
     this->mem = mem;
@@ -44,7 +44,7 @@ CPU::CPU(CPUModel model, Memory *mem)
     SnapshotItem items[] = {
         
         // Lifetime items
-        { &model,              sizeof(model),        KEEP_ON_RESET },
+        { &this->model,        sizeof(this->model),  KEEP_ON_RESET },
 
          // Internal state
         { &cycle,              sizeof(cycle),        CLEAR_ON_RESET },
@@ -262,11 +262,108 @@ CPU::setErrorState(ErrorState state)
         case CPU_ILLEGAL_INSTRUCTION:
             c64->putMessage(MSG_CPU_ILLEGAL_INSTRUCTION);
             return;
+        case CPU_WATCHPOINT_REACHED:
+            c64->putMessage(MSG_CPU_WATCHPOINT_REACHED);
+            return;
         default:
             assert(false);
     }
 }
 
+bool
+CPU::setConditionalBreakpoint(uint16_t addr, const char *condition)
+{
+    Condition compiled;
+    
+    if (!compiled.compile(condition)) {
+        warn("Syntax error in breakpoint condition '%s'\n", condition);
+        return false;
+    }
+    
+    suspend();
+    conditions[addr] = compiled;
+    breakpoint[addr] |= CONDITIONAL_BREAKPOINT;
+    resume();
+    return true;
+}
+
+void
+CPU::deleteConditionalBreakpoint(uint16_t addr)
+{
+    suspend();
+    breakpoint[addr] &= ~CONDITIONAL_BREAKPOINT;
+    conditions.erase(addr);
+    resume();
+}
+
+void
+CPU::clearBreakpointHits()
+{
+    suspend();
+    hits.clear();
+    resume();
+}
+
+const char *
+CPU::breakpointCondition(uint16_t addr)
+{
+    auto it = conditions.find(addr);
+    return it != conditions.end() ? it->second.getSource() : NULL;
+}
+
+uint64_t
+CPU::breakpointHits(uint16_t addr)
+{
+    auto it = hits.find(addr);
+    return it != hits.end() ? it->second : 0;
+}
+
+ConditionContext
+CPU::conditionContext(uint16_t addr, uint8_t value)
+{
+    ConditionContext ctx;
+    
+    ctx.a = regA;
+    ctx.x = regX;
+    ctx.y = regY;
+    ctx.sp = regSP;
+    ctx.p = getP();
+    ctx.pc = pc;
+    ctx.addr = addr;
+    ctx.value = value;
+    
+    return ctx;
+}
+
+void
+CPU::breakpointReached()
+{
+    uint8_t tag = breakpoint[pc];
+    
+    if (tag & SOFT_BREAKPOINT) {
+        
+        // Soft breakpoints get deleted when reached
+        breakpoint[pc] &= ~SOFT_BREAKPOINT;
+        setErrorState(CPU_SOFT_BREAKPOINT_REACHED);
+        
+    } else if (tag & HARD_BREAKPOINT) {
+        
+        hits[pc]++;
+        setErrorState(CPU_HARD_BREAKPOINT_REACHED);
+        
+    } else {
+        
+        assert(tag & CONDITIONAL_BREAKPOINT);
+        auto it = conditions.find(pc);
+        if (it == conditions.end() || !it->second.eval(conditionContext(), mem)) return;
+        
+        hits[pc]++;
+        setErrorState(CPU_HARD_BREAKPOINT_REACHED);
+    }
+    
+    debug(1, "Breakpoint reached\n");
+}
+
 unsigned
 CPU::recordedInstructions()
 {
@@ -275,6 +372,21 @@ CPU::recordedInstructions()
 
 void
 CPU::recordInstruction()
+{
+    RecordedInstruction i = captureInstruction();
+    
+    assert(writePtr < traceBufferSize);
+
+    traceBuffer[writePtr] = i;
+    writePtr = (writePtr + 1) % traceBufferSize;
+    if (writePtr == readPtr) {
+        readPtr = (readPtr + 1) % traceBufferSize;
+    }
+    // debug("readPtr = %d writePtr = %d size = %d\n", readPtr, writePtr, recordedInstructions());
+}
+
+RecordedInstruction
+CPU::captureInstruction()
 {
     RecordedInstruction i;
     uint8_t opcode = mem->spypeek(pc);
@@ -291,14 +403,7 @@ CPU::recordInstruction()
     i.sp = regSP;
     i.flags = getP();
     
-    assert(writePtr < traceBufferSize);
-
-    traceBuffer[writePtr] = i;
-    writePtr = (writePtr + 1) % traceBufferSize;
-    if (writePtr == readPtr) {
-        readPtr = (readPtr + 1) % traceBufferSize;
-    }
-    // debug("readPtr = %d writePtr = %d size = %d\n", readPtr, writePtr, recordedInstructions());
+    return i;
 }
 
 RecordedInstruction
@@ -25,6 +25,10 @@
 #include "CPU_types.h"
 #include "CPUInstructions.h"
 #include "TimeDelayed.h"
+#include "Condition.h"
+#include "Disassembler.h"
+#include "CPUTrace.h"
+#include <unordered_map>
 
 class Memory;
 
@@ -32,6 +36,8 @@ class Memory;
  */
 class CPU : public VirtualComponent {
     
+    friend class Disassembler;
+    
     //
     // Types
     //
@@ -69,6 +75,13 @@ class CPU : public VirtualComponent {
     //! @brief    Reference to the connected virtual memory
     Memory *mem;
 
+    public:
+    
+    //! @brief    Batch disassembler
+    Disassembler disassembler;
+    
+    private:
+
 
     //
     // Chip properties
@@ -104,6 +117,12 @@ class CPU : public VirtualComponent {
     
     //! @brief    Breakpoint tag for each memory cell
     uint8_t breakpoint[65536];
+    
+    //! @brief    Conditions of all conditional breakpoints
+    std::unordered_map<uint16_t, Condition> conditions;
+    
+    //! @brief    Number of times each breakpoint has halted the CPU
+    std::unordered_map<uint16_t, uint64_t> hits;
 
     
     //
@@ -237,7 +256,7 @@ class CPU : public VirtualComponent {
      *             where the edge is detected, and stays high until the NMI has
      *             been handled."
      */
-    TimeDelayed<uint8_t> edgeDetector = TimeDelayed<uint8_t>(1, &cycle);
+    TimeDelayed<uint8_t, 1> edgeDetector = TimeDelayed<uint8_t, 1>(&cycle);
     
     /*! @brief    Level detector of IRQ line
      *  @details  https://wiki.nesdev.com/w/index.php/CPU_interrupts
@@ -248,7 +267,7 @@ class CPU : public VirtualComponent {
      *             remaining high as long as the IRQ input is low during the
      *             preceding cycle's φ2).
      */
-    TimeDelayed<uint8_t> levelDetector = TimeDelayed<uint8_t>(1, &cycle);
+    TimeDelayed<uint8_t, 1> levelDetector = TimeDelayed<uint8_t, 1>(&cycle);
     
     //! @brief    Result of the edge detector polling operation
     /*! @details  https://wiki.nesdev.com/w/index.php/CPU_interrupts
@@ -292,6 +311,12 @@ class CPU : public VirtualComponent {
     
     //! @brief  Trace buffer write pointer
     unsigned writePtr;
+    
+    //! @brief  Trace file receiving all executed instructions (if any)
+    CPUTrace *traceFile = NULL;
+    
+    //! @brief  Identifies this CPU in the trace file (TRACE_C64, ...)
+    uint8_t traceSource = TRACE_C64;
 
     
     //
@@ -584,6 +609,49 @@ class CPU : public VirtualComponent {
 	//! @brief    Sets or deletes a hard breakpoint at the specified address.
 	void toggleSoftBreakpoint(uint16_t addr) { breakpoint[addr] ^= SOFT_BREAKPOINT; }
     
+    //! @brief    Checks if a conditional breakpoint is set at the provided address.
+    bool conditionalBreakpoint(uint16_t addr) {
+        return (breakpoint[addr] & CONDITIONAL_BREAKPOINT) != 0; }
+    
+    /*! @brief    Sets a conditional breakpoint at the provided address.
+     *  @details  The condition is compiled once. The fetch path only sees the
+     *            breakpoint tag, so other addresses are not slowed down.
+     *            The emulator is suspended while the condition is stored.
+     *  @return   false, if the condition contains a syntax error.
+     *  @seealso  Condition
+     */
+    bool setConditionalBreakpoint(uint16_t addr, const char *condition);
+    
+    //! @brief    Deletes a conditional breakpoint at the provided address.
+    void deleteConditionalBreakpoint(uint16_t addr);
+    
+    //! @brief    Returns the condition of a breakpoint (NULL if there is none).
+    const char *breakpointCondition(uint16_t addr);
+    
+    //! @brief    Returns how often the breakpoint at addr has halted the CPU.
+    uint64_t breakpointHits(uint16_t addr);
+    
+    //! @brief    Resets all breakpoint hit counters.
+    void clearBreakpointHits();
+    
+    //! @brief    Collects the values a condition can refer to.
+    ConditionContext conditionContext(uint16_t addr = 0, uint8_t value = 0);
+    
+    private:
+    
+    /*! @brief    Handles a tagged memory cell in the fetch phase.
+     *  @details  Only called if the breakpoint tag is not NO_BREAKPOINT.
+     */
+    void breakpointReached();
+    
+    public:
+    
+    /*! @brief    Redirects all memory accesses to another memory object.
+     *  @details  Used by C64Memory to instrument zero page and stack accesses
+     *            while watchpoints are set on page 0.
+     */
+    void connectMemory(Memory *memory) { mem = memory; }
+    
     
     //
     //! @functiongroup Tracing the program execution
@@ -592,12 +660,22 @@ class CPU : public VirtualComponent {
     //! @brief  Clears the trace buffer.
     void clearTraceBuffer() { readPtr = writePtr = 0; }
     
+    /*! @brief  Streams all executed instructions into a trace file
+     *  @param  trace   NULL to stop streaming
+     *  @param  source  Identifies this CPU in the trace file
+     */
+    void connectTraceFile(CPUTrace *trace, uint8_t source) {
+        traceFile = trace; traceSource = source; }
+    
     //! @brief   Returns the number of recorded instructions.
     unsigned recordedInstructions(); 
     
     //! @brief   Records an instruction.
     void recordInstruction();
     
+    //! @brief   Returns the recorded form of the current instruction.
+    RecordedInstruction captureInstruction();
+    
     /*! @brief   Reads and removes a recorded instruction from the trace buffer.
      *  @note    The trace buffer must not be empty.
      */
@@ -500,6 +500,12 @@ CPU::executeOneCycle()
             FETCH_OPCODE
             next = actionFunc[instr];
             
+            // Stream command into the trace file if requested
+            if (unlikely(traceFile != NULL)) {
+                traceFile->record(traceSource, captureInstruction(),
+                                  LO_HI(regADL, regADH), regD);
+            }
+            
             // Disassemble command if requested
             if (unlikely(tracingEnabled())) {
   
@@ -528,14 +534,7 @@ CPU::executeOneCycle()
             
             // Check breakpoint tag
             if (unlikely(breakpoint[pc] != NO_BREAKPOINT)) {
-                if (breakpoint[pc] & SOFT_BREAKPOINT) {
-                    // Soft breakpoints get deleted when reached
-                    breakpoint[pc] &= ~SOFT_BREAKPOINT;
-                    setErrorState(CPU_SOFT_BREAKPOINT_REACHED);
-                } else {
-                    setErrorState(CPU_HARD_BREAKPOINT_REACHED);
-                }
-                debug(1, "Breakpoint reached\n");
+                breakpointReached();
             }
             
             return errorState == CPU_OK;
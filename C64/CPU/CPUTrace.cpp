@@ -0,0 +1,491 @@
+/*!
+ * @header      CPUTrace.cpp
+ * @author      Dirk W. Hoffmann, www.dirkwhoffmann.de
+ * @copyright   Dirk W. Hoffmann. All rights reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "CPUTrace.h"
+#include "FileBackend.h"
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+static const uint8_t magicBytes[] = { 'V', 'C', '6', '4', 'C', 'P', 'U', 0x01 };
+
+/* Layout of a record
+ *
+ *   Byte 0, bits 0-1 : CPU (TRACE_C64, TRACE_DRIVE1, TRACE_DRIVE2)
+ *                      3 marks the start of a block
+ *           bit 2    : Program counter follows (no sequential execution)
+ *           bit 3    : Memory access follows (address, data)
+ *           bit 4    : Register mask follows (A, X, Y, SP, P)
+ *           bits 5-7 : Cycle delta (7 = delta - 7 follows as varint)
+ *
+ * The instruction bytes are always stored. The changed registers follow the
+ * register mask in the order of the mask bits.
+ */
+#define TRACE_BLOCK   0x03
+#define TRACE_PC      0x04
+#define TRACE_MEM     0x08
+#define TRACE_REGS    0x10
+
+//
+// Recording
+//
+
+CPUTrace::CPUTrace()
+{
+    setDescription("CPUTrace");
+    memset(length, 1, sizeof(length));
+    memset(prev, 0, sizeof(prev));
+    memset(lastCycle, 0, sizeof(lastCycle));
+}
+
+CPUTrace::~CPUTrace()
+{
+    stopRecording();
+}
+
+void
+CPUTrace::dump()
+{
+    msg("CPUTrace:\n");
+    msg("---------\n\n");
+    msg("     Recording : %s\n", isRecording() ? "yes" : "no");
+    msg("  Instructions : %lld\n", count);
+    msg("     Data size : %zu bytes\n", getDataSize());
+    msg("        Blocks : %zu\n", index.size());
+    if (count) {
+        msg("  Bytes/instr. : %.2f\n", (double)getDataSize() / count);
+    }
+    msg("\n");
+}
+
+bool
+CPUTrace::startRecording(const char *path, const uint8_t *lengths)
+{
+    assert(path != NULL);
+    assert(lengths != NULL);
+    
+    stopRecording();
+    
+    if (capacity < dataOffset + blockSize + maxRecordSize + 1) {
+        warn("Capacity of %zu bytes is too small for a trace file\n", capacity);
+        return false;
+    }
+    
+    if ((fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644)) < 0) {
+        warn("Cannot create trace file %s\n", path);
+        return false;
+    }
+    
+    if (!resize(MIN(capacity, chunkSize))) {
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+    
+    CPUTraceHeader *header = (CPUTraceHeader *)map;
+    memset(header, 0, sizeof(CPUTraceHeader));
+    memcpy(header->magic, magicBytes, sizeof(magicBytes));
+    memcpy(header->length, lengths, sizeof(header->length));
+    memcpy(length, lengths, sizeof(length));
+    
+    index.clear();
+    memset(prev, 0, sizeof(prev));
+    memset(lastCycle, 0, sizeof(lastCycle));
+    count = 0;
+    
+    // The first record opens the first block
+    ptr = blockEnd = map + dataOffset;
+    
+    debug(1, "Recording CPU trace to %s\n", path);
+    return true;
+}
+
+void
+CPUTrace::stopRecording()
+{
+    if (!isRecording()) return;
+    
+    size_t used = map ? ptr - map : 0;
+    size_t indexSize = index.size() * sizeof(CPUTraceBlock);
+    
+    // Append the block index
+    if (map && used + indexSize > mapSize) resize(used + indexSize);
+    if (map) {
+        
+        CPUTraceHeader *header = (CPUTraceHeader *)map;
+        memcpy(map + used, index.data(), indexSize);
+        header->dataSize = used - dataOffset;
+        header->indexOffset = used;
+        header->indexCount = index.size();
+        munmap(map, mapSize);
+        
+        if (ftruncate(fd, used + indexSize) != 0) {
+            warn("Cannot truncate trace file\n");
+        }
+        debug(1, "CPU trace: %lld instructions in %zu bytes\n", count, used - dataOffset);
+    }
+    ::close(fd);
+    
+    fd = -1;
+    map = ptr = blockEnd = NULL;
+    mapSize = 0;
+}
+
+bool
+CPUTrace::resize(size_t size)
+{
+    size_t offset = ptr ? ptr - map : 0;
+    size_t remaining = ptr ? blockEnd - ptr : 0;
+    
+    if (map) munmap(map, mapSize);
+    map = ptr = blockEnd = NULL;
+    mapSize = 0;
+    
+    if (ftruncate(fd, size) != 0) {
+        warn("Cannot resize trace file to %zu bytes\n", size);
+        return false;
+    }
+    
+    void *addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        warn("Cannot map trace file into memory\n");
+        return false;
+    }
+    
+    map = (uint8_t *)addr;
+    mapSize = size;
+    if (offset) {
+        ptr = map + offset;
+        blockEnd = ptr + remaining;
+    }
+    return true;
+}
+
+void
+CPUTrace::startBlock()
+{
+    if (!isRecording()) return;
+    
+    size_t used = ptr - map;
+    size_t needed = used + 1 + blockSize + maxRecordSize;
+    
+    // Make the completed blocks visible to readers
+    ((CPUTraceHeader *)map)->dataSize = used - dataOffset;
+    
+    if (needed > mapSize) {
+        
+        if (needed > capacity) {
+            warn("CPU trace is full (%zu bytes). Recording stopped.\n", used);
+            stopRecording();
+            return;
+        }
+        if (!resize(MIN(capacity, MAX(needed, mapSize + chunkSize)))) {
+            stopRecording();
+            return;
+        }
+    }
+    
+    CPUTraceBlock block = { used, { lastCycle[0], lastCycle[1], lastCycle[2] } };
+    index.push_back(block);
+    
+    *ptr++ = TRACE_BLOCK;
+    blockEnd = ptr + blockSize;
+    memset(prev, 0, sizeof(prev));
+}
+
+void
+CPUTrace::encode(uint8_t source, const RecordedInstruction &instr,
+                 uint16_t addr, uint8_t data)
+{
+    assert(source < 3);
+    
+    TracedInstruction &p = prev[source];
+    
+    // Cycle deltas are unsigned. Restart the encoding if the cycle counter
+    // has been reset.
+    if (instr.cycle < p.instr.cycle) {
+        startBlock();
+        if (!isRecording()) return;
+    }
+    
+    uint64_t delta = instr.cycle - p.instr.cycle;
+    uint16_t predicted = p.instr.pc + length[p.instr.byte1];
+    
+    uint8_t regs =
+    (instr.a != p.instr.a ? 0x01 : 0) |
+    (instr.x != p.instr.x ? 0x02 : 0) |
+    (instr.y != p.instr.y ? 0x04 : 0) |
+    (instr.sp != p.instr.sp ? 0x08 : 0) |
+    (instr.flags != p.instr.flags ? 0x10 : 0);
+    
+    bool pcJump = instr.pc != predicted;
+    bool memChange = addr != p.addr || data != p.data;
+    
+    uint8_t *w = ptr;
+    *w++ = source |
+    (pcJump ? TRACE_PC : 0) |
+    (memChange ? TRACE_MEM : 0) |
+    (regs ? TRACE_REGS : 0) |
+    (uint8_t)(MIN(delta, 7) << 5);
+    
+    if (delta >= 7) {
+        for (delta -= 7; delta >= 0x80; delta >>= 7) {
+            *w++ = (uint8_t)(delta & 0x7F) | 0x80;
+        }
+        *w++ = (uint8_t)delta;
+    }
+    if (pcJump) {
+        *w++ = LO_BYTE(instr.pc);
+        *w++ = HI_BYTE(instr.pc);
+    }
+    
+    *w++ = instr.byte1;
+    if (length[instr.byte1] > 1) *w++ = instr.byte2;
+    if (length[instr.byte1] > 2) *w++ = instr.byte3;
+    
+    if (regs) {
+        *w++ = regs;
+        if (regs & 0x01) *w++ = instr.a;
+        if (regs & 0x02) *w++ = instr.x;
+        if (regs & 0x04) *w++ = instr.y;
+        if (regs & 0x08) *w++ = instr.sp;
+        if (regs & 0x10) *w++ = instr.flags;
+    }
+    if (memChange) {
+        *w++ = LO_BYTE(addr);
+        *w++ = HI_BYTE(addr);
+        *w++ = data;
+    }
+    
+    ptr = w;
+    p.instr = instr;
+    p.addr = addr;
+    p.data = data;
+    lastCycle[source] = instr.cycle;
+    count++;
+}
+
+
+//
+// Reading
+//
+
+CPUTraceReader::CPUTraceReader()
+{
+    setDescription("CPUTraceReader");
+    memset(&header, 0, sizeof(header));
+    memset(prev, 0, sizeof(prev));
+}
+
+CPUTraceReader::~CPUTraceReader()
+{
+    close();
+}
+
+bool
+CPUTraceReader::open(const char *path)
+{
+    assert(path != NULL);
+    
+    close();
+    
+    if ((file = FileBackend::makeWithFile(path)) == NULL) {
+        warn("Cannot open trace file %s\n", path);
+        return false;
+    }
+    
+    size_t size = file->getSize();
+    if (size < CPUTrace::dataOffset ||
+        memcmp(file->getData(), magicBytes, sizeof(magicBytes)) != 0) {
+        warn("%s is not a CPU trace file\n", path);
+        close();
+        return false;
+    }
+    
+    memcpy(&header, file->getData(), sizeof(header));
+    
+    size_t dataSize = MIN(header.dataSize, size - CPUTrace::dataOffset);
+    data = file->getData() + CPUTrace::dataOffset;
+    end = data + dataSize;
+    
+    size_t indexSize = header.indexCount * sizeof(CPUTraceBlock);
+    if (header.indexCount &&
+        header.indexOffset >= CPUTrace::dataOffset &&
+        header.indexOffset + indexSize <= size) {
+        
+        index.resize(header.indexCount);
+        memcpy(index.data(), file->getData() + header.indexOffset, indexSize);
+        
+    } else {
+        
+        debug(1, "%s has no index (incomplete recording?)\n", path);
+        rebuildIndex();
+    }
+    
+    rewind();
+    return true;
+}
+
+void
+CPUTraceReader::close()
+{
+    delete file;
+    file = NULL;
+    data = end = ptr = NULL;
+    index.clear();
+    hasPending = false;
+}
+
+void
+CPUTraceReader::rebuildIndex()
+{
+    uint64_t lastCycle[3] = { 0, 0, 0 };
+    TracedInstruction instr;
+    
+    index.clear();
+    ptr = data;
+    
+    while (ptr < end) {
+        
+        if ((*ptr & 0x03) == TRACE_BLOCK) {
+            
+            CPUTraceBlock block = {
+                (uint64_t)(ptr - data) + CPUTrace::dataOffset,
+                { lastCycle[0], lastCycle[1], lastCycle[2] } };
+            index.push_back(block);
+            memset(prev, 0, sizeof(prev));
+            ptr++;
+            continue;
+        }
+        
+        decode(&instr);
+        lastCycle[instr.source] = instr.instr.cycle;
+    }
+}
+
+void
+CPUTraceReader::seekBlock(size_t nr)
+{
+    ptr = nr < index.size() ? data + (index[nr].offset - CPUTrace::dataOffset) : data;
+    memset(prev, 0, sizeof(prev));
+    hasPending = false;
+}
+
+bool
+CPUTraceReader::seek(uint8_t source, uint64_t cycle)
+{
+    assert(source < 3);
+    
+    // Find the last block starting before the requested cycle
+    size_t lo = 0, hi = index.size();
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (index[mid].cycle[source] < cycle) lo = mid + 1; else hi = mid;
+    }
+    seekBlock(lo ? lo - 1 : 0);
+    
+    while (next(&pending)) {
+        
+        if (pending.source == source && pending.instr.cycle >= cycle) {
+            hasPending = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool
+CPUTraceReader::next(TracedInstruction *result)
+{
+    assert(result != NULL);
+    
+    if (hasPending) {
+        *result = pending;
+        hasPending = false;
+        return true;
+    }
+    
+    while (ptr < end) {
+        
+        if ((*ptr & 0x03) == TRACE_BLOCK) {
+            memset(prev, 0, sizeof(prev));
+            ptr++;
+            continue;
+        }
+        
+        decode(result);
+        return true;
+    }
+    return false;
+}
+
+void
+CPUTraceReader::decode(TracedInstruction *result)
+{
+    uint8_t flags = *ptr++;
+    uint8_t source = flags & 0x03;
+    TracedInstruction &p = prev[source];
+    
+    assert(source < 3);
+    
+    // Start with the values of the previous instruction
+    *result = p;
+    result->source = source;
+    
+    uint64_t delta = flags >> 5;
+    if (delta == 7) {
+        uint64_t value = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            uint8_t byte = *ptr++;
+            value |= (uint64_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) break;
+        }
+        delta += value;
+    }
+    result->instr.cycle += delta;
+    
+    if (flags & TRACE_PC) {
+        result->instr.pc = LO_HI(ptr[0], ptr[1]);
+        ptr += 2;
+    } else {
+        result->instr.pc = p.instr.pc + header.length[p.instr.byte1];
+    }
+    
+    uint8_t length = header.length[*ptr];
+    result->instr.byte1 = *ptr++;
+    result->instr.byte2 = length > 1 ? *ptr++ : 0;
+    result->instr.byte3 = length > 2 ? *ptr++ : 0;
+    
+    if (flags & TRACE_REGS) {
+        uint8_t regs = *ptr++;
+        if (regs & 0x01) result->instr.a = *ptr++;
+        if (regs & 0x02) result->instr.x = *ptr++;
+        if (regs & 0x04) result->instr.y = *ptr++;
+        if (regs & 0x08) result->instr.sp = *ptr++;
+        if (regs & 0x10) result->instr.flags = *ptr++;
+    }
+    if (flags & TRACE_MEM) {
+        result->addr = LO_HI(ptr[0], ptr[1]);
+        result->data = ptr[2];
+        ptr += 3;
+    }
+    
+    p = *result;
+}
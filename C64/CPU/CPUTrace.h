@@ -0,0 +1,283 @@
+/*!
+ * @header      CPUTrace.h
+ * @author      Dirk W. Hoffmann, www.dirkwhoffmann.de
+ * @copyright   Dirk W. Hoffmann. All rights reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _CPUTRACE_INC
+#define _CPUTRACE_INC
+
+#include "VC64Object.h"
+#include "CPU_types.h"
+#include <vector>
+
+class FileBackend;
+
+//! @brief    CPUs that can be recorded in a CPU trace
+#define TRACE_C64    0
+#define TRACE_DRIVE1 1
+#define TRACE_DRIVE2 2
+
+//! @brief    An instruction stored in a CPU trace
+typedef struct {
+    
+    //! @brief    CPU that executed the instruction (TRACE_C64, ...)
+    uint8_t source;
+    
+    //! @brief    Cycle, program counter, instruction bytes, and registers
+    RecordedInstruction instr;
+    
+    /*! @brief    Last memory access of the preceding instruction
+     *  @details  Contents of the CPU's address latch and data buffer when the
+     *            opcode was fetched. For instructions accessing memory, this
+     *            is the effective address and the value read or written.
+     */
+    uint16_t addr;
+    uint8_t data;
+    
+} TracedInstruction;
+
+//! @brief    Start of a block in a CPU trace file
+typedef struct {
+    
+    //! @brief    File offset of the block
+    uint64_t offset;
+    
+    //! @brief    Cycle of the last instruction recorded before the block
+    uint64_t cycle[3];
+    
+} CPUTraceBlock;
+
+//! @brief    Header of a CPU trace file
+typedef struct {
+    
+    uint8_t magic[8];
+    
+    //! @brief    Length of each instruction in bytes
+    uint8_t length[256];
+    
+    //! @brief    Number of valid bytes in the data area
+    uint64_t dataSize;
+    
+    //! @brief    Location and size of the block index (0 if incomplete)
+    uint64_t indexOffset;
+    uint64_t indexCount;
+    
+} CPUTraceHeader;
+
+/*! @brief    Streams executed instructions into a memory-mapped file
+ *  @details  Unlike the trace buffer of the CPU, which keeps the most recent
+ *            instructions only, this trace records all instructions executed
+ *            by the C64 CPU and the drive CPUs for long periods of time.
+ *
+ *            Each instruction is stored relative to the previous instruction
+ *            of the same CPU. The first byte tells which CPU executed the
+ *            instruction, which fields have changed, and small cycle deltas.
+ *            It is followed by the changed fields and the instruction bytes.
+ *            A typical instruction occupies four to eight bytes.
+ *
+ *            Every 64 KB, the delta encoding restarts and a block is added
+ *            to an index which is appended to the file when recording stops.
+ *            The readable part of the data area is kept up to date in the
+ *            file header at each block boundary. Hence, a file left behind
+ *            by a crashed process can still be read up to its last block.
+ */
+class CPUTrace : public VC64Object {
+    
+    public:
+    
+    //! @brief    Offset of the first data byte in a trace file
+    static const size_t dataOffset = 512;
+    
+    private:
+    
+    //! @brief    Number of data bytes after which the delta encoding restarts
+    static const size_t blockSize = 64 * 1024;
+    
+    //! @brief    Amount by which the file grows if more space is needed
+    static const size_t chunkSize = 64 * 1024 * 1024;
+    
+    //! @brief    Maximum number of bytes written by a single record
+    static const size_t maxRecordSize = 32;
+    
+    //! @brief    File descriptor of the trace file (-1 if not recording)
+    int fd = -1;
+    
+    //! @brief    Start address and size of the memory mapping
+    uint8_t *map = NULL;
+    size_t mapSize = 0;
+    
+    //! @brief    Write pointer and end of the current block
+    uint8_t *ptr = NULL;
+    uint8_t *blockEnd = NULL;
+    
+    //! @brief    Maximum file size
+    size_t capacity = (size_t)4 << 30;
+    
+    //! @brief    Instruction lengths
+    uint8_t length[256];
+    
+    //! @brief    The block index
+    std::vector<CPUTraceBlock> index;
+    
+    //! @brief    Last recorded instruction of each CPU (delta encoding)
+    TracedInstruction prev[3];
+    
+    //! @brief    Cycle of the last recorded instruction of each CPU
+    uint64_t lastCycle[3];
+    
+    //! @brief    Number of recorded instructions
+    uint64_t count = 0;
+    
+    public:
+    
+    //! @brief    Constructor
+    CPUTrace();
+    
+    //! @brief    Destructor
+    ~CPUTrace();
+    
+    //! @brief    Prints the recording statistics
+    void dump();
+    
+    
+    //
+    //! @functiongroup Recording
+    //
+    
+    bool isRecording() { return fd >= 0; }
+    
+    /*! @brief    Creates a trace file and starts recording
+     *  @param    lengths    Length of each instruction (stored in the file)
+     */
+    bool startRecording(const char *path, const uint8_t *lengths);
+    
+    //! @brief    Writes the block index and closes the trace file
+    void stopRecording();
+    
+    //! @brief    Sets the maximum size of a trace file in bytes
+    void setCapacity(size_t value) { capacity = value; }
+    
+    //! @brief    Returns the number of recorded instructions
+    uint64_t getCount() { return count; }
+    
+    //! @brief    Returns the number of bytes written to the data area
+    size_t getDataSize() { return map ? ptr - map - dataOffset : 0; }
+    
+    /*! @brief    Records an instruction
+     *  @details  Called by the CPU in the fetch phase of each instruction.
+     *            The function is not thread-safe. All CPUs writing into the
+     *            same trace must be executed by the same thread.
+     *  @see      DriveScheduler::setSerialized
+     */
+    void record(uint8_t source, const RecordedInstruction &instr,
+                uint16_t addr, uint8_t data) {
+        if (ptr >= blockEnd) startBlock();
+        if (ptr) encode(source, instr, addr, data);
+    }
+    
+    private:
+    
+    //! @brief    Encodes an instruction and advances the write pointer
+    void encode(uint8_t source, const RecordedInstruction &instr,
+                uint16_t addr, uint8_t data);
+    
+    //! @brief    Restarts the delta encoding
+    void startBlock();
+    
+    //! @brief    Resizes the trace file and its memory mapping
+    bool resize(size_t size);
+};
+
+/*! @brief    Random access to a recorded CPU trace
+ *  @details  The reader maps the trace file into memory. Instructions are
+ *            decoded sequentially, starting at a block boundary. If the file
+ *            has no block index (e.g., because the recording process was
+ *            killed), the index is rebuilt by decoding the whole file.
+ */
+class CPUTraceReader : public VC64Object {
+    
+    //! @brief    Contents of the trace file
+    FileBackend *file = NULL;
+    
+    //! @brief    Header of the trace file
+    CPUTraceHeader header;
+    
+    //! @brief    Start and end of the data area
+    const uint8_t *data = NULL;
+    const uint8_t *end = NULL;
+    
+    //! @brief    The block index
+    std::vector<CPUTraceBlock> index;
+    
+    //! @brief    Read pointer
+    const uint8_t *ptr = NULL;
+    
+    //! @brief    Last decoded instruction of each CPU (delta decoding)
+    TracedInstruction prev[3];
+    
+    //! @brief    Instruction found by seek(), returned by the next call to next()
+    TracedInstruction pending;
+    bool hasPending = false;
+    
+    public:
+    
+    //! @brief    Constructor
+    CPUTraceReader();
+    
+    //! @brief    Destructor
+    ~CPUTraceReader();
+    
+    //! @brief    Opens a trace file and moves to the first instruction
+    bool open(const char *path);
+    
+    //! @brief    Closes the trace file
+    void close();
+    
+    //! @brief    Returns the number of blocks
+    size_t numBlocks() { return index.size(); }
+    
+    //! @brief    Moves to the first instruction
+    void rewind() { seekBlock(0); }
+    
+    /*! @brief    Moves to the first instruction of a CPU executed in or
+     *            after the specified cycle
+     *  @details  The block is located by a binary search in the index.
+     *            Hence, the cycle counters are expected to increase. This is
+     *            not the case if the emulator was reset during recording.
+     *  @return   false, if no such instruction exists.
+     */
+    bool seek(uint8_t source, uint64_t cycle);
+    
+    /*! @brief    Decodes the instruction at the read pointer
+     *  @return   false, if the end of the trace has been reached.
+     */
+    bool next(TracedInstruction *result);
+    
+    private:
+    
+    //! @brief    Moves to the start of a block
+    void seekBlock(size_t nr);
+    
+    //! @brief    Decodes the instruction at the read pointer (no block marker)
+    void decode(TracedInstruction *result);
+    
+    //! @brief    Decodes the whole data area to rebuild the block index
+    void rebuildIndex();
+};
+
+#endif
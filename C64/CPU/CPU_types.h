@@ -55,17 +55,22 @@ typedef enum {
  *            following breakpoint types:
  *            HARD_BREAKPOINT : Execution is halted.
  *            SOFT_BREAKPOINT : Execution is halted and the tag is deleted.
+ *            CONDITIONAL_BREAKPOINT : Execution is halted if the attached
+ *                                     condition evaluates to true.
  */
 typedef enum {
-    NO_BREAKPOINT   = 0x00,
-    HARD_BREAKPOINT = 0x01,
-    SOFT_BREAKPOINT = 0x02
+    NO_BREAKPOINT          = 0x00,
+    HARD_BREAKPOINT        = 0x01,
+    SOFT_BREAKPOINT        = 0x02,
+    CONDITIONAL_BREAKPOINT = 0x04
 } Breakpoint;
 
 
 /*! @brief    Error state of the virtual CPU
  *  @details  CPU_OK indicates normal operation. When a (soft or hard)
  *            breakpoint is reached, state CPU_BREAKPOINT_REACHED is entered.
+ *            CPU_WATCHPOINT_REACHED is set when a watched memory cell has
+ *            been accessed.
  *            CPU_ILLEGAL_INSTRUCTION is set when an opcode is not understood
  *            by the CPU. Once the CPU enters a different state than CPU_OK,
  *            the execution thread is terminated.
@@ -74,7 +79,8 @@ typedef enum {
     CPU_OK = 0,
     CPU_SOFT_BREAKPOINT_REACHED,
     CPU_HARD_BREAKPOINT_REACHED,
-    CPU_ILLEGAL_INSTRUCTION
+    CPU_ILLEGAL_INSTRUCTION,
+    CPU_WATCHPOINT_REACHED
 } ErrorState;
 
 /*! @brief    CPU info
@@ -110,6 +116,18 @@ typedef struct {
     uint8_t flags;
 } RecordedInstruction;
 
+/*! @brief    Decoded instruction
+ *  @details  Structured form produced by the batch disassembler. For
+ *            relative branches, the operand is the branch target.
+ */
+typedef struct {
+    uint16_t addr;
+    uint8_t opcode;
+    uint8_t length;
+    uint16_t operand;
+    AddressingMode mode;
+} DecodedInstruction;
+
 //! @brief    Disassembled instruction
 typedef struct {
     uint64_t cycle;
@@ -0,0 +1,293 @@
+/*!
+ * @header      Condition.cpp
+ * @author      Dirk W. Hoffmann, www.dirkwhoffmann.de
+ * @copyright   Dirk W. Hoffmann. All rights reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "Condition.h"
+#include "Memory.h"
+#include <ctype.h>
+
+bool
+Condition::compile(const char *expression)
+{
+    code.clear();
+    source = expression ? expression : "";
+    pos = source.c_str();
+    depth = maxUsed = 0;
+    error = false;
+    
+    skipSpace();
+    if (*pos != 0) {
+        parseOr();
+        skipSpace();
+        if (*pos != 0) error = true;
+    }
+    
+    if (error || maxUsed > maxDepth) {
+        code.clear();
+        return false;
+    }
+    return true;
+}
+
+void
+Condition::emit(Opcode op, int32_t arg)
+{
+    code.push_back(Instruction { op, arg });
+    
+    // Keep track of the stack depth
+    if (op <= OP_FLAG) {
+        depth++;
+    } else if (op >= OP_MUL) {
+        depth--;
+    }
+    maxUsed = MAX(maxUsed, depth);
+}
+
+void
+Condition::skipSpace()
+{
+    while (isspace(*pos)) pos++;
+}
+
+bool
+Condition::accept(const char *token)
+{
+    skipSpace();
+    size_t len = strlen(token);
+    if (strncmp(pos, token, len) != 0) return false;
+    pos += len;
+    return true;
+}
+
+bool
+Condition::acceptWord(const char *word)
+{
+    skipSpace();
+    size_t len = strlen(word);
+    if (strncasecmp(pos, word, len) != 0 || isalnum(pos[len]) || pos[len] == '_')
+        return false;
+    pos += len;
+    return true;
+}
+
+void
+Condition::parseOr()
+{
+    parseAnd();
+    while (!error && accept("||")) { parseAnd(); emit(OP_LOR); }
+}
+
+void
+Condition::parseAnd()
+{
+    parseCompare();
+    while (!error && accept("&&")) { parseCompare(); emit(OP_LAND); }
+}
+
+void
+Condition::parseCompare()
+{
+    parseSum();
+    
+    Opcode op;
+    if (accept("==")) op = OP_EQ;
+    else if (accept("!=")) op = OP_NE;
+    else if (accept("<=")) op = OP_LE;
+    else if (accept(">=")) op = OP_GE;
+    else if (accept("<")) op = OP_LT;
+    else if (accept(">")) op = OP_GT;
+    else return;
+    
+    parseSum();
+    emit(op);
+}
+
+void
+Condition::parseSum()
+{
+    parseProduct();
+    
+    while (!error) {
+        
+        Opcode op;
+        skipSpace();
+        if (pos[0] == '&' && pos[1] != '&') op = OP_AND;
+        else if (pos[0] == '|' && pos[1] != '|') op = OP_OR;
+        else if (pos[0] == '+') op = OP_ADD;
+        else if (pos[0] == '-') op = OP_SUB;
+        else if (pos[0] == '^') op = OP_XOR;
+        else return;
+        
+        pos++;
+        parseProduct();
+        emit(op);
+    }
+}
+
+void
+Condition::parseProduct()
+{
+    parseUnary();
+    
+    while (!error) {
+        
+        Opcode op;
+        if (accept("*")) op = OP_MUL;
+        else if (accept("/")) op = OP_DIV;
+        else if (accept("%")) op = OP_MOD;
+        else return;
+        
+        parseUnary();
+        emit(op);
+    }
+}
+
+void
+Condition::parseUnary()
+{
+    skipSpace();
+    
+    // '!' must not be confused with '!='
+    if (pos[0] == '!' && pos[1] != '=') { pos++; parseUnary(); emit(OP_NOT); return; }
+    if (accept("~")) { parseUnary(); emit(OP_INV); return; }
+    if (accept("-")) { parseUnary(); emit(OP_NEG); return; }
+    
+    parsePrimary();
+}
+
+void
+Condition::parsePrimary()
+{
+    static const struct { const char *name; Opcode op; int32_t arg; } words[] = {
+        { "ADDR",  OP_ADDR,   0 },
+        { "VALUE", OP_VALUE,  0 },
+        { "PC",    OP_REG_PC, 0 },
+        { "SP",    OP_REG_SP, 0 },
+        { "A",     OP_REG_A,  0 },
+        { "X",     OP_REG_X,  0 },
+        { "Y",     OP_REG_Y,  0 },
+        { "P",     OP_REG_P,  0 },
+        { "N",     OP_FLAG,   0x80 },
+        { "V",     OP_FLAG,   0x40 },
+        { "B",     OP_FLAG,   0x10 },
+        { "D",     OP_FLAG,   0x08 },
+        { "I",     OP_FLAG,   0x04 },
+        { "Z",     OP_FLAG,   0x02 },
+        { "C",     OP_FLAG,   0x01 },
+        { NULL,    OP_CONST,  0 }
+    };
+    
+    if (error) return;
+    skipSpace();
+    
+    // Parenthesized expression
+    if (accept("(")) {
+        parseOr();
+        if (!accept(")")) error = true;
+        return;
+    }
+    
+    // Memory cell
+    if (accept("[")) {
+        parseOr();
+        if (!accept("]")) error = true;
+        emit(OP_PEEK);
+        return;
+    }
+    
+    // Numbers
+    int base = 10;
+    if (*pos == '$') { base = 16; pos++; }
+    else if (*pos == '%') { base = 2; pos++; }
+    if (base != 10 || isdigit(*pos)) {
+        char *end;
+        long value = strtol(pos, &end, base);
+        if (end == pos) { error = true; return; }
+        pos = end;
+        emit(OP_CONST, (int32_t)value);
+        return;
+    }
+    
+    // Registers and flags
+    for (unsigned i = 0; words[i].name != NULL; i++) {
+        if (acceptWord(words[i].name)) {
+            emit(words[i].op, words[i].arg);
+            return;
+        }
+    }
+    
+    error = true;
+}
+
+bool
+Condition::eval(const ConditionContext &ctx, Memory *mem) const
+{
+    int32_t stack[maxDepth];
+    int sp = -1;
+    
+    for (const Instruction &instr : code) {
+        
+        switch (instr.op) {
+                
+            case OP_CONST:  stack[++sp] = instr.arg; break;
+            case OP_REG_A:  stack[++sp] = ctx.a; break;
+            case OP_REG_X:  stack[++sp] = ctx.x; break;
+            case OP_REG_Y:  stack[++sp] = ctx.y; break;
+            case OP_REG_SP: stack[++sp] = ctx.sp; break;
+            case OP_REG_P:  stack[++sp] = ctx.p; break;
+            case OP_REG_PC: stack[++sp] = ctx.pc; break;
+            case OP_ADDR:   stack[++sp] = ctx.addr; break;
+            case OP_VALUE:  stack[++sp] = ctx.value; break;
+            case OP_FLAG:   stack[++sp] = (ctx.p & instr.arg) != 0; break;
+                
+            case OP_PEEK:   stack[sp] = mem->spypeek((uint16_t)stack[sp]); break;
+            case OP_NOT:    stack[sp] = !stack[sp]; break;
+            case OP_INV:    stack[sp] = ~stack[sp]; break;
+            case OP_NEG:    stack[sp] = -stack[sp]; break;
+                
+            default:
+            {
+                int32_t r = stack[sp--];
+                int32_t &l = stack[sp];
+                
+                switch (instr.op) {
+                    case OP_MUL:  l = l * r; break;
+                    case OP_DIV:  l = r ? l / r : 0; break;
+                    case OP_MOD:  l = r ? l % r : 0; break;
+                    case OP_ADD:  l = l + r; break;
+                    case OP_SUB:  l = l - r; break;
+                    case OP_AND:  l = l & r; break;
+                    case OP_OR:   l = l | r; break;
+                    case OP_XOR:  l = l ^ r; break;
+                    case OP_EQ:   l = l == r; break;
+                    case OP_NE:   l = l != r; break;
+                    case OP_LT:   l = l < r; break;
+                    case OP_LE:   l = l <= r; break;
+                    case OP_GT:   l = l > r; break;
+                    case OP_GE:   l = l >= r; break;
+                    case OP_LAND: l = l && r; break;
+                    case OP_LOR:  l = l || r; break;
+                    default:      assert(false);
+                }
+            }
+        }
+    }
+    
+    return sp < 0 || stack[sp] != 0;
+}
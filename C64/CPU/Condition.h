@@ -0,0 +1,131 @@
+/*!
+ * @header      Condition.h
+ * @author      Dirk W. Hoffmann, www.dirkwhoffmann.de
+ * @copyright   Dirk W. Hoffmann. All rights reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _CONDITION_INC
+#define _CONDITION_INC
+
+#include "basic.h"
+#include <vector>
+#include <string>
+
+class Memory;
+
+//! @brief    Values a condition can refer to
+typedef struct {
+    uint8_t a;
+    uint8_t x;
+    uint8_t y;
+    uint8_t sp;
+    uint8_t p;
+    uint16_t pc;
+    
+    //! @brief    Accessed address (watchpoints only)
+    uint16_t addr;
+    
+    //! @brief    Read or written value (watchpoints only)
+    uint8_t value;
+} ConditionContext;
+
+/*! @brief    A predicate attached to a breakpoint or watchpoint
+ *  @details  The predicate is given as a C-like expression which is compiled
+ *            into a small stack-based bytecode once. Evaluating the bytecode
+ *            is cheap and doesn't cause any side effects.
+ *
+ *            Operands:
+ *              $D012, %1010, 42   Hexadecimal, binary, and decimal numbers
+ *              A X Y SP P PC      CPU registers
+ *              N V B D I Z C      Processor flags (0 or 1)
+ *              ADDR VALUE         Accessed address and value (watchpoints)
+ *              [expr]             Memory byte (read without side effects)
+ *
+ *            Operators (by increasing precedence):
+ *              ||  &&  == != < <= > >=  + - & | ^  * / %  ! ~ - (unary)
+ *
+ *            Example: "A == $20 && [$D012] >= 100"
+ *            The empty condition is always true.
+ */
+class Condition {
+    
+    public:
+    
+    typedef enum : uint8_t {
+        OP_CONST, OP_REG_A, OP_REG_X, OP_REG_Y, OP_REG_SP, OP_REG_P, OP_REG_PC,
+        OP_ADDR, OP_VALUE, OP_FLAG, OP_PEEK,
+        OP_NOT, OP_INV, OP_NEG,
+        OP_MUL, OP_DIV, OP_MOD, OP_ADD, OP_SUB, OP_AND, OP_OR, OP_XOR,
+        OP_EQ, OP_NE, OP_LT, OP_LE, OP_GT, OP_GE, OP_LAND, OP_LOR
+    } Opcode;
+    
+    typedef struct {
+        Opcode op;
+        int32_t arg;
+    } Instruction;
+    
+    //! @brief    Maximum evaluation stack depth
+    static const unsigned maxDepth = 32;
+    
+    private:
+    
+    //! @brief    Source text (for display)
+    std::string source;
+    
+    //! @brief    Compiled program
+    std::vector<Instruction> code;
+    
+    //! @brief    Parser state
+    const char *pos = NULL;
+    unsigned depth = 0;
+    unsigned maxUsed = 0;
+    bool error = false;
+    
+    public:
+    
+    //! @brief    Compiles an expression. Returns false on syntax errors.
+    bool compile(const char *expression);
+    
+    //! @brief    Returns the expression this condition was compiled from
+    const char *getSource() const { return source.c_str(); }
+    
+    //! @brief    Returns true if no predicate has been compiled
+    bool isEmpty() const { return code.empty(); }
+    
+    //! @brief    Returns the number of bytecode instructions
+    size_t size() const { return code.size(); }
+    
+    //! @brief    Evaluates the condition
+    bool eval(const ConditionContext &ctx, Memory *mem) const;
+    
+    private:
+    
+    void emit(Opcode op, int32_t arg = 0);
+    void skipSpace();
+    bool accept(const char *token);
+    bool acceptWord(const char *word);
+    
+    void parseOr();
+    void parseAnd();
+    void parseCompare();
+    void parseSum();
+    void parseProduct();
+    void parseUnary();
+    void parsePrimary();
+};
+
+#endif
@@ -0,0 +1,160 @@
+/*!
+ * @header      Disassembler.cpp
+ * @author      Dirk W. Hoffmann, www.dirkwhoffmann.de
+ * @copyright   Dirk W. Hoffmann. All rights reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "C64.h"
+
+Disassembler::Disassembler(CPU *cpu)
+{
+    setDescription("Disassembler");
+    this->cpu = cpu;
+    memset(cache, 0, sizeof(cache));
+}
+
+Disassembler::~Disassembler()
+{
+    for (unsigned i = 0; i < 256; i++) {
+        delete cache[i];
+    }
+}
+
+void
+Disassembler::dump()
+{
+    unsigned cached = 0;
+    for (unsigned i = 0; i < 256; i++) {
+        if (cache[i] && cache[i]->signature) cached++;
+    }
+    
+    msg("Disassembler:\n");
+    msg("-------------\n\n");
+    msg("  Cached pages : %d\n", cached);
+    msg("          Hits : %lld\n", hits);
+    msg("        Misses : %lld\n\n", misses);
+}
+
+void
+Disassembler::invalidate()
+{
+    for (unsigned i = 0; i < 256; i++) {
+        if (cache[i]) cache[i]->signature = 0;
+    }
+}
+
+size_t
+Disassembler::disassemble(uint16_t addr, size_t count, DecodedInstruction *buffer)
+{
+    const DecodedInstruction *page = getPage(addr >> 8);
+    
+    for (size_t i = 0; i < count; i++) {
+        
+        buffer[i] = page[addr & 0xFF];
+        
+        uint16_t next = addr + buffer[i].length;
+        if ((next ^ addr) & 0xFF00) page = getPage(next >> 8);
+        addr = next;
+    }
+    return count;
+}
+
+size_t
+Disassembler::disassembleRange(uint16_t from, uint16_t to,
+                               std::vector<DecodedInstruction> &result)
+{
+    size_t count = 0;
+    uint32_t end = to >= from ? to : to + 0x10000;
+    uint8_t current = from >> 8;
+    const DecodedInstruction *page = getPage(current);
+    
+    for (uint32_t addr = from; addr <= end; addr += page[addr & 0xFF].length) {
+        
+        if (((addr >> 8) & 0xFF) != current) {
+            current = (addr >> 8) & 0xFF;
+            page = getPage(current);
+        }
+        result.push_back(page[addr & 0xFF]);
+        count++;
+    }
+    return count;
+}
+
+const DecodedInstruction *
+Disassembler::getPage(uint8_t page)
+{
+    uint64_t signature = cpu->mem->pageSignature(page);
+    uint64_t nextSignature = cpu->mem->pageSignature(page + 1);
+    
+    // Pages with changing contents are decoded on each access
+    if (signature == 0 || nextSignature == 0) {
+        decodePage(page, &scratch);
+        misses++;
+        return scratch.instr;
+    }
+    
+    if (!cache[page]) {
+        cache[page] = new CachedPage();
+    }
+    
+    CachedPage *entry = cache[page];
+    if (entry->signature != signature || entry->nextSignature != nextSignature) {
+        decodePage(page, entry);
+        entry->signature = signature;
+        entry->nextSignature = nextSignature;
+        misses++;
+    } else {
+        hits++;
+    }
+    return entry->instr;
+}
+
+void
+Disassembler::decodePage(uint8_t page, CachedPage *dest)
+{
+    uint8_t bytes[258];
+    uint16_t base = page << 8;
+    
+    for (unsigned i = 0; i < sizeof(bytes); i++) {
+        bytes[i] = cpu->mem->spypeek(base + i);
+    }
+    
+    for (unsigned i = 0; i < 256; i++) {
+        
+        DecodedInstruction &instr = dest->instr[i];
+        uint8_t opcode = bytes[i];
+        
+        instr.addr = base + i;
+        instr.opcode = opcode;
+        instr.mode = cpu->addressingMode[opcode];
+        instr.length = cpu->getLengthOfInstruction(opcode);
+        
+        switch (instr.length) {
+            case 2:
+                instr.operand = bytes[i + 1];
+                break;
+            case 3:
+                instr.operand = LO_HI(bytes[i + 1], bytes[i + 2]);
+                break;
+            default:
+                instr.operand = 0;
+        }
+        if (instr.mode == ADDR_RELATIVE) {
+            instr.operand = instr.addr + 2 + (int8_t)bytes[i + 1];
+        }
+    }
+}
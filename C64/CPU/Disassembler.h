@@ -0,0 +1,118 @@
+/*!
+ * @header      Disassembler.h
+ * @author      Dirk W. Hoffmann, www.dirkwhoffmann.de
+ * @copyright   Dirk W. Hoffmann. All rights reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _DISASSEMBLER_INC
+#define _DISASSEMBLER_INC
+
+#include "VC64Object.h"
+#include "CPU_types.h"
+#include <vector>
+
+class CPU;
+
+/*! @brief    Batch disassembler with a per-page cache
+ *  @details  For each memory page, the instructions starting at all 256
+ *            addresses are decoded at once. Hence, the cache can be used no
+ *            matter where a disassembly starts. A cached page is tagged with
+ *            the signatures of itself and the following page (instructions
+ *            may reach into it), as reported by Memory::pageSignature().
+ *            It is decoded again once one of the signatures changes, e.g.,
+ *            after a poke into the page or after a bank switch. Pages
+ *            without a signature (I/O space, cartridges) are never cached.
+ *            The cache is not thread-safe. Suspend the emulator before
+ *            disassembling from another thread.
+ */
+class Disassembler : public VC64Object {
+    
+    private:
+    
+    //! @brief    The CPU whose memory and opcode tables are used
+    CPU *cpu;
+    
+    //! @brief    Decoded instructions of a single page
+    typedef struct {
+        uint64_t signature;
+        uint64_t nextSignature;
+        DecodedInstruction instr[256];
+    } CachedPage;
+    
+    //! @brief    Page cache (entries are allocated on demand)
+    CachedPage *cache[256];
+    
+    //! @brief    Buffer for pages that cannot be cached
+    CachedPage scratch;
+    
+    //! @brief    Cache statistics
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    
+    public:
+    
+    //! @brief    Constructor
+    Disassembler(CPU *cpu);
+    
+    //! @brief    Destructor
+    ~Disassembler();
+    
+    //! @brief    Prints cache statistics
+    void dump();
+    
+    //! @brief    Discards all cached pages
+    void invalidate();
+    
+    
+    //
+    //! @functiongroup Disassembling
+    //
+    
+    //! @brief    Decodes the instruction at the specified address
+    DecodedInstruction decode(uint16_t addr) { return getPage(addr >> 8)[addr & 0xFF]; }
+    
+    /*! @brief    Decodes a sequence of instructions
+     *  @return   Number of decoded instructions (always count)
+     */
+    size_t disassemble(uint16_t addr, size_t count, DecodedInstruction *buffer);
+    
+    /*! @brief    Decodes all instructions starting between from and to
+     *  @details  Decoding starts at from and proceeds linearly. The results
+     *            are appended to the provided vector.
+     *  @return   Number of decoded instructions
+     */
+    size_t disassembleRange(uint16_t from, uint16_t to,
+                            std::vector<DecodedInstruction> &result);
+    
+    
+    //
+    //! @functiongroup Querying statistics
+    //
+    
+    uint64_t getHits() { return hits; }
+    uint64_t getMisses() { return misses; }
+    
+    private:
+    
+    //! @brief    Returns the decoded instructions of a page
+    const DecodedInstruction *getPage(uint8_t page);
+    
+    //! @brief    Decodes all instructions of a page
+    void decodePage(uint8_t page, CachedPage *dest);
+};
+
+#endif
@@ -138,6 +138,7 @@ Cartridge::isSupportedType(CartridgeType type)
         case CRT_FREEZE_FRAME:
         case CRT_KINGSOFT:
             
+        case CRT_REU:
         case CRT_ISEPIC:
         case CRT_GEO_RAM:
             return true;
@@ -176,6 +177,7 @@ Cartridge::makeWithType(C64 *c64, CartridgeType type)
         case CRT_ACTION_REPLAY3: return new ActionReplay3(c64);
         case CRT_FREEZE_FRAME:   return new FreezeFrame(c64);
         case CRT_KINGSOFT:       return new Kingsoft(c64);
+        case CRT_REU:            return new REU(c64);
         case CRT_ISEPIC:         return new Isepic(c64);
         case CRT_GEO_RAM:        return new GeoRAM(c64);
         
@@ -262,6 +264,19 @@ Cartridge::didSaveToBuffer(uint8_t **buffer)
     writeBlock(buffer, externalRam, ramCapacity);
 }
 
+uint64_t
+Cartridge::fingerprint()
+{
+    uint64_t hash = fingerprintItems(0xcbf29ce484222325);
+    
+    for (unsigned i = 0; i < numPackets; i++) {
+        assert(packet[i] != NULL);
+        hash = combineFingerprints(hash, packet[i]->fingerprint());
+    }
+    
+    return fnv_1a(externalRam, ramCapacity, hash);
+}
+
 void
 Cartridge::dump()
 {
@@ -314,6 +329,22 @@ Cartridge::peekRomH(uint16_t addr)
     return packet[chipH]->peek(addr + offsetH);
 }
 
+uint8_t *
+Cartridge::romPage(unsigned page)
+{
+    assert(isROMLaddr(page << 12) || isROMHaddr(page << 12));
+    
+    bool romL = isROMLaddr(page << 12);
+    uint8_t chip = romL ? chipL : chipH;
+    uint16_t mappedBytes = romL ? mappedBytesL : mappedBytesH;
+    uint16_t relAddr = (page & 1) ? 0x1000 : 0x0000;
+    
+    if (chip >= numPackets || packet[chip] == NULL) return NULL;
+    if (relAddr + 0x1000 > mappedBytes) return NULL;
+    
+    return packet[chip]->getData((romL ? offsetL : offsetH) + relAddr, 0x1000);
+}
+
 void
 Cartridge::poke(uint16_t addr, uint8_t value)
 {
@@ -331,6 +362,7 @@ Cartridge::poke(uint16_t addr, uint8_t value)
     // Write to RAM if we don't run in Ultimax mode
     if (!c64->getUltimax()) {
         c64->mem.ram[addr] = value;
+        c64->mem.markDirty(addr);
     }
 }
 
@@ -393,7 +425,7 @@ Cartridge::loadChip(unsigned nr, CRTFile *c)
     switch (type) {
         
         case 0: // ROM
-        packet[nr] = new CartridgeRom(size, start, c->chipData(nr));
+        packet[nr] = new CartridgeRom(size, start, c->sharedChipData(nr));
         break;
         
         case 1: // RAM
@@ -402,7 +434,7 @@ Cartridge::loadChip(unsigned nr, CRTFile *c)
         
         case 2: // Flash ROM
         warn("Chip %d is a Flash Rom. Creating a Rom instead.\n", nr);
-        packet[nr] = new CartridgeRom(size, start, c->chipData(nr));
+        packet[nr] = new CartridgeRom(size, start, c->sharedChipData(nr));
         break;
         
         default:
@@ -419,6 +451,8 @@ Cartridge::bankInROML(unsigned nr, uint16_t size, uint16_t offset)
     chipL = nr;
     mappedBytesL = size;
     offsetL = offset;
+    
+    c64->expansionport.updateRomPages();
 }
 
 void
@@ -427,6 +461,8 @@ Cartridge::bankInROMH(unsigned nr, uint16_t size, uint16_t offset)
     chipH = nr;
     mappedBytesH = size;
     offsetH = offset;
+    
+    c64->expansionport.updateRomPages();
 }
 
 void
@@ -478,6 +514,8 @@ Cartridge::bankOut(unsigned nr)
         mappedBytesH = 0;
         offsetH = 0;
     }
+    
+    c64->expansionport.updateRomPages();
 }
 
 void
@@ -497,4 +535,5 @@ Cartridge::resetWithoutDeletingRam()
     memcpy(ram, c64->mem.ram, 0x10000);
     c64->reset();
     memcpy(c64->mem.ram, ram, 0x10000);
+    c64->mem.markAllDirty();
 }
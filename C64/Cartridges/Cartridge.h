@@ -219,6 +219,14 @@ public:
     void didSaveToBuffer(uint8_t **buffer);
     void dump();
     
+    /*! @brief    Method from VirtualComponent
+     *  @details  Hashes the snapshot items, the chip packets, and the
+     *            external RAM. The fingerprints of the chip packets are
+     *            cached. Subclasses that save additional data overwrite this
+     *            function and combine their data with the result.
+     */
+    uint64_t fingerprint();
+    
     
     //
     //! @functiongroup Managing the cartridge configuration
@@ -304,6 +312,17 @@ public:
     //! @brief    Same as peek, but without side effects.
     virtual uint8_t spypeek(uint16_t addr) { return peek(addr); }
     
+    /*! @brief    Returns a pointer to the ROM data that is visible in a page
+     *  @details  The C64 memory uses these pointers to read cartridge ROM
+     *            directly, bypassing peek(). Only pages that are completely
+     *            covered by ROM and can be read without side effects are
+     *            served this way. Cartridges with a custom peek() function
+     *            must either overwrite this function or return NULL.
+     *  @param    page is the upper nibble of a ROML or ROMH address.
+     *  @return   NULL, if the page has to be accessed via peek().
+     */
+    virtual uint8_t *romPage(unsigned page);
+    
     //! @brief    Same as peekRomL, but without side effects
     uint8_t spypeekRomL(uint16_t addr) { return peekRomL(addr); }
     
@@ -327,6 +346,11 @@ public:
 
     //! @brief    Poke fallthrough for I/O space 2
     virtual void pokeIO2(uint16_t addr, uint8_t value) { }
+    
+    /*! @brief    Notifies the cartridge about a write access to $FF00
+     *  @details  The REU uses this address as a trigger to start a DMA.
+     */
+    virtual void pokeFF00() { }
 
     
     //
@@ -350,11 +374,11 @@ public:
     void setPersistentRam(bool value) { persistentRam = value; }
 
     //! @brief    Reads a byte from the on-board RAM.
-    uint8_t peekRAM(uint16_t addr) {
+    uint8_t peekRAM(uint32_t addr) {
         assert(addr < ramCapacity); return externalRam[addr]; }
 
     //! @brief    Writes a byte into the on-board RAM.
-    void pokeRAM(uint16_t addr, uint8_t value) {
+    void pokeRAM(uint32_t addr, uint8_t value) {
         assert(addr < ramCapacity); externalRam[addr] = value; }
 
     //! @brief    Erase the on-board RAM.
@@ -483,6 +507,9 @@ public:
         Cartridge::didSaveToBuffer(buffer);
         write8(buffer, control);
     }
+    uint64_t fingerprint() {
+        return combineFingerprints(Cartridge::fingerprint(), control);
+    }
 };
 
 #endif 
@@ -48,16 +48,27 @@ CartridgeRom::CartridgeRom(uint16_t size, uint16_t loadAddress, const uint8_t *b
 {
     this->size = size;
     this->loadAddress = loadAddress;
-    rom = new uint8_t[size];
+    storage = std::shared_ptr<uint8_t>(new uint8_t[size],
+                                       std::default_delete<uint8_t[]>());
+    rom = storage.get();
     if (buffer) {
         memcpy(rom, buffer, size);
     }
 }
 
+CartridgeRom::CartridgeRom(uint16_t size, uint16_t loadAddress, std::shared_ptr<uint8_t> data) : CartridgeRom()
+{
+    assert(data != nullptr);
+    
+    this->size = size;
+    this->loadAddress = loadAddress;
+    storage = data;
+    rom = storage.get();
+}
+
 CartridgeRom::~CartridgeRom()
 {
     assert(rom != NULL);
-    delete[] rom;
 }
 
 size_t
@@ -69,8 +80,11 @@ CartridgeRom::stateSize()
 void
 CartridgeRom::didLoadFromBuffer(uint8_t **buffer)
 {
-    if (rom) delete[] rom;
-    rom = new uint8_t[size];
+    // Snapshot data is never shared
+    storage = std::shared_ptr<uint8_t>(new uint8_t[size],
+                                       std::default_delete<uint8_t[]>());
+    rom = storage.get();
+    romFingerprint = 0;
     
     readBlock(buffer, rom, size);
 }
@@ -81,6 +95,15 @@ CartridgeRom::didSaveToBuffer(uint8_t **buffer)
     writeBlock(buffer, rom, size);
 }
 
+uint64_t
+CartridgeRom::fingerprint()
+{
+    if (romFingerprint == 0) {
+        romFingerprint = fnv_1a(rom, size);
+    }
+    return fingerprintItems(romFingerprint);
+}
+
 bool
 CartridgeRom::mapsToL() {
     assert(rom != NULL);
@@ -22,6 +22,7 @@
 #define _CARTRIDGEROM_INC
 
 #include "VirtualComponent.h"
+#include <memory>
 
 /*! @brief    This class implements a cartridge Rom chip 
  */
@@ -29,9 +30,22 @@ class CartridgeRom : public VirtualComponent {
     
     protected:
     
-    //! @brief    Rom data
+    /*! @brief    Owner of the Rom data
+     *  @details  Chip packets created from a CRT file reference the file
+     *            image in place. The image is shared between all packets and
+     *            all emulator instances using the same file. Images of files
+     *            read from disk are usually memory mappings. Such files must
+     *            not be truncated while the packet exists (see
+     *            CRTFile::image).
+     */
+    std::shared_ptr<uint8_t> storage;
+    
+    //! @brief    Rom data (read-only)
     uint8_t *rom = NULL;
     
+    //! @brief    Fingerprint of the Rom data (0 = not computed yet)
+    uint64_t romFingerprint = 0;
+    
     public:
     
     //! @brief    Size in bytes
@@ -52,6 +66,9 @@ class CartridgeRom : public VirtualComponent {
     // CartridgeRom(uint8_t **buffer);
     CartridgeRom(uint16_t _size, uint16_t _loadAddress, const uint8_t *buffer = NULL);
     
+    //! @brief    Constructs a Rom chip that references shared data in place
+    CartridgeRom(uint16_t _size, uint16_t _loadAddress, std::shared_ptr<uint8_t> data);
+    
     //! @brief    Destructor
     ~CartridgeRom();
     
@@ -60,6 +77,11 @@ class CartridgeRom : public VirtualComponent {
     void didLoadFromBuffer(uint8_t **buffer);
     void didSaveToBuffer(uint8_t **buffer);
     
+    /*! @brief    Method from VirtualComponent
+     *  @details  The Rom data never changes. It is hashed once.
+     */
+    uint64_t fingerprint();
+    
     //! @brief    Returns true if this Rom chip maps to ROML, only.
     bool mapsToL();
     
@@ -78,6 +100,12 @@ class CartridgeRom : public VirtualComponent {
     //! @brief    Writes a ROM cell
     void poke(uint16_t addr, uint8_t value) { }
     
+    /*! @brief    Returns a pointer to a range of ROM cells
+     *  @return   NULL, if the range exceeds the chip size.
+     */
+    uint8_t *getData(uint16_t offset, uint16_t length) {
+        return (rom && offset + length <= size) ? rom + offset : NULL; }
+    
 };
 
 #endif
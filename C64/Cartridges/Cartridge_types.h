@@ -85,6 +85,7 @@ typedef enum {
     CRT_EASYCALC = 59,
     CRT_GMOD2 = 60,
     
+    CRT_REU = 252,
     CRT_ISEPIC = 253,
     CRT_GEO_RAM = 254,
     CRT_NONE = 255
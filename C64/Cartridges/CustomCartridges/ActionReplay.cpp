@@ -45,6 +45,13 @@ ActionReplay3::peek(uint16_t addr)
     return 0;
 }
 
+uint8_t *
+ActionReplay3::romPage(unsigned page)
+{
+    CartridgeRom *chip = packet[bank()];
+    return chip ? chip->getData((page & 1) ? 0x1000 : 0x0000, 0x1000) : NULL;
+}
+
 uint8_t
 ActionReplay3::peekIO1(uint16_t addr)
 {
@@ -126,6 +133,7 @@ ActionReplay3::setControlReg(uint8_t value)
 {
     control = value;
     c64->expansionport.setGameAndExrom(game(), exrom());
+    c64->expansionport.updateRomPages();
 }
 
 
@@ -164,6 +172,12 @@ ActionReplay::peek(uint16_t addr)
     }
     return Cartridge::peek(addr);
 }
+
+uint8_t *
+ActionReplay::romPage(unsigned page)
+{
+    return ramIsEnabled(page << 12) ? NULL : Cartridge::romPage(page);
+}
  
 void
 ActionReplay::poke(uint16_t addr, uint8_t value)
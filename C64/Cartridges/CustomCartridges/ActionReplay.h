@@ -40,6 +40,7 @@ public:
     //
     
     uint8_t peek(uint16_t addr);
+    uint8_t *romPage(unsigned page);
     uint8_t peekIO1(uint16_t addr);
     uint8_t peekIO2(uint16_t addr);
     
@@ -92,6 +93,7 @@ public:
     void resetCartConfig();
     
     uint8_t peek(uint16_t addr);
+    uint8_t *romPage(unsigned page);
     uint8_t peekIO1(uint16_t addr);
     uint8_t peekIO2(uint16_t addr);
     
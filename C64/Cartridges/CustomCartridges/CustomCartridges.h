@@ -37,6 +37,7 @@
 #include "Kingsoft.h"
 #include "MagicDesk.h"
 #include "Ocean.h"
+#include "Reu.h"
 #include "Rex.h"
 #include "SimonsBasic.h"
 #include "StarDos.h"
@@ -43,6 +43,8 @@ EasyFlash::reset()
     bank = 0;
     eraseRAM(0xFF);
     jumper = false;
+    
+    c64->expansionport.updateRomPages();
 }
 
 void
@@ -94,6 +96,16 @@ EasyFlash::didSaveToBuffer(uint8_t **buffer)
     flashRomH.saveToBuffer(buffer);
 }
 
+uint64_t
+EasyFlash::fingerprint()
+{
+    uint64_t hash = Cartridge::fingerprint();
+    hash = combineFingerprints(hash, bank);
+    hash = combineFingerprints(hash, jumper);
+    hash = combineFingerprints(hash, flashRomL.fingerprint());
+    return combineFingerprints(hash, flashRomH.fingerprint());
+}
+
 void
 EasyFlash::resetCartConfig()
 {
@@ -107,7 +119,7 @@ EasyFlash::loadChip(unsigned nr, CRTFile *c)
     
     uint16_t chipSize = c->chipSize(nr);
     uint16_t chipAddr = c->chipAddr(nr);
-    uint8_t *chipData = c->chipData(nr);
+    std::shared_ptr<uint8_t> chipData = c->sharedChipData(nr);
 
     if (nr == 0) {
         bank = 0;
@@ -162,6 +174,15 @@ EasyFlash::peek(uint16_t addr)
     }
 }
 
+uint8_t *
+EasyFlash::romPage(unsigned page)
+{
+    FlashRom &flashRom = isROMLaddr(page << 12) ? flashRomL : flashRomH;
+    uint8_t *data = flashRom.bankData(bank);
+    
+    return data ? data + ((page & 1) ? 0x1000 : 0x0000) : NULL;
+}
+
 /*
 uint8_t
 EasyFlash::spypeek(uint16_t addr)
@@ -191,6 +212,9 @@ EasyFlash::poke(uint16_t addr, uint8_t value)
     } else {
         assert(false);
     }
+    
+    // The Flash Rom might have entered or left autoselect mode
+    c64->expansionport.updateRomPages();
 }
 
 uint8_t
@@ -212,6 +236,7 @@ EasyFlash::pokeIO1(uint16_t addr, uint8_t value)
     if (addr == 0xDE00) { // Bank register
         
         bank = value & 0x3F;
+        c64->expansionport.updateRomPages();
         return;
     }
     
@@ -57,6 +57,7 @@ public:
     size_t stateSize();
     void didLoadFromBuffer(uint8_t **buffer);
     void didSaveToBuffer(uint8_t **buffer);
+    uint64_t fingerprint();
     
     
     //
@@ -66,6 +67,7 @@ public:
     void resetCartConfig();
     void loadChip(unsigned nr, CRTFile *c);
     uint8_t peek(uint16_t addr);
+    uint8_t *romPage(unsigned page);
     void poke(uint16_t addr, uint8_t value);
     uint8_t peekIO1(uint16_t addr);
     uint8_t peekIO2(uint16_t addr);
@@ -47,6 +47,12 @@ EpyxFastLoad::didSaveToBuffer(uint8_t **buffer)
     write64(buffer, cycle);
 }
 
+uint64_t
+EpyxFastLoad::fingerprint()
+{
+    return combineFingerprints(Cartridge::fingerprint(), cycle);
+}
+
 void
 EpyxFastLoad::resetCartConfig()
 {
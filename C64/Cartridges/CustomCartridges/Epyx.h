@@ -52,6 +52,7 @@ public:
     size_t stateSize();
     void didLoadFromBuffer(uint8_t **buffer);
     void didSaveToBuffer(uint8_t **buffer);
+    uint64_t fingerprint();
     
     //
     //! @functiongroup Methods from Cartridge
@@ -60,6 +61,8 @@ public:
     void resetCartConfig();
     uint8_t peekRomL(uint16_t addr);
     uint8_t spypeekRomL(uint16_t addr) { return Cartridge::peekRomL(addr); }
+    uint8_t *romPage(unsigned page) {
+        return isROMLaddr(page << 12) ? NULL : Cartridge::romPage(page); }
     uint8_t peekIO1(uint16_t addr);
     uint8_t spypeekIO1(uint16_t addr) { return 0; }
     uint8_t peekIO2(uint16_t addr);
@@ -80,6 +80,12 @@ Expert::didSaveToBuffer(uint8_t **buffer)
     write8(buffer, (uint8_t)active);
 }
 
+uint64_t
+Expert::fingerprint()
+{
+    return combineFingerprints(Cartridge::fingerprint(), active);
+}
+
 void
 Expert::loadChip(unsigned nr, CRTFile *c)
 {
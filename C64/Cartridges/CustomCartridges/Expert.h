@@ -43,6 +43,7 @@ public:
     size_t stateSize();
     void didLoadFromBuffer(uint8_t **buffer);
     void didSaveToBuffer(uint8_t **buffer);
+    uint64_t fingerprint();
     
     //
     //! @functiongroup Methods from Cartridge
@@ -62,6 +63,7 @@ public:
 
     void updatePeekPokeLookupTables();
     uint8_t peek(uint16_t addr);
+    uint8_t *romPage(unsigned page) { return NULL; }
     uint8_t peekIO1(uint16_t addr);
     uint8_t spypeekIO1(uint16_t addr) { return 0; }
     void poke(uint16_t addr, uint8_t value);
@@ -62,6 +62,12 @@ public:
         write8(buffer, (uint8_t)freeezeButtonIsPressed);
         write8(buffer, (uint8_t)qD);
     }
+    uint64_t fingerprint()
+    {
+        uint64_t hash = CartridgeWithRegister::fingerprint();
+        hash = combineFingerprints(hash, freeezeButtonIsPressed);
+        return combineFingerprints(hash, qD);
+    }
     
     //
     //! @functiongroup Methods from Cartridge
@@ -24,6 +24,7 @@
 GeoRAM::GeoRAM(C64 *c64) : Cartridge(c64)
 {
     setDescription("GeoRAM");
+    ram.setDescription("GeoRAM_Ram");
 }
 
 void
@@ -31,16 +32,28 @@ GeoRAM::reset()
 {
     if (!getPersistentRam()) {
         debug("Erasing GeoRAM\n");
-        eraseRAM(0);
+        ram.erase(0);
     } else {
         debug("Preserving GeoRAM\n");
     }
 }
 
+void
+GeoRAM::dump()
+{
+    Cartridge::dump();
+    
+    msg("GeoRAM\n");
+    msg("------\n\n");
+    
+    msg("bank = %d page = %d\n\n", bank, page);
+    ram.dump();
+}
+
 size_t
 GeoRAM::stateSize()
 {
-    return Cartridge::stateSize() + 2;
+    return Cartridge::stateSize() + 2 + ram.stateSize();
 }
 
 void
@@ -49,6 +62,25 @@ GeoRAM::didLoadFromBuffer(uint8_t **buffer)
     Cartridge::didLoadFromBuffer(buffer);
     bank = read8(buffer);
     page = read8(buffer);
+    
+    /* Older snapshots store the GeoRAM contents as plain cartridge RAM. In
+     * this case, the data is moved into the paged RAM.
+     */
+    uint32_t legacyCapacity = getRamCapacity();
+    if (legacyCapacity) {
+        
+        uint8_t *data = new uint8_t[legacyCapacity];
+        for (unsigned i = 0; i < legacyCapacity; i++) {
+            data[i] = peekRAM(i);
+        }
+        ram.setCapacity(legacyCapacity);
+        ram.write(0, data, legacyCapacity);
+        setRamCapacity(0);
+        delete[] data;
+        return;
+    }
+    
+    ram.loadFromBuffer(buffer);
 }
 
 void
@@ -57,6 +89,16 @@ GeoRAM::didSaveToBuffer(uint8_t **buffer)
     Cartridge::didSaveToBuffer(buffer);
     write8(buffer, bank);
     write8(buffer, page);
+    ram.saveToBuffer(buffer);
+}
+
+uint64_t
+GeoRAM::fingerprint()
+{
+    uint64_t hash = Cartridge::fingerprint();
+    hash = combineFingerprints(hash, bank);
+    hash = combineFingerprints(hash, page);
+    return combineFingerprints(hash, ram.fingerprint());
 }
 
 unsigned
@@ -71,7 +113,7 @@ GeoRAM::offset(uint8_t addr)
      *  256-byte pages inside of 16k, the value in $dffe ranges from 0 to 63."
      */
     
-    unsigned bankOffset = (bank * 16384) % getRamCapacity();
+    unsigned bankOffset = (bank * 16384) % getCapacity();
     unsigned pageOffset = (page & 0x3F) * 256;
     return bankOffset + pageOffset + addr;
 }
@@ -80,7 +122,7 @@ uint8_t
 GeoRAM::peekIO1(uint16_t addr)
 {
     assert(addr >= 0xDE00 && addr <= 0xDEFF);
-    return peekRAM(offset(addr - 0xDE00));
+    return ram.peek(offset(addr - 0xDE00));
 }
 
 uint8_t
@@ -93,7 +135,7 @@ void
 GeoRAM::pokeIO1(uint16_t addr, uint8_t value)
 {
     assert(addr >= 0xDE00 && addr <= 0xDEFF);
-    pokeRAM(offset(addr - 0xDE00), value);
+    ram.poke(offset(addr - 0xDE00), value);
 }
 
 void
@@ -23,11 +23,15 @@
 #define _GEORAM_INC
 
 #include "Cartridge.h"
+#include "PagedRam.h"
 
 class GeoRAM : public Cartridge {
     
 private:
     
+    //! @brief   The expansion RAM
+    PagedRam ram;
+    
     //! @brief   Selected RAM bank
     uint8_t bank;
     
@@ -40,10 +44,26 @@ private:
 public:
     GeoRAM(C64 *c64);
     CartridgeType getCartridgeType() { return CRT_GEO_RAM; }
+    
+    //! @brief   Sets the size of the expansion RAM in bytes
+    void setCapacity(uint32_t bytes) { ram.setCapacity(bytes); }
+    
+    //! @brief   Returns the size of the expansion RAM in bytes
+    uint32_t getCapacity() { return ram.getCapacity(); }
+    
+    //! @brief   Enables or disables compression of idle RAM pages
+    void setCompression(bool value) { ram.setCompression(value); }
+    
+    //! @brief   Provides access to the paged RAM
+    PagedRam &getRam() { return ram; }
+    
     void reset();
+    void dump();
+    void execute() { ram.execute(); }
     size_t stateSize();
     void didLoadFromBuffer(uint8_t **buffer);
     void didSaveToBuffer(uint8_t **buffer);
+    uint64_t fingerprint();
     uint8_t peekIO1(uint16_t addr);
     uint8_t peekIO2(uint16_t addr);
     void pokeIO1(uint16_t addr, uint8_t value);
@@ -62,6 +62,12 @@ Isepic::didSaveToBuffer(uint8_t **buffer)
     write8(buffer, page);
 }
 
+uint64_t
+Isepic::fingerprint()
+{
+    return combineFingerprints(Cartridge::fingerprint(), page);
+}
+
 uint8_t
 Isepic::peek(uint16_t addr)
 {
@@ -131,6 +137,7 @@ Isepic::poke(uint16_t addr, uint8_t value)
         pokeRAM((page * 256) + (addr & 0xFF), value);
     } else if (isROMHaddr(addr)) {
         c64->mem.ram[addr] = value;
+        c64->mem.markDirty(addr);
     } else {
         assert(false);
     }
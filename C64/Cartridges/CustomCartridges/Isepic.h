@@ -37,6 +37,7 @@ public:
     size_t stateSize();
     void didLoadFromBuffer(uint8_t **buffer);
     void didSaveToBuffer(uint8_t **buffer);
+    uint64_t fingerprint();
     
     bool hasSwitch() { return true; }
     const char *getSwitchDescription(int8_t pos);
@@ -49,6 +50,7 @@ public:
 
     void updatePeekPokeLookupTables();
     uint8_t peek(uint16_t addr);
+    uint8_t *romPage(unsigned page) { return NULL; }
     uint8_t peekIO1(uint16_t addr);
     uint8_t peekIO2(uint16_t addr);
     void poke(uint16_t addr, uint8_t value);
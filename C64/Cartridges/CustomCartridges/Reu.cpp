@@ -0,0 +1,369 @@
+/*!
+ * @header      Reu.cpp
+ * @author      Dirk W. Hoffmann, www.dirkwhoffmann.de
+ * @copyright   Dirk W. Hoffmann. All rights reserved.
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "C64.h"
+
+REU::REU(C64 *c64) : Cartridge(c64, "REU")
+{
+    ram.setDescription("REU_Ram");
+    reset();
+}
+
+void
+REU::reset()
+{
+    status = 0;
+    command = 0x10;
+    c64Base = shadowC64Base = 0;
+    reuBase = shadowReuBase = 0;
+    length = shadowLength = 0xFFFF;
+    irqMask = 0;
+    addrCtrl = 0;
+    
+    if (!getPersistentRam()) {
+        debug("Erasing REU\n");
+        ram.erase(0);
+    } else {
+        debug("Preserving REU\n");
+    }
+}
+
+void
+REU::dump()
+{
+    Cartridge::dump();
+    
+    msg("REU\n");
+    msg("---\n\n");
+    
+    msg("      Status: %02X\n", status);
+    msg("     Command: %02X\n", command);
+    msg("C64 address: %04X (%04X)\n", c64Base, shadowC64Base);
+    msg("REU address: %06X (%06X)\n", reuBase, shadowReuBase);
+    msg("     Length: %04X (%04X)\n", length, shadowLength);
+    msg("    IRQ mask: %02X\n", irqMask);
+    msg("Addr control: %02X\n\n", addrCtrl);
+    ram.dump();
+}
+
+size_t
+REU::stateSize()
+{
+    return Cartridge::stateSize() + 20 + ram.stateSize();
+}
+
+void
+REU::didLoadFromBuffer(uint8_t **buffer)
+{
+    Cartridge::didLoadFromBuffer(buffer);
+    status = read8(buffer);
+    command = read8(buffer);
+    c64Base = read16(buffer);
+    reuBase = read32(buffer);
+    length = read16(buffer);
+    irqMask = read8(buffer);
+    addrCtrl = read8(buffer);
+    shadowC64Base = read16(buffer);
+    shadowReuBase = read32(buffer);
+    shadowLength = read16(buffer);
+    ram.loadFromBuffer(buffer);
+}
+
+void
+REU::didSaveToBuffer(uint8_t **buffer)
+{
+    Cartridge::didSaveToBuffer(buffer);
+    write8(buffer, status);
+    write8(buffer, command);
+    write16(buffer, c64Base);
+    write32(buffer, reuBase);
+    write16(buffer, length);
+    write8(buffer, irqMask);
+    write8(buffer, addrCtrl);
+    write16(buffer, shadowC64Base);
+    write32(buffer, shadowReuBase);
+    write16(buffer, shadowLength);
+    ram.saveToBuffer(buffer);
+}
+
+uint64_t
+REU::fingerprint()
+{
+    // Serialize the registers like didSaveToBuffer() does
+    uint8_t registers[20], *ptr = registers;
+    write8(&ptr, status);
+    write8(&ptr, command);
+    write16(&ptr, c64Base);
+    write32(&ptr, reuBase);
+    write16(&ptr, length);
+    write8(&ptr, irqMask);
+    write8(&ptr, addrCtrl);
+    write16(&ptr, shadowC64Base);
+    write32(&ptr, shadowReuBase);
+    write16(&ptr, shadowLength);
+    assert(ptr - registers == sizeof(registers));
+    
+    uint64_t hash = fnv_1a(registers, sizeof(registers), Cartridge::fingerprint());
+    return combineFingerprints(hash, ram.fingerprint());
+}
+
+uint8_t
+REU::peekIO2(uint16_t addr)
+{
+    uint8_t result = spypeekIO2(addr);
+    
+    // Reading the status register clears the interrupt and error bits
+    if ((addr & 0x1F) == 0x00) {
+        status &= 0x1F;
+        updateIrq();
+    }
+    
+    return result;
+}
+
+uint8_t
+REU::spypeekIO2(uint16_t addr)
+{
+    assert(addr >= 0xDF00 && addr <= 0xDFFF);
+    
+    switch (addr & 0x1F) {
+            
+        case 0x00: // Status register (bit 4 indicates 256 KB RAM chips)
+            return status | (getCapacity() > 0x20000 ? 0x10 : 0x00);
+            
+        case 0x01: return command;
+        case 0x02: return LO_BYTE(c64Base);
+        case 0x03: return HI_BYTE(c64Base);
+        case 0x04: return (uint8_t)(reuBase & 0xFF);
+        case 0x05: return (uint8_t)((reuBase >> 8) & 0xFF);
+        case 0x06: return (uint8_t)(reuBase >> 16) | 0xF8;
+        case 0x07: return LO_BYTE(length);
+        case 0x08: return HI_BYTE(length);
+        case 0x09: return irqMask | 0x1F;
+        case 0x0A: return addrCtrl | 0x3F;
+            
+        default:
+            return 0xFF;
+    }
+}
+
+void
+REU::pokeIO2(uint16_t addr, uint8_t value)
+{
+    assert(addr >= 0xDF00 && addr <= 0xDFFF);
+    
+    // Address and length registers are written into the shadow registers, too
+    switch (addr & 0x1F) {
+            
+        case 0x01:
+            command = value;
+            if ((command & 0x90) == 0x90) executeTransfer();
+            return;
+            
+        case 0x02:
+            c64Base = shadowC64Base = (shadowC64Base & 0xFF00) | value;
+            return;
+            
+        case 0x03:
+            c64Base = shadowC64Base = (shadowC64Base & 0x00FF) | (value << 8);
+            return;
+            
+        case 0x04:
+            reuBase = shadowReuBase = (shadowReuBase & 0x7FF00) | value;
+            return;
+            
+        case 0x05:
+            reuBase = shadowReuBase = (shadowReuBase & 0x700FF) | (value << 8);
+            return;
+            
+        case 0x06:
+            reuBase = shadowReuBase = (shadowReuBase & 0x0FFFF) | ((value & 0x07) << 16);
+            return;
+            
+        case 0x07:
+            length = shadowLength = (shadowLength & 0xFF00) | value;
+            return;
+            
+        case 0x08:
+            length = shadowLength = (shadowLength & 0x00FF) | (value << 8);
+            return;
+            
+        case 0x09:
+            irqMask = value & 0xE0;
+            updateIrq();
+            return;
+            
+        case 0x0A:
+            addrCtrl = value & 0xC0;
+            return;
+            
+        default:
+            return;
+    }
+}
+
+void
+REU::pokeFF00()
+{
+    // Execute a transfer that waits for a write access to $FF00
+    if ((command & 0x90) == 0x80) executeTransfer();
+}
+
+uint8_t
+REU::peekC64(uint16_t addr)
+{
+    return c64->mem.peek(addr);
+}
+
+void
+REU::pokeC64(uint16_t addr, uint8_t value)
+{
+    c64->mem.poke(addr, value);
+}
+
+uint8_t *
+REU::c64Block(uint16_t addr, TransferType type)
+{
+    // Watched pages are mapped to M_WATCH and transferred byte by byte
+    bool readable = c64->mem.peekSrc[addr >> 12] == M_RAM;
+    MemoryType target = c64->mem.pokeTarget[addr >> 12];
+    bool writeable = target == M_RAM || target == M_ROM;
+    
+    switch (type) {
+            
+        case REU_STASH:
+        case REU_VERIFY:
+            return readable ? c64->mem.ram + addr : NULL;
+            
+        case REU_FETCH:
+            return writeable ? c64->mem.ram + addr : NULL;
+            
+        default:
+            return readable && writeable ? c64->mem.ram + addr : NULL;
+    }
+}
+
+void
+REU::executeTransfer()
+{
+    TransferType type = (TransferType)(command & 0x03);
+    bool fixC64 = addrCtrl & 0x80;
+    bool fixReu = addrCtrl & 0x40;
+    
+    uint16_t c64Addr = c64Base;
+    uint32_t reuAddr = reuBase;
+    uint32_t remaining = length ? length : 0x10000;
+    bool fault = false;
+    
+    debug(2, "Transfer type %d: C64 %04X REU %06X length %d\n",
+          type, c64Addr, reuAddr, remaining);
+    
+    while (remaining && !fault) {
+        
+        // Try to transfer up to the next 4 KB boundary in a single step
+        uint32_t chunk = MIN(remaining, 0x1000 - (c64Addr & 0xFFF));
+        uint8_t *ptr = (fixC64 || fixReu) ? NULL : c64Block(c64Addr, type);
+        uint32_t done = ptr ? chunk : 1;
+        
+        switch (type) {
+                
+            case REU_STASH:
+                
+                if (ptr) ram.write(reuAddr, ptr, chunk);
+                else ram.poke(reuAddr, peekC64(c64Addr));
+                break;
+                
+            case REU_FETCH:
+                
+                if (ptr) {
+                    ram.read(reuAddr, ptr, chunk);
+                    c64->mem.markDirty(c64Addr, chunk);
+                } else {
+                    pokeC64(c64Addr, ram.peek(reuAddr));
+                }
+                break;
+                
+            case REU_SWAP:
+                
+                if (ptr) {
+                    uint8_t buffer[0x1000];
+                    ram.read(reuAddr, buffer, chunk);
+                    ram.write(reuAddr, ptr, chunk);
+                    memcpy(ptr, buffer, chunk);
+                    c64->mem.markDirty(c64Addr, chunk);
+                } else {
+                    uint8_t value = ram.peek(reuAddr);
+                    ram.poke(reuAddr, peekC64(c64Addr));
+                    pokeC64(c64Addr, value);
+                }
+                break;
+                
+            case REU_VERIFY:
+                
+                if (ptr) {
+                    uint32_t equal = ram.compare(reuAddr, ptr, chunk);
+                    if (equal < chunk) {
+                        done = equal + 1;
+                        fault = true;
+                    }
+                } else {
+                    fault = ram.peek(reuAddr) != peekC64(c64Addr);
+                }
+                break;
+        }
+        
+        if (!fixC64) c64Addr += done;
+        if (!fixReu) reuAddr = (reuAddr + done) & 0x7FFFF;
+        remaining -= done;
+    }
+    
+    // Update status register
+    if (remaining == 0) status |= 0x40;
+    if (fault) status |= 0x20;
+    
+    // Update address and length registers
+    if (command & 0x20) {
+        c64Base = shadowC64Base;
+        reuBase = shadowReuBase;
+        length = shadowLength;
+    } else {
+        c64Base = c64Addr;
+        reuBase = reuAddr;
+        length = remaining ? (uint16_t)remaining : 1;
+    }
+    
+    // Clear the execute bit and disable the $FF00 trigger
+    command = (command & 0x7F) | 0x10;
+    
+    updateIrq();
+}
+
+void
+REU::updateIrq()
+{
+    if ((irqMask & 0x80) && (status & irqMask & 0x60)) {
+        status |= 0x80;
+        c64->cpu.pullDownIrqLine(CPU::INTSRC_EXPANSION);
+    } else {
+        status &= 0x7F;
+        c64->cpu.releaseIrqLine(CPU::INTSRC_EXPANSION);
+    }
+}
@@ -0,0 +1,156 @@
+/*!
+ * @header      Reu.h
+ * @author      Dirk W. Hoffmann, www.dirkwhoffmann.de
+ * @copyright   Dirk W. Hoffmann. All rights reserved.
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _REU_INC
+#define _REU_INC
+
+#include "Cartridge.h"
+#include "PagedRam.h"
+
+/*! @brief    Commodore RAM Expansion Unit (1700, 1764, 1750)
+ *  @details  The REU is controlled by eleven registers in I/O space 2 which
+ *            are mirrored every 32 bytes. Data is moved between C64 memory
+ *            and expansion RAM by the REC (RAM Expansion Controller).
+ *            Transfers are carried out as a whole when they are triggered.
+ *            Hence, the CPU does not notice the cycles stolen by the DMA.
+ */
+class REU : public Cartridge {
+
+    public:
+
+    //! @brief   Transfer types (command register bits 0 and 1)
+    typedef enum {
+        REU_STASH = 0,
+        REU_FETCH = 1,
+        REU_SWAP = 2,
+        REU_VERIFY = 3
+    } TransferType;
+
+    private:
+
+    //! @brief   The expansion RAM
+    PagedRam ram;
+
+    //! @brief   Status register ($DF00)
+    uint8_t status;
+
+    //! @brief   Command register ($DF01)
+    uint8_t command;
+
+    //! @brief   C64 base address ($DF02, $DF03)
+    uint16_t c64Base;
+
+    //! @brief   REU base address ($DF04 - $DF06)
+    uint32_t reuBase;
+
+    //! @brief   Transfer length ($DF07, $DF08)
+    uint16_t length;
+
+    //! @brief   Interrupt mask ($DF09)
+    uint8_t irqMask;
+
+    //! @brief   Address control register ($DF0A)
+    uint8_t addrCtrl;
+
+    /*! @brief   Values written by the CPU
+     *  @details These values are restored after a transfer if the autoload
+     *           bit is set in the command register.
+     */
+    uint16_t shadowC64Base;
+    uint32_t shadowReuBase;
+    uint16_t shadowLength;
+
+    public:
+
+    //
+    //! @functiongroup Creating and destructing
+    //
+
+    REU(C64 *c64);
+    CartridgeType getCartridgeType() { return CRT_REU; }
+
+    //! @brief   Sets the size of the expansion RAM in bytes
+    void setCapacity(uint32_t bytes) { ram.setCapacity(bytes); }
+
+    //! @brief   Returns the size of the expansion RAM in bytes
+    uint32_t getCapacity() { return ram.getCapacity(); }
+
+    //! @brief   Enables or disables compression of idle RAM pages
+    void setCompression(bool value) { ram.setCompression(value); }
+
+    //! @brief   Provides access to the paged RAM
+    PagedRam &getRam() { return ram; }
+
+
+    //
+    //! @functiongroup Methods from VirtualComponent
+    //
+
+    void reset();
+    void dump();
+    size_t stateSize();
+    void didLoadFromBuffer(uint8_t **buffer);
+    void didSaveToBuffer(uint8_t **buffer);
+    uint64_t fingerprint();
+
+
+    //
+    //! @functiongroup Methods from Cartridge
+    //
+
+    void execute() { ram.execute(); }
+    uint8_t peekIO2(uint16_t addr);
+    uint8_t spypeekIO2(uint16_t addr);
+    void pokeIO2(uint16_t addr, uint8_t value);
+    void pokeFF00();
+
+
+    //
+    //! @functiongroup Performing DMA transfers
+    //
+
+    private:
+
+    //! @brief   Reads a C64 memory cell the way the REC does
+    uint8_t peekC64(uint16_t addr);
+
+    //! @brief   Writes a C64 memory cell the way the REC does
+    void pokeC64(uint16_t addr, uint8_t value);
+
+    /*! @brief   Returns a pointer to C64 RAM if a block can be accessed directly
+     *  @details Direct access is possible if the 4 KB page containing addr
+     *           maps to plain RAM for all accesses performed by the transfer.
+     *  @return  NULL, if the block has to be transferred byte by byte.
+     */
+    uint8_t *c64Block(uint16_t addr, TransferType type);
+
+    /*! @brief   Carries out the transfer programmed in the registers
+     *  @details Stash, fetch, and swap operations are performed in blocks.
+     *           Blocks end at 4 KB boundaries of the C64 address space,
+     *           because the memory mapping may differ between two blocks.
+     */
+    void executeTransfer();
+
+    //! @brief   Updates the interrupt line according to the status register
+    void updateIrq();
+};
+
+#endif
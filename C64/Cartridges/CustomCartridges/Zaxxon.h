@@ -33,6 +33,8 @@ public:
     void reset();
     uint8_t peekRomL(uint16_t addr);
     uint8_t spypeekRomL(uint16_t addr);
+    uint8_t *romPage(unsigned page) {
+        return isROMLaddr(page << 12) ? NULL : Cartridge::romPage(page); }
 };
 
 #endif
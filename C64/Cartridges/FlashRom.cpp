@@ -19,6 +19,7 @@
  */
 
 #include "FlashRom.h"
+#include <algorithm>
 
 const char *
 FlashRom::getStateAsString(FlashRomState state)
@@ -54,14 +55,17 @@ FlashRom::FlashRom()
     sectorSize = 0x10000; // 64 KB
     size = 0x80000;       // 512 KB
     
-    rom = new uint8_t[size];
-    memset(rom, 0xFF, size);
+    // Start with an erased chip
+    memset(sector, 0, sizeof(sector));
+    for (unsigned i = 0; i < numBanks; i++) {
+        view[i] = erasedBank();
+    }
+    memset(dirtyBanks, true, sizeof(dirtyBanks));
     
     // Register snapshot items
     SnapshotItem items[] = {
         { &state,             sizeof(state),                KEEP_ON_RESET },
         { &baseState,         sizeof(baseState),            KEEP_ON_RESET },
-        { rom,                size,                         KEEP_ON_RESET },
         { NULL,               0,                            0 }};
     
     registerSnapshotItems(items, sizeof(items));
@@ -70,14 +74,76 @@ FlashRom::FlashRom()
 FlashRom::~FlashRom()
 {
     debug(3, "  Releasing FlashRom ...\n");
-    delete[] rom;
+    releaseSectors();
+}
+
+uint8_t *
+FlashRom::erasedBank()
+{
+    static uint8_t *erased = [](){
+        uint8_t *block = new uint8_t[bankSize];
+        memset(block, 0xFF, bankSize);
+        return block;
+    }();
+    
+    return erased;
+}
+
+uint8_t *
+FlashRom::materialize(unsigned sectorNr)
+{
+    assert(sectorNr < numSectors);
+    
+    if (sector[sectorNr] == NULL) {
+        
+        uint8_t *copy = new uint8_t[sectorSize];
+        unsigned first = sectorNr * (unsigned)banksPerSector();
+        
+        for (unsigned i = 0; i < banksPerSector(); i++) {
+            memcpy(copy + i * bankSize, view[first + i], bankSize);
+            view[first + i] = copy + i * bankSize;
+        }
+        sector[sectorNr] = copy;
+        debug(2, "Sector %d has been copied\n", sectorNr);
+    }
+    
+    return sector[sectorNr];
+}
+
+void
+FlashRom::releaseSectors()
+{
+    for (unsigned i = 0; i < numSectors; i++) {
+        delete[] sector[i];
+        sector[i] = NULL;
+    }
 }
 
 void
 FlashRom::loadBank(unsigned bank, uint8_t *data)
 {
     assert(data != NULL);
-    memcpy(rom + bank * 0x2000, data, 0x2000);
+    
+    std::shared_ptr<uint8_t> copy(new uint8_t[bankSize], std::default_delete<uint8_t[]>());
+    memcpy(copy.get(), data, bankSize);
+    loadBank(bank, copy);
+}
+
+void
+FlashRom::loadBank(unsigned bank, std::shared_ptr<uint8_t> data)
+{
+    assert(isBankNumber(bank));
+    assert(data != nullptr);
+    
+    original[bank] = data;
+    dirtyBanks[bank] = true;
+    
+    unsigned sectorNr = bank / (unsigned)banksPerSector();
+    if (sector[sectorNr]) {
+        memcpy(view[bank], data.get(), bankSize);
+    } else {
+        view[bank] = data.get();
+    }
 }
 
 void
@@ -98,7 +164,116 @@ FlashRom::dump()
     msg(" baseState: %d\n", baseState);
     msg("numSectors: %d\n", numSectors);
     msg("sectorSize: %d\n", sectorSize);
-    msg("       rom: %p\n\n", rom);
+    msg("   sectors: ");
+    for (unsigned i = 0; i < numSectors; i++) {
+        msg("%s ", sector[i] ? "copied" : "shared");
+    }
+    msg("\n");
+    msg("   journal: %d entries\n\n", journal.size());
+}
+
+size_t
+FlashRom::stateSize()
+{
+    return VirtualComponent::stateSize() + size;
+}
+
+bool
+FlashRom::hasOriginalData()
+{
+    for (unsigned i = 0; i < numBanks; i++) {
+        if (original[i]) return true;
+    }
+    return false;
+}
+
+void
+FlashRom::didLoadFromBuffer(uint8_t **buffer)
+{
+    bool keepOriginal = hasOriginalData() || !journal.empty();
+    
+    releaseSectors();
+    journal.clear();
+    memset(dirtyBanks, true, sizeof(dirtyBanks));
+    
+    if (!keepOriginal) {
+        
+        // The loaded contents become the original data. Erased banks stay shared.
+        for (unsigned i = 0; i < numBanks; i++) {
+            
+            bool erased = true;
+            for (unsigned j = 0; j < bankSize && erased; j++) {
+                erased = (*buffer)[j] == 0xFF;
+            }
+            if (erased) {
+                original[i] = nullptr;
+                *buffer += bankSize;
+            } else {
+                original[i] = std::shared_ptr<uint8_t>(new uint8_t[bankSize],
+                                                       std::default_delete<uint8_t[]>());
+                readBlock(buffer, original[i].get(), bankSize);
+            }
+            view[i] = originalBank(i);
+        }
+        return;
+    }
+    
+    // Compare the loaded contents with the original data sector by sector
+    for (unsigned s = 0; s < numSectors; s++) {
+        
+        unsigned first = s * (unsigned)banksPerSector();
+        
+        bool modified = false;
+        for (unsigned i = 0; i < banksPerSector() && !modified; i++) {
+            modified = memcmp(*buffer + i * bankSize, originalBank(first + i), bankSize) != 0;
+        }
+        
+        if (!modified) {
+            for (unsigned i = 0; i < banksPerSector(); i++) {
+                view[first + i] = originalBank(first + i);
+            }
+            *buffer += sectorSize;
+            continue;
+        }
+        
+        // Read the sector into a private copy
+        sector[s] = new uint8_t[sectorSize];
+        readBlock(buffer, sector[s], sectorSize);
+        for (unsigned i = 0; i < banksPerSector(); i++) {
+            view[first + i] = sector[s] + i * bankSize;
+        }
+        
+        // Record how the sector can be derived from the original data
+        uint32_t start = s * (uint32_t)sectorSize;
+        journal.push_back({ start, 0xFF, FLASH_OP_SECTOR_ERASE });
+        for (uint32_t j = 0; j < sectorSize; j++) {
+            if (sector[s][j] != 0xFF) {
+                journal.push_back({ start + j, sector[s][j], FLASH_OP_PROGRAM });
+            }
+        }
+    }
+}
+
+void
+FlashRom::didSaveToBuffer(uint8_t **buffer)
+{
+    for (unsigned i = 0; i < numBanks; i++) {
+        writeBlock(buffer, view[i], bankSize);
+    }
+}
+
+uint64_t
+FlashRom::fingerprint()
+{
+    for (unsigned i = 0; i < numBanks; i++) {
+        if (dirtyBanks[i]) {
+            bankFingerprints[i] = fnv_1a(view[i], bankSize);
+            dirtyBanks[i] = false;
+        }
+    }
+    
+    uint64_t hash = fingerprintItems(0xcbf29ce484222325);
+    return fnv_1a((uint8_t *)bankFingerprints, sizeof(bankFingerprints), hash);
 }
 
 uint8_t
@@ -123,42 +298,42 @@ FlashRom::peek(uint32_t addr)
             case 2:
             return 0;
         }
-        return rom[addr];
+        return view[addr / bankSize][addr % bankSize];
         
         case FLASH_BYTE_PROGRAM_ERROR:
         
         // TODO
-        result = rom[addr];
+        result = view[addr / bankSize][addr % bankSize];
         break;
         
         case FLASH_SECTOR_ERASE_SUSPEND:
         
         // TODO
-        result = rom[addr];
+        result = view[addr / bankSize][addr % bankSize];
         break;
         
         case FLASH_CHIP_ERASE:
         
         // TODO
-        result = rom[addr];
+        result = view[addr / bankSize][addr % bankSize];
         break;
         
         case FLASH_SECTOR_ERASE:
         
         // TODO
-        result = rom[addr];
+        result = view[addr / bankSize][addr % bankSize];
         break;
         
         case FLASH_SECTOR_ERASE_TIMEOUT:
         
         // TODO
-        result = rom[addr];
+        result = view[addr / bankSize][addr % bankSize];
         break;
         
         default:
         
         // TODO
-        result = rom[addr];
+        result = view[addr / bankSize][addr % bankSize];
         break;
     }
     
@@ -306,15 +481,28 @@ FlashRom::doByteProgram(uint32_t addr, uint8_t value)
 {
     assert(addr < size);
     
-    rom[addr] &= value;
-    return rom[addr] == value;
+    uint8_t *data = materialize((unsigned)(addr / sectorSize)) + addr % sectorSize;
+    journal.push_back({ addr, value, FLASH_OP_PROGRAM });
+    dirtyBanks[addr / bankSize] = true;
+    
+    *data &= value;
+    return *data == value;
 }
 
 void
 FlashRom::doChipErase() {
     
     debug("Erasing chip ...\n");
-    memset(rom, 0xFF, size);
+    
+    releaseSectors();
+    for (unsigned i = 0; i < numBanks; i++) {
+        view[i] = erasedBank();
+    }
+    memset(dirtyBanks, true, sizeof(dirtyBanks));
+    
+    // Former operations are overridden
+    journal.clear();
+    journal.push_back({ 0, 0xFF, FLASH_OP_CHIP_ERASE });
 }
 
 void
@@ -322,6 +510,69 @@ FlashRom::doSectorErase(uint32_t addr)
 {
     assert(addr < size);
     
-    debug("Erasing sector %d ... %d\n", addr >> 4);
-    memset(rom + (addr & 0x0000), 0xFF, sectorSize);
+    unsigned sectorNr = (unsigned)(addr / sectorSize);
+    unsigned first = sectorNr * (unsigned)banksPerSector();
+    
+    debug("Erasing sector %d\n", sectorNr);
+    
+    delete[] sector[sectorNr];
+    sector[sectorNr] = NULL;
+    for (unsigned i = 0; i < banksPerSector(); i++) {
+        view[first + i] = erasedBank();
+        dirtyBanks[first + i] = true;
+    }
+    
+    // Former operations on this sector are overridden
+    uint32_t start = sectorNr * (uint32_t)sectorSize;
+    uint32_t end = start + (uint32_t)sectorSize;
+    auto overridden = [start, end](const FlashJournalEntry &e) {
+        return e.op != FLASH_OP_CHIP_ERASE && e.addr >= start && e.addr < end; };
+    journal.erase(std::remove_if(journal.begin(), journal.end(), overridden), journal.end());
+    journal.push_back({ start, 0xFF, FLASH_OP_SECTOR_ERASE });
+}
+
+void
+FlashRom::replay(const FlashJournalEntry &entry)
+{
+    switch (entry.op) {
+            
+        case FLASH_OP_PROGRAM:
+            if (entry.addr < size) doByteProgram(entry.addr, entry.value);
+            break;
+            
+        case FLASH_OP_SECTOR_ERASE:
+            if (entry.addr < size) doSectorErase(entry.addr);
+            break;
+            
+        case FLASH_OP_CHIP_ERASE:
+            doChipErase();
+            break;
+            
+        default:
+            warn("Ignoring unknown journal entry (op = %d)\n", entry.op);
+    }
+}
+
+void
+FlashRom::saveJournalToBuffer(uint8_t **buffer)
+{
+    write32(buffer, (uint32_t)journal.size());
+    for (auto &entry : journal) {
+        write32(buffer, entry.addr);
+        write8(buffer, entry.value);
+        write8(buffer, entry.op);
+    }
+}
+
+void
+FlashRom::loadJournalFromBuffer(uint8_t **buffer)
+{
+    uint32_t count = read32(buffer);
+    for (uint32_t i = 0; i < count; i++) {
+        FlashJournalEntry entry;
+        entry.addr = read32(buffer);
+        entry.value = read8(buffer);
+        entry.op = read8(buffer);
+        replay(entry);
+    }
 }
@@ -22,6 +22,8 @@
 #define _FLASHROM_INC
 
 #include "VirtualComponent.h"
+#include <memory>
+#include <vector>
 
 /*! @brief    This class implements a Flash Rom module of type Am29F040B
  *  @details  Flash Rom modules of this type are used, e.g., by the EasyFlash
@@ -29,6 +31,13 @@
  *            The implementation is based on the following ressources:
  *            29F040.pdf:     Data sheet published by AMD
  *            flash040core.c: Part of the VICE emulator
+ *
+ *            The Rom contents are stored sparsely. Each 8 KB bank refers to
+ *            the original data (usually the chip packets of a CRT file) or
+ *            to a shared block of erased cells. A private copy of a sector is
+ *            created on the first program operation, only. All program and
+ *            erase operations are recorded in a journal which describes the
+ *            modifications relative to the original data.
  */
 class FlashRom : public VirtualComponent {
     
@@ -51,6 +60,30 @@ class FlashRom : public VirtualComponent {
         FLASH_SECTOR_ERASE_SUSPEND
     } FlashRomState;
     
+    public:
+    
+    //! @brief    Operations recorded in the write journal
+    typedef enum {
+        FLASH_OP_PROGRAM = 0,
+        FLASH_OP_SECTOR_ERASE,
+        FLASH_OP_CHIP_ERASE
+    } FlashOperation;
+    
+    //! @brief    A single journal entry
+    typedef struct {
+        uint32_t addr;
+        uint8_t value;
+        uint8_t op;
+    } FlashJournalEntry;
+    
+    private:
+    
+    //! @brief    Size of a single bank in bytes
+    static const size_t bankSize = 0x2000; // 8 KB
+    
+    //! @brief    Number of banks in this Flash Rom
+    static const size_t numBanks = 64;
+    
     //! @brief    Current Flash Rom state
     FlashRomState state;
 
@@ -66,8 +99,45 @@ class FlashRom : public VirtualComponent {
     //! @brief    Total size of the Flash Rom in bytes
     size_t size; // 512 KB
     
-    //! @brief    Flash Rom data
-    uint8_t *rom;
+    //! @brief    Original contents of each bank (NULL = erased)
+    std::shared_ptr<uint8_t> original[numBanks];
+    
+    //! @brief    Private sector copies (NULL = sector has not been programmed)
+    uint8_t *sector[8];
+    
+    /*! @brief    Current contents of each bank
+     *  @details  Points into a private sector copy, into the original data, or
+     *            to the shared block of erased cells.
+     */
+    uint8_t *view[numBanks];
+    
+    //! @brief    Banks that have been modified since the last fingerprint
+    bool dirtyBanks[numBanks];
+    
+    //! @brief    Fingerprints of all banks (valid if not dirty)
+    uint64_t bankFingerprints[numBanks];
+    
+    //! @brief    Program and erase operations since the original data was loaded
+    std::vector<FlashJournalEntry> journal;
+    
+    //! @brief    Returns a read-only block of bankSize erased cells.
+    static uint8_t *erasedBank();
+    
+    //! @brief    Returns the number of banks per sector
+    size_t banksPerSector() { return sectorSize / bankSize; }
+    
+    //! @brief    Creates a private copy of a sector if none exists.
+    uint8_t *materialize(unsigned sectorNr);
+    
+    //! @brief    Deletes all private sector copies.
+    void releaseSectors();
+    
+    //! @brief    Returns the original contents of a bank
+    uint8_t *originalBank(unsigned bank) {
+        return original[bank] ? original[bank].get() : erasedBank(); }
+    
+    //! @brief    Returns true if no original data has been loaded
+    bool hasOriginalData();
     
     public:
     
@@ -93,10 +163,16 @@ class FlashRom : public VirtualComponent {
     ~FlashRom();
     
     /*! @brief    Loads an 8 KB chunk of Rom data from a buffer.
-     *  @details  This method is used when loading the contents from a CRT file.
+     *  @details  The data is copied.
      */
     void loadBank(unsigned bank, uint8_t *data);
     
+    /*! @brief    Loads an 8 KB chunk of Rom data from a shared buffer.
+     *  @details  This method is used when loading the contents from a CRT
+     *            file. The data is referenced in place and never modified.
+     */
+    void loadBank(unsigned bank, std::shared_ptr<uint8_t> data);
+    
     
     //
     //! @functiongroup Methods from VirtualComponent
@@ -104,6 +180,26 @@ class FlashRom : public VirtualComponent {
     
     void reset();
     void dump();
+    size_t stateSize();
+    
+    /*! @brief    Method from VirtualComponent
+     *  @details  Snapshots contain the current Rom contents. If the Rom has
+     *            no original data yet (e.g., it belongs to a newly created
+     *            cartridge), the loaded contents become the original data.
+     *            Otherwise, the original data is kept and the journal is
+     *            rebuilt relative to it. Each modified sector is recorded as
+     *            a sector erase followed by programming all cells that are
+     *            not erased.
+     */
+    void didLoadFromBuffer(uint8_t **buffer);
+    void didSaveToBuffer(uint8_t **buffer);
+    
+    /*! @brief    Method from VirtualComponent
+     *  @details  Only banks that have been modified since the last call are
+     *            rehashed.
+     */
+    uint64_t fingerprint();
+    
     
     //
     //! @functiongroup Accessing Rom cells
@@ -123,6 +219,14 @@ class FlashRom : public VirtualComponent {
     uint8_t spypeek(unsigned bank, uint16_t addr) {
         assert(isBankNumber(bank)); return peek(bank * 0x2000 + addr); }
     
+    /*! @brief    Returns a pointer to the data of an 8 KB bank
+     *  @return   NULL, if reading the bank has side effects or returns
+     *            something else than the stored data (autoselect mode).
+     */
+    uint8_t *bankData(unsigned bank) {
+        assert(isBankNumber(bank));
+        return state == FLASH_AUTOSELECT ? NULL : view[bank]; }
+    
     //! @brief    Writes a Rom cell
     void poke(uint32_t addr, uint8_t value);
     
@@ -157,6 +261,37 @@ class FlashRom : public VirtualComponent {
     
     //! @brief    Performs a "Chip Erase" operation
     void doChipErase();
+    
+    
+    //
+    //! @functiongroup Accessing the write journal
+    //
+    
+    //! @brief    Returns all program and erase operations performed so far
+    const std::vector<FlashJournalEntry> &getJournal() { return journal; }
+    
+    //! @brief    Returns the number of recorded operations
+    size_t journalLength() { return journal.size(); }
+    
+    /*! @brief    Empties the journal
+     *  @details  Call this function after the journal has been persisted.
+     */
+    void clearJournal() { journal.clear(); }
+    
+    //! @brief    Performs a recorded operation again
+    void replay(const FlashJournalEntry &entry);
+    
+    //! @brief    Returns the number of bytes needed to serialize the journal
+    size_t journalStateSize() { return 4 + 6 * journal.size(); }
+    
+    //! @brief    Serializes the journal
+    void saveJournalToBuffer(uint8_t **buffer);
+    
+    /*! @brief    Reads a serialized journal and replays all operations
+     *  @details  The Rom has to contain the same original data as the Rom the
+     *            journal has been recorded with.
+     */
+    void loadJournalFromBuffer(uint8_t **buffer);
 };
 
 #endif 
@@ -0,0 +1,425 @@
+/*!
+ * @header      PagedRam.cpp
+ * @author      Dirk W. Hoffmann, www.dirkwhoffmann.de
+ * @copyright   Dirk W. Hoffmann. All rights reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "PagedRam.h"
+
+// Page encodings used in snapshots
+#define PAGE_FILLED 0
+#define PAGE_RAW    1
+#define PAGE_PACKED 2
+
+PagedRam::PagedRam()
+{
+    setDescription("PagedRam");
+    debug(3, "  Creating PagedRam at address %p...\n", this);
+
+    // Register snapshot items
+    SnapshotItem items[] = {
+        { &capacity,          sizeof(capacity),             KEEP_ON_RESET },
+        { &fillValue,         sizeof(fillValue),            KEEP_ON_RESET },
+        { &compression,       sizeof(compression),          KEEP_ON_RESET },
+        { NULL,               0,                            0 }};
+
+    registerSnapshotItems(items, sizeof(items));
+}
+
+PagedRam::~PagedRam()
+{
+    debug(3, "  Releasing PagedRam ...\n");
+    setCapacity(0);
+}
+
+void
+PagedRam::setCapacity(uint32_t bytes)
+{
+    assert((bytes & (bytes - 1)) == 0);
+    assert(bytes == 0 || bytes >= pageSize);
+
+    if (pages) {
+        for (unsigned i = 0; i < numPages; i++) release(pages[i]);
+        delete[] pages;
+        pages = NULL;
+    }
+
+    capacity = bytes;
+    numPages = bytes / pageSize;
+
+    if (numPages) {
+        pages = new Page[numPages];
+        memset(pages, 0, numPages * sizeof(Page));
+        for (unsigned i = 0; i < numPages; i++) pages[i].dirty = true;
+    }
+}
+
+void
+PagedRam::erase(uint8_t value)
+{
+    for (unsigned i = 0; i < numPages; i++) {
+        release(pages[i]);
+        pages[i].dirty = true;
+    }
+    fillValue = value;
+}
+
+void
+PagedRam::release(Page &page)
+{
+    delete[] page.data;
+    delete[] page.packed;
+    page.data = NULL;
+    page.packed = NULL;
+    page.packedSize = 0;
+}
+
+uint8_t *
+PagedRam::materialize(Page &page)
+{
+    if (page.data) return page.data;
+
+    page.data = new uint8_t[pageSize];
+
+    if (page.packed) {
+
+        size_t size = rleDecode(page.packed, page.packedSize, page.data, pageSize);
+        assert(size == pageSize); (void)size;
+        delete[] page.packed;
+        page.packed = NULL;
+        page.packedSize = 0;
+
+    } else {
+
+        memset(page.data, fillValue, pageSize);
+    }
+
+    return page.data;
+}
+
+void
+PagedRam::compress(Page &page)
+{
+    if (page.data == NULL) return;
+
+    // Free the page if it contains the fill value, only
+    bool filled = true;
+    for (unsigned i = 0; i < pageSize && filled; i++) {
+        filled = page.data[i] == fillValue;
+    }
+    if (filled) {
+        release(page);
+        return;
+    }
+
+    // Keep the page unpacked if it doesn't compress well. To avoid trying
+    // again in every scan, the page is treated as recently used.
+    uint8_t buffer[pageSize];
+    size_t size = rleEncode(page.data, pageSize, buffer, pageSize / 2);
+    if (size == 0) {
+        page.lastUse = frame;
+        return;
+    }
+
+    page.packed = new uint8_t[size];
+    page.packedSize = (uint32_t)size;
+    memcpy(page.packed, buffer, size);
+    delete[] page.data;
+    page.data = NULL;
+}
+
+void
+PagedRam::execute()
+{
+    frame++;
+
+    // Scan for idle pages every 16 frames
+    if (!compression || (frame & 0xF) != 0) return;
+
+    for (unsigned i = 0; i < numPages; i++) {
+        if (pages[i].data && frame - pages[i].lastUse >= idleFrames) {
+            compress(pages[i]);
+        }
+    }
+}
+
+uint64_t
+PagedRam::fingerprint()
+{
+    uint64_t hash = fingerprintItems(0xcbf29ce484222325);
+
+    for (unsigned i = 0; i < numPages; i++) {
+
+        Page &page = pages[i];
+
+        if (page.dirty) {
+
+            uint8_t buffer[pageSize];
+
+            if (page.data) {
+                page.hash = fnv_1a(page.data, pageSize);
+            } else if (page.packed) {
+                rleDecode(page.packed, page.packedSize, buffer, pageSize);
+                page.hash = fnv_1a(buffer, pageSize);
+            } else {
+                memset(buffer, fillValue, pageSize);
+                page.hash = fnv_1a(buffer, pageSize);
+            }
+            page.dirty = false;
+        }
+        hash = combineFingerprints(hash, page.hash);
+    }
+
+    return hash;
+}
+
+void
+PagedRam::setCompression(bool value)
+{
+    compression = value;
+
+    // Unpack everything if compression is switched off
+    if (!value) {
+        for (unsigned i = 0; i < numPages; i++) {
+            if (pages[i].packed) materialize(pages[i]);
+        }
+    }
+}
+
+size_t
+PagedRam::residentBytes()
+{
+    size_t result = 0;
+
+    for (unsigned i = 0; i < numPages; i++) {
+        if (pages[i].data) result += pageSize;
+        if (pages[i].packed) result += pages[i].packedSize;
+    }
+    return result;
+}
+
+void
+PagedRam::dump()
+{
+    unsigned resident = 0, packed = 0, dirty = 0;
+
+    for (unsigned i = 0; i < numPages; i++) {
+        if (pages[i].data) resident++;
+        if (pages[i].packed) packed++;
+        if (pages[i].dirty) dirty++;
+    }
+
+    msg("PagedRam\n");
+    msg("--------\n\n");
+    msg("   capacity: %d KB (%d pages)\n", capacity / 1024, numPages);
+    msg("  fillValue: %02X\n", fillValue);
+    msg("compression: %s\n", compression ? "yes" : "no");
+    msg("   resident: %d pages\n", resident);
+    msg("     packed: %d pages\n", packed);
+    msg("      dirty: %d pages\n", dirty);
+    msg("      bytes: %d\n\n", residentBytes());
+}
+
+uint8_t
+PagedRam::spypeek(uint32_t addr)
+{
+    Page &page = pageOf(addr);
+
+    if (page.data) return page.data[addr % pageSize];
+    if (page.packed == NULL) return fillValue;
+
+    uint8_t buffer[pageSize];
+    rleDecode(page.packed, page.packedSize, buffer, pageSize);
+    return buffer[addr % pageSize];
+}
+
+void
+PagedRam::read(uint32_t addr, uint8_t *dst, uint32_t length)
+{
+    while (length) {
+
+        uint32_t offset = addr % pageSize;
+        uint32_t chunk = MIN(length, pageSize - offset);
+        Page &page = pageOf(addr);
+
+        page.lastUse = frame;
+        if (page.data || page.packed) {
+            memcpy(dst, materialize(page) + offset, chunk);
+        } else {
+            memset(dst, fillValue, chunk);
+        }
+
+        addr += chunk;
+        dst += chunk;
+        length -= chunk;
+    }
+}
+
+void
+PagedRam::write(uint32_t addr, const uint8_t *src, uint32_t length)
+{
+    while (length) {
+
+        uint32_t offset = addr % pageSize;
+        uint32_t chunk = MIN(length, pageSize - offset);
+        Page &page = pageOf(addr);
+
+        page.lastUse = frame;
+        page.dirty = true;
+        memcpy(materialize(page) + offset, src, chunk);
+
+        addr += chunk;
+        src += chunk;
+        length -= chunk;
+    }
+}
+
+uint32_t
+PagedRam::compare(uint32_t addr, const uint8_t *src, uint32_t length)
+{
+    uint32_t result = 0;
+
+    while (length) {
+
+        uint32_t offset = addr % pageSize;
+        uint32_t chunk = MIN(length, pageSize - offset);
+        Page &page = pageOf(addr);
+
+        page.lastUse = frame;
+        for (uint32_t i = 0; i < chunk; i++, result++) {
+            uint8_t value = page.data ? page.data[offset + i] :
+            page.packed ? materialize(page)[offset + i] : fillValue;
+            if (value != src[i]) return result;
+        }
+
+        addr += chunk;
+        src += chunk;
+        length -= chunk;
+    }
+
+    return result;
+}
+
+size_t
+PagedRam::pageStateSize(Page &page)
+{
+    if (page.data) return 5 + pageSize;
+    if (page.packed) return 9 + page.packedSize;
+    return 5;
+}
+
+void
+PagedRam::savePage(uint8_t **buffer, uint32_t nr)
+{
+    Page &page = pages[nr];
+
+    write32(buffer, nr);
+
+    if (page.data) {
+        write8(buffer, PAGE_RAW);
+        writeBlock(buffer, page.data, pageSize);
+    } else if (page.packed) {
+        write8(buffer, PAGE_PACKED);
+        write32(buffer, page.packedSize);
+        writeBlock(buffer, page.packed, page.packedSize);
+    } else {
+        write8(buffer, PAGE_FILLED);
+    }
+}
+
+void
+PagedRam::loadPage(uint8_t **buffer)
+{
+    uint32_t nr = read32(buffer);
+    uint8_t encoding = read8(buffer);
+    uint32_t size = (encoding == PAGE_RAW) ? pageSize :
+    (encoding == PAGE_PACKED) ? read32(buffer) : 0;
+
+    // Skip the page if it doesn't fit in (snapshot is corrupt)
+    if (nr >= numPages || (encoding == PAGE_PACKED && (size == 0 || size > pageSize))) {
+        warn("Skipping invalid page %d (%d bytes)\n", nr, size);
+        *buffer += size;
+        return;
+    }
+
+    Page &page = pages[nr];
+    release(page);
+    page.lastUse = frame;
+    page.dirty = true;
+
+    switch (encoding) {
+
+        case PAGE_RAW:
+            page.data = new uint8_t[pageSize];
+            readBlock(buffer, page.data, pageSize);
+            break;
+
+        case PAGE_PACKED:
+            page.packedSize = size;
+            page.packed = new uint8_t[size];
+            readBlock(buffer, page.packed, size);
+            break;
+
+        default:
+            break;
+    }
+}
+
+size_t
+PagedRam::stateSize()
+{
+    size_t result = VirtualComponent::stateSize() + 4;
+
+    for (unsigned i = 0; i < numPages; i++) {
+        if (pages[i].data || pages[i].packed) result += pageStateSize(pages[i]);
+    }
+    return result;
+}
+
+void
+PagedRam::willLoadFromBuffer(uint8_t **buffer)
+{
+    setCapacity(0);
+}
+
+void
+PagedRam::didLoadFromBuffer(uint8_t **buffer)
+{
+    // Capacity has been restored as a snapshot item. Allocate the page table.
+    uint32_t bytes = capacity;
+    setCapacity(bytes);
+
+    // Read in all pages that are not filled with the fill value
+    uint32_t count = read32(buffer);
+    for (uint32_t i = 0; i < count; i++) {
+        loadPage(buffer);
+    }
+}
+
+void
+PagedRam::didSaveToBuffer(uint8_t **buffer)
+{
+    uint32_t count = 0;
+    for (unsigned i = 0; i < numPages; i++) {
+        if (pages[i].data || pages[i].packed) count++;
+    }
+
+    write32(buffer, count);
+    for (unsigned i = 0; i < numPages; i++) {
+        if (pages[i].data || pages[i].packed) savePage(buffer, i);
+    }
+}
@@ -0,0 +1,211 @@
+/*!
+ * @header      PagedRam.h
+ * @author      Dirk W. Hoffmann, www.dirkwhoffmann.de
+ * @copyright   Dirk W. Hoffmann. All rights reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _PAGEDRAM_INC
+#define _PAGEDRAM_INC
+
+#include "VirtualComponent.h"
+
+/*! @brief    Paged storage for large RAM expansions
+ *  @details  This class is used by RAM expansion cartridges such as GeoRAM
+ *            and the REU. The RAM is split into pages of 4 KB which are
+ *            allocated on the first write. Untouched pages read as the fill
+ *            value and occupy no memory.
+ *            Pages that have not been accessed for a while can be compressed.
+ *            Compressed pages are unpacked transparently on the next access.
+ *            Snapshots contain the pages that are resident, only. Packed
+ *            pages are saved in packed form.
+ */
+class PagedRam : public VirtualComponent {
+
+    public:
+
+    //! @brief    Size of a single page in bytes
+    static const uint32_t pageSize = 0x1000;
+
+    private:
+
+    typedef struct {
+
+        //! @brief    Uncompressed page data (NULL if packed or untouched)
+        uint8_t *data;
+
+        //! @brief    Compressed page data (NULL if unpacked or untouched)
+        uint8_t *packed;
+
+        //! @brief    Size of the compressed data in bytes
+        uint32_t packedSize;
+
+        //! @brief    Indicates if the page has been written since the last fingerprint
+        bool dirty;
+
+        //! @brief    Fingerprint of the page contents (valid if not dirty)
+        uint64_t hash;
+
+        //! @brief    Frame of the most recent access
+        uint64_t lastUse;
+
+    } Page;
+
+    //! @brief    Capacity in bytes (a power of two)
+    uint32_t capacity = 0;
+
+    //! @brief    Number of pages
+    uint32_t numPages = 0;
+
+    //! @brief    The page table
+    Page *pages = NULL;
+
+    //! @brief    Value of all cells in untouched pages
+    uint8_t fillValue = 0xFF;
+
+    //! @brief    Indicates if idle pages get compressed
+    bool compression = false;
+
+    //! @brief    Number of frames a page must be idle to get compressed
+    unsigned idleFrames = 100;
+
+    //! @brief    Frame counter, incremented in execute()
+    uint64_t frame = 0;
+
+    public:
+
+    //
+    //! @functiongroup Creating and destructing
+    //
+
+    //! @brief    Constructor
+    PagedRam();
+
+    //! @brief    Destructor
+    ~PagedRam();
+
+    //! @brief    Sets the capacity in bytes and erases all pages
+    void setCapacity(uint32_t bytes);
+
+    //! @brief    Returns the capacity in bytes
+    uint32_t getCapacity() { return capacity; }
+
+    //! @brief    Sets all cells to the same value
+    void erase(uint8_t value);
+
+
+    //
+    //! @functiongroup Methods from VirtualComponent
+    //
+
+    void dump();
+    size_t stateSize();
+    void willLoadFromBuffer(uint8_t **buffer);
+    void didLoadFromBuffer(uint8_t **buffer);
+    void didSaveToBuffer(uint8_t **buffer);
+
+    /*! @brief    Method from VirtualComponent
+     *  @details  Only pages that have been written since the last call are
+     *            rehashed. The hash depends on the page contents, only.
+     *            Whether a page is packed or not makes no difference.
+     */
+    uint64_t fingerprint();
+
+    /*! @brief    Execution thread callback
+     *  @details  This method is called once per frame. If compression is
+     *            enabled, it compresses all pages that have been idle for a
+     *            while.
+     */
+    void execute();
+
+
+    //
+    //! @functiongroup Accessing RAM cells
+    //
+
+    private:
+
+    //! @brief    Returns the page containing addr (addresses wrap around)
+    Page &pageOf(uint32_t addr) { return pages[(addr & (capacity - 1)) / pageSize]; }
+
+    //! @brief    Makes the page data accessible, allocating or unpacking it
+    uint8_t *materialize(Page &page);
+
+    //! @brief    Compresses a page or frees it if it holds the fill value only
+    void compress(Page &page);
+
+    //! @brief    Frees the memory of a page
+    void release(Page &page);
+
+    public:
+
+    //! @brief    Reads a RAM cell
+    uint8_t peek(uint32_t addr) {
+        Page &page = pageOf(addr);
+        page.lastUse = frame;
+        if (page.data) return page.data[addr % pageSize];
+        return page.packed ? materialize(page)[addr % pageSize] : fillValue;
+    }
+
+    //! @brief    Reads a RAM cell without side effects
+    uint8_t spypeek(uint32_t addr);
+
+    //! @brief    Writes a RAM cell
+    void poke(uint32_t addr, uint8_t value) {
+        Page &page = pageOf(addr);
+        page.lastUse = frame;
+        page.dirty = true;
+        (page.data ? page.data : materialize(page))[addr % pageSize] = value;
+    }
+
+    //! @brief    Copies a block of RAM cells into a buffer
+    void read(uint32_t addr, uint8_t *dst, uint32_t length);
+
+    //! @brief    Copies a buffer into a block of RAM cells
+    void write(uint32_t addr, const uint8_t *src, uint32_t length);
+
+    /*! @brief    Compares a block of RAM cells with a buffer
+     *  @return   Number of matching bytes before the first difference.
+     */
+    uint32_t compare(uint32_t addr, const uint8_t *src, uint32_t length);
+
+
+    //
+    //! @functiongroup Configuring compression
+    //
+
+    bool getCompression() { return compression; }
+    void setCompression(bool value);
+
+    //! @brief    Returns the number of bytes allocated for page data
+    size_t residentBytes();
+
+
+    private:
+
+    //! @brief    Returns the size of a serialized page
+    size_t pageStateSize(Page &page);
+
+    //! @brief    Serializes a page
+    void savePage(uint8_t **buffer, uint32_t nr);
+
+    /*! @brief    Deserializes a page
+     *  @details  Pages with an invalid number or size are skipped.
+     */
+    void loadPage(uint8_t **buffer);
+};
+
+#endif
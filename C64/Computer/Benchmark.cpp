@@ -0,0 +1,603 @@
+/*!
+ * @header      Benchmark.cpp
+ * @author      Dirk W. Hoffmann, www.dirkwhoffmann.de
+ * @copyright   Dirk W. Hoffmann. All rights reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "Benchmark.h"
+#include "C64.h"
+
+//
+// Generated workloads
+//
+
+// Raster interrupt every 8 lines, all sprites enabled, screen updates
+static const uint8_t rasterIrqProgram[] = {
+    0x78,               // C000  SEI
+    0xA9, 0x35,         // C001  LDA #$35        ; RAM and I/O
+    0x85, 0x01,         // C003  STA $01
+    0xA9, 0x7F,         // C005  LDA #$7F        ; Disable CIA interrupts
+    0x8D, 0x0D, 0xDC,   // C007  STA $DC0D
+    0x8D, 0x0D, 0xDD,   // C00A  STA $DD0D
+    0xA9, 0x40,         // C00D  LDA #$40        ; IRQ vector = $C040
+    0x8D, 0xFE, 0xFF,   // C00F  STA $FFFE
+    0xA9, 0xC0,         // C012  LDA #$C0
+    0x8D, 0xFF, 0xFF,   // C014  STA $FFFF
+    0xA9, 0x1B,         // C017  LDA #$1B
+    0x8D, 0x11, 0xD0,   // C019  STA $D011
+    0xA9, 0x40,         // C01C  LDA #$40
+    0x8D, 0x12, 0xD0,   // C01E  STA $D012
+    0xA9, 0x01,         // C021  LDA #$01        ; Enable raster interrupt
+    0x8D, 0x1A, 0xD0,   // C023  STA $D01A
+    0xA9, 0xFF,         // C026  LDA #$FF        ; Enable all sprites
+    0x8D, 0x15, 0xD0,   // C028  STA $D015
+    0xA2, 0x0E,         // C02B  LDX #$0E
+    0xA9, 0x64,         // C02D  LDA #$64        ; Sprite y coordinates
+    0x9D, 0x01, 0xD0,   // C02F  STA $D001,X
+    0xCA,               // C032  DEX
+    0xCA,               // C033  DEX
+    0x10, 0xF9,         // C034  BPL $C02F
+    0x58,               // C036  CLI
+    0xEE, 0x00, 0x04,   // C037  INC $0400
+    0x4C, 0x37, 0xC0,   // C03A  JMP $C037
+    0xEA, 0xEA, 0xEA,   // C03D  NOP NOP NOP
+    0xEE, 0x20, 0xD0,   // C040  INC $D020       ; Interrupt handler
+    0xA9, 0xFF,         // C043  LDA #$FF
+    0x8D, 0x19, 0xD0,   // C045  STA $D019
+    0xAD, 0x12, 0xD0,   // C048  LDA $D012
+    0x18,               // C04B  CLC
+    0x69, 0x08,         // C04C  ADC #$08
+    0x8D, 0x12, 0xD0,   // C04E  STA $D012
+    0x40                // C051  RTI
+};
+
+// Copies the bus lines to the screen while the drive sends data
+static const uint8_t diskLoadProgram[] = {
+    0x78,               // C000  SEI
+    0xA9, 0x35,         // C001  LDA #$35
+    0x85, 0x01,         // C003  STA $01
+    0xAD, 0x00, 0xDD,   // C005  LDA $DD00
+    0x9D, 0x00, 0x04,   // C008  STA $0400,X
+    0xE8,               // C00B  INX
+    0x4C, 0x05, 0xC0    // C00C  JMP $C005
+};
+
+// Drive firmware: reads bytes from disk, puts two bits of each byte on the
+// IEC bus, and moves the head every 4 KB
+static const uint8_t diskLoadFirmware[] = {
+    0x78,               // C000  SEI
+    0xA2, 0xFF,         // C001  LDX #$FF
+    0x9A,               // C003  TXS
+    0xA9, 0x6F,         // C004  LDA #$6F        ; Stepper, motor, LED, density
+    0x8D, 0x02, 0x1C,   // C006  STA $1C02
+    0xA9, 0x6C,         // C009  LDA #$6C        ; Motor on
+    0x8D, 0x00, 0x1C,   // C00B  STA $1C00
+    0xA9, 0x0E,         // C00E  LDA #$0E        ; Enable byte ready
+    0x8D, 0x0C, 0x1C,   // C010  STA $1C0C
+    0xA9, 0x00,         // C013  LDA #$00        ; Read mode
+    0x8D, 0x03, 0x1C,   // C015  STA $1C03
+    0xA9, 0x1A,         // C018  LDA #$1A        ; DATA, CLK, ATNA out
+    0x8D, 0x02, 0x18,   // C01A  STA $1802
+    0x50, 0xFE,         // C01D  BVC $C01D       ; Wait for byte ready
+    0xB8,               // C01F  CLV
+    0xAD, 0x01, 0x1C,   // C020  LDA $1C01
+    0x29, 0x0A,         // C023  AND #$0A
+    0x8D, 0x00, 0x18,   // C025  STA $1800
+    0xE8,               // C028  INX
+    0xD0, 0xF2,         // C029  BNE $C01D
+    0xC8,               // C02B  INY
+    0x98,               // C02C  TYA
+    0x29, 0x0F,         // C02D  AND #$0F
+    0xD0, 0xEC,         // C02F  BNE $C01D
+    0xAD, 0x00, 0x1C,   // C031  LDA $1C00       ; Move the head
+    0x48,               // C034  PHA
+    0x29, 0xFC,         // C035  AND #$FC
+    0x85, 0x00,         // C037  STA $00
+    0x68,               // C039  PLA
+    0x18,               // C03A  CLC
+    0x69, 0x01,         // C03B  ADC #$01
+    0x29, 0x03,         // C03D  AND #$03
+    0x05, 0x00,         // C03F  ORA $00
+    0x8D, 0x00, 0x1C,   // C041  STA $1C00
+    0x4C, 0x1D, 0xC0    // C044  JMP $C01D
+};
+
+// Switches on the datasette motor and counts the tape pulses
+static const uint8_t tapeLoadProgram[] = {
+    0x78,               // C000  SEI
+    0xA9, 0x7F,         // C001  LDA #$7F
+    0x8D, 0x0D, 0xDC,   // C003  STA $DC0D
+    0xA9, 0x15,         // C006  LDA #$15        ; Motor on, RAM and I/O
+    0x85, 0x01,         // C008  STA $01
+    0xA9, 0x11,         // C00A  LDA #$11        ; Start timer A
+    0x8D, 0x0E, 0xDC,   // C00C  STA $DC0E
+    0xAD, 0x0D, 0xDC,   // C00F  LDA $DC0D
+    0x29, 0x10,         // C012  AND #$10        ; Wait for a pulse (FLAG)
+    0xF0, 0xF9,         // C014  BEQ $C00F
+    0xEE, 0x00, 0x04,   // C016  INC $0400
+    0xAD, 0x04, 0xDC,   // C019  LDA $DC04       ; Read the pulse length
+    0x8D, 0x01, 0x04,   // C01C  STA $0401
+    0x4C, 0x0F, 0xC0    // C01F  JMP $C00F
+};
+
+// Plays three voices with sweeping frequencies through the filter
+static const uint8_t sidProgram[] = {
+    0x78,               // C000  SEI
+    0xA9, 0x35,         // C001  LDA #$35
+    0x85, 0x01,         // C003  STA $01
+    0xA9, 0x1F,         // C005  LDA #$1F        ; Low pass, full volume
+    0x8D, 0x18, 0xD4,   // C007  STA $D418
+    0xA9, 0xF7,         // C00A  LDA #$F7        ; Filter all voices
+    0x8D, 0x17, 0xD4,   // C00C  STA $D417
+    0xA2, 0x00,         // C00F  LDX #$00
+    0xA9, 0x09,         // C011  LDA #$09        ; Envelopes
+    0x9D, 0x05, 0xD4,   // C013  STA $D405,X
+    0xA9, 0xF0,         // C016  LDA #$F0
+    0x9D, 0x06, 0xD4,   // C018  STA $D406,X
+    0xA9, 0x08,         // C01B  LDA #$08        ; Pulse width
+    0x9D, 0x03, 0xD4,   // C01D  STA $D403,X
+    0x8A,               // C020  TXA
+    0x18,               // C021  CLC
+    0x69, 0x07,         // C022  ADC #$07
+    0xAA,               // C024  TAX
+    0xE0, 0x15,         // C025  CPX #$15
+    0xD0, 0xE8,         // C027  BNE $C011
+    0xA0, 0x00,         // C029  LDY #$00
+    0x8C, 0x01, 0xD4,   // C02B  STY $D401       ; Frequencies
+    0x98,               // C02E  TYA
+    0x4A,               // C02F  LSR A
+    0x8D, 0x08, 0xD4,   // C030  STA $D408
+    0x4A,               // C033  LSR A
+    0x8D, 0x0F, 0xD4,   // C034  STA $D40F
+    0x98,               // C037  TYA
+    0x8D, 0x16, 0xD4,   // C038  STA $D416       ; Cutoff frequency
+    0x2A,               // C03B  ROL A
+    0x2A,               // C03C  ROL A
+    0x29, 0x01,         // C03D  AND #$01        ; Gate bit
+    0xAA,               // C03F  TAX
+    0x09, 0x40,         // C040  ORA #$40        ; Pulse
+    0x8D, 0x04, 0xD4,   // C042  STA $D404
+    0x8A,               // C045  TXA
+    0x09, 0x20,         // C046  ORA #$20        ; Sawtooth
+    0x8D, 0x0B, 0xD4,   // C048  STA $D40B
+    0x8A,               // C04B  TXA
+    0x09, 0x10,         // C04C  ORA #$10        ; Triangle
+    0x8D, 0x12, 0xD4,   // C04E  STA $D412
+    0xC8,               // C051  INY
+    0xA2, 0x40,         // C052  LDX #$40
+    0xCA,               // C054  DEX
+    0xD0, 0xFD,         // C055  BNE $C054
+    0x4C, 0x2B, 0xC0    // C057  JMP $C02B
+};
+
+// Copies data from all cartridge banks to the screen
+static const uint8_t cartridgeProgram[] = {
+    0x78,               // C000  SEI
+    0xA9, 0x37,         // C001  LDA #$37
+    0x85, 0x01,         // C003  STA $01
+    0xA0, 0x00,         // C005  LDY #$00
+    0x8C, 0x00, 0xDE,   // C007  STY $DE00       ; Switch bank
+    0xA2, 0x00,         // C00A  LDX #$00
+    0xBD, 0x00, 0x80,   // C00C  LDA $8000,X
+    0x9D, 0x00, 0x04,   // C00F  STA $0400,X
+    0xBD, 0x00, 0x9F,   // C012  LDA $9F00,X
+    0x9D, 0x00, 0x05,   // C015  STA $0500,X
+    0xE8,               // C018  INX
+    0xD0, 0xF1,         // C019  BNE $C00C
+    0xC8,               // C01B  INY
+    0x98,               // C01C  TYA
+    0x29, 0x07,         // C01D  AND #$07
+    0xA8,               // C01F  TAY
+    0x4C, 0x07, 0xC0    // C020  JMP $C007
+};
+
+//! @brief    Number of banks of the generated cartridge
+static const unsigned cartridgeBanks = 8;
+
+//! @brief    Number of pulses on the generated tape
+static const size_t tapePulses = 256 * 1024;
+
+static void
+writeBE(uint8_t *p, uint32_t value, unsigned bytes)
+{
+    for (unsigned i = 0; i < bytes; i++) {
+        p[i] = (uint8_t)(value >> (8 * (bytes - 1 - i)));
+    }
+}
+
+
+//
+// Benchmark
+//
+
+Benchmark::Benchmark()
+{
+    setDescription("Benchmark");
+    memset(results, 0, sizeof(results));
+    memset(baseline, 0, sizeof(baseline));
+}
+
+void
+Benchmark::dump()
+{
+    msg("Benchmark (%d frames, %d warm-up frames):\n", frames, warmupFrames);
+    msg("-----------------------------------------\n\n");
+    msg("%-12s %9s %12s", "Workload", "Frames/s", "Cycles/s");
+    for (unsigned i = 0; i < PROF_COUNT; i++) {
+        msg(" %9s", componentName((ProfiledComponent)i));
+    }
+    msg("\n");
+    
+    for (unsigned w = 0; w < BENCH_COUNT; w++) {
+        
+        BenchmarkResult &r = results[w];
+        if (r.frames == 0) continue;
+        
+        msg("%-12s %9.1f %12.0f", workloadName((BenchmarkWorkload)w),
+            r.framesPerSecond, r.cyclesPerSecond);
+        for (unsigned i = 0; i < PROF_COUNT; i++) {
+            msg(" %8.1f%%", 100.0 * r.split[i]);
+        }
+        msg("\n");
+    }
+    msg("\n");
+}
+
+const char *
+Benchmark::workloadName(BenchmarkWorkload workload)
+{
+    switch (workload) {
+        case BENCH_RASTER_IRQ: return "raster-irq";
+        case BENCH_DISK_LOAD:  return "disk-load";
+        case BENCH_TAPE_LOAD:  return "tape-load";
+        case BENCH_SID:        return "sid";
+        case BENCH_CARTRIDGE:  return "cartridge";
+        default:               return "???";
+    }
+}
+
+const char *
+Benchmark::componentName(ProfiledComponent component)
+{
+    switch (component) {
+        case PROF_VIC:       return "VIC";
+        case PROF_CIA:       return "CIA";
+        case PROF_CPU:       return "CPU";
+        case PROF_DRIVE:     return "Drive";
+        case PROF_DATASETTE: return "Datasette";
+        case PROF_SID:       return "SID";
+        case PROF_OTHER:     return "Other";
+        default:             return "???";
+    }
+}
+
+bool
+Benchmark::setup(C64 *c64, BenchmarkWorkload workload)
+{
+    const uint8_t *program;
+    size_t size;
+    
+    switch (workload) {
+            
+        case BENCH_RASTER_IRQ:
+            
+            program = rasterIrqProgram;
+            size = sizeof(rasterIrqProgram);
+            break;
+            
+        case BENCH_DISK_LOAD: {
+            
+            // Insert a blank disk
+            uint8_t *image = new uint8_t[D64_683_SECTORS]();
+            D64File *disk = D64File::makeWithBuffer(image, D64_683_SECTORS);
+            delete[] image;
+            if (!disk) return false;
+            
+            c64->drive1.prepareToInsert();
+            c64->drive1.insertDisk(disk);
+            delete disk;
+            
+            // Replace the drive firmware
+            memcpy(c64->drive1.mem.rom, diskLoadFirmware, sizeof(diskLoadFirmware));
+            c64->drive1.mem.markAllDirty();
+            c64->drive1.cpu.regPC = 0xC000;
+            
+            program = diskLoadProgram;
+            size = sizeof(diskLoadProgram);
+            break;
+        }
+        case BENCH_TAPE_LOAD: {
+            
+            // Create a tape with short, medium, and long pulses
+            size_t length = 0x14 + tapePulses;
+            uint8_t *image = new uint8_t[length]();
+            memcpy(image, "C64-TAPE-RAW", 12);
+            image[0x0C] = 1;
+            image[0x10] = LO_BYTE(tapePulses);
+            image[0x11] = LO_BYTE(tapePulses >> 8);
+            image[0x12] = LO_BYTE(tapePulses >> 16);
+            image[0x13] = LO_BYTE(tapePulses >> 24);
+            for (size_t i = 0; i < tapePulses; i++) {
+                image[0x14 + i] = 0x30 + 0x13 * ((i * 7 + (i >> 3)) % 3);
+            }
+            
+            TAPFile *tape = TAPFile::makeWithBuffer(image, length);
+            delete[] image;
+            if (!tape) return false;
+            
+            c64->datasette.insertTape(tape);
+            c64->datasette.pressPlay();
+            delete tape;
+            
+            program = tapeLoadProgram;
+            size = sizeof(tapeLoadProgram);
+            break;
+        }
+        case BENCH_SID:
+            
+            c64->sid.setReSID(true);
+            program = sidProgram;
+            size = sizeof(sidProgram);
+            break;
+            
+        case BENCH_CARTRIDGE: {
+            
+            // Create a Magic Desk cartridge
+            size_t packetSize = 0x10 + 0x2000;
+            size_t length = 0x40 + cartridgeBanks * packetSize;
+            uint8_t *image = new uint8_t[length]();
+            memcpy(image, "C64 CARTRIDGE   ", 16);
+            writeBE(image + 0x10, 0x40, 4);
+            writeBE(image + 0x14, 0x0100, 2);
+            writeBE(image + 0x16, CRT_MAGIC_DESK, 2);
+            image[0x18] = 0; // Exrom
+            image[0x19] = 1; // Game
+            strcpy((char *)image + 0x20, "BENCHMARK");
+            
+            for (unsigned bank = 0; bank < cartridgeBanks; bank++) {
+                
+                uint8_t *packet = image + 0x40 + bank * packetSize;
+                memcpy(packet, "CHIP", 4);
+                writeBE(packet + 0x04, (uint32_t)packetSize, 4);
+                writeBE(packet + 0x08, 0, 2);
+                writeBE(packet + 0x0A, bank, 2);
+                writeBE(packet + 0x0C, 0x8000, 2);
+                writeBE(packet + 0x0E, 0x2000, 2);
+                for (unsigned i = 0; i < 0x2000; i++) {
+                    packet[0x10 + i] = (uint8_t)(i * (bank + 1));
+                }
+            }
+            
+            CRTFile *crt = CRTFile::makeWithBuffer(image, length);
+            delete[] image;
+            if (!crt) return false;
+            
+            bool attached = c64->expansionport.attachCartridgeAndReset(crt);
+            delete crt;
+            if (!attached) return false;
+            
+            program = cartridgeProgram;
+            size = sizeof(cartridgeProgram);
+            break;
+        }
+        default:
+            return false;
+    }
+    
+    // Start the program
+    memcpy(c64->mem.ram + 0xC000, program, size);
+    c64->mem.markDirty(0xC000, size);
+    c64->cpu.regPC = 0xC000;
+    
+    return true;
+}
+
+//! @brief    Data shared with the sampling thread
+typedef struct {
+    C64 *c64;
+    volatile bool stop;
+    uint64_t samples[PROF_COUNT];
+} ProfileSamples;
+
+static void *
+sampleThread(void *data)
+{
+    ProfileSamples *s = (ProfileSamples *)data;
+    
+    while (!s->stop) {
+        
+        uint8_t phase = s->c64->profilePhase;
+        if (phase < PROF_COUNT) s->samples[phase]++;
+        sleepMicrosec(20);
+    }
+    return NULL;
+}
+
+bool
+Benchmark::run(BenchmarkWorkload workload)
+{
+    assert(workload < BENCH_COUNT);
+    
+    BenchmarkResult &result = results[workload];
+    memset(&result, 0, sizeof(result));
+    
+    C64 *c64 = new C64();
+    c64->setAlwaysWarp(true);
+    
+    if (!setup(c64, workload)) {
+        warn("Cannot set up workload %s\n", workloadName(workload));
+        delete c64;
+        return false;
+    }
+    
+    bool success = true;
+    for (unsigned i = 0; success && i < warmupFrames; i++) {
+        success = c64->executeOneFrame();
+    }
+    
+    // Measure
+    ProfileSamples samples;
+    memset(&samples, 0, sizeof(samples));
+    samples.c64 = c64;
+    
+    pthread_t sampler;
+    c64->profiling = true;
+    pthread_create(&sampler, NULL, sampleThread, (void *)&samples);
+    
+    uint64_t startCycle = c64->cpu.cycle;
+    uint64_t start = FramePacer::now();
+    for (unsigned i = 0; success && i < frames; i++) {
+        success = c64->executeOneFrame();
+    }
+    uint64_t elapsed = FramePacer::now() - start;
+    
+    samples.stop = true;
+    pthread_join(sampler, NULL);
+    c64->profiling = false;
+    
+    if (!success) {
+        warn("Workload %s has stopped unexpectedly\n", workloadName(workload));
+        delete c64;
+        return false;
+    }
+    
+    // Evaluate
+    uint64_t total = 0;
+    for (unsigned i = 0; i < PROF_COUNT; i++) total += samples.samples[i];
+    for (unsigned i = 0; i < PROF_COUNT; i++) {
+        result.split[i] = total ? (double)samples.samples[i] / total : 0.0;
+    }
+    
+    result.frames = frames;
+    result.cycles = c64->cpu.cycle - startCycle;
+    result.seconds = elapsed / 1000000000.0;
+    result.framesPerSecond = result.seconds > 0 ? frames / result.seconds : 0.0;
+    result.cyclesPerSecond = result.seconds > 0 ? result.cycles / result.seconds : 0.0;
+    result.fingerprint = c64->fingerprint();
+    
+    delete c64;
+    return true;
+}
+
+bool
+Benchmark::runAll()
+{
+    bool success = true;
+    
+    for (unsigned w = 0; w < BENCH_COUNT; w++) {
+        
+        msg("Running %s...\n", workloadName((BenchmarkWorkload)w));
+        success &= run((BenchmarkWorkload)w);
+    }
+    
+    return check() && success;
+}
+
+bool
+Benchmark::loadBaseline(const char *path)
+{
+    assert(path != NULL);
+    
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        warn("Cannot open baseline %s\n", path);
+        return false;
+    }
+    
+    memset(baseline, 0, sizeof(baseline));
+    
+    char line[256], name[32];
+    unsigned long long frames, fingerprint;
+    double cyclesPerSecond;
+    
+    while (fgets(line, sizeof(line), file)) {
+        
+        if (line[0] == '#') continue;
+        if (sscanf(line, "%31s %llu %lf %llx",
+                   name, &frames, &cyclesPerSecond, &fingerprint) != 4) continue;
+        
+        for (unsigned w = 0; w < BENCH_COUNT; w++) {
+            
+            if (strcmp(name, workloadName((BenchmarkWorkload)w)) == 0) {
+                baseline[w].frames = frames;
+                baseline[w].cyclesPerSecond = cyclesPerSecond;
+                baseline[w].fingerprint = fingerprint;
+            }
+        }
+    }
+    
+    fclose(file);
+    return true;
+}
+
+bool
+Benchmark::saveBaseline(const char *path)
+{
+    assert(path != NULL);
+    
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        warn("Cannot create baseline %s\n", path);
+        return false;
+    }
+    
+    fprintf(file, "# VirtualC64 benchmark baseline\n");
+    fprintf(file, "# workload frames cycles/s fingerprint\n");
+    
+    for (unsigned w = 0; w < BENCH_COUNT; w++) {
+        
+        BenchmarkResult &r = results[w];
+        if (r.frames == 0) continue;
+        
+        fprintf(file, "%s %llu %.0f %016llX\n", workloadName((BenchmarkWorkload)w),
+                (unsigned long long)r.frames, r.cyclesPerSecond,
+                (unsigned long long)r.fingerprint);
+    }
+    
+    bool result = !ferror(file);
+    fclose(file);
+    return result;
+}
+
+bool
+Benchmark::check()
+{
+    bool success = true;
+    
+    for (unsigned w = 0; w < BENCH_COUNT; w++) {
+        
+        BenchmarkResult &r = results[w];
+        BenchmarkResult &b = baseline[w];
+        const char *name = workloadName((BenchmarkWorkload)w);
+        
+        if (r.frames == 0 || b.frames == 0) continue;
+        
+        double change = 100.0 * (r.cyclesPerSecond / b.cyclesPerSecond - 1.0);
+        if (change < -tolerance) {
+            warn("%s: %.1f%% slower than the baseline\n", name, -change);
+            success = false;
+        }
+        
+        // The emulator state can only be compared after the same number of frames
+        if (r.frames == b.frames && r.fingerprint != b.fingerprint) {
+            warn("%s: Emulator state differs from the baseline\n", name);
+            success = false;
+        }
+    }
+    
+    return success;
+}
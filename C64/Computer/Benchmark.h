@@ -0,0 +1,134 @@
+/*!
+ * @header      Benchmark.h
+ * @author      Dirk W. Hoffmann, www.dirkwhoffmann.de
+ * @copyright   Dirk W. Hoffmann. All rights reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _BENCHMARK_INC
+#define _BENCHMARK_INC
+
+#include "VC64Object.h"
+#include "Benchmark_types.h"
+
+class C64;
+
+/*! @brief    Measures the emulation speed with a fixed set of workloads
+ *  @details  Each workload runs on a separate C64 instance. No execution
+ *            thread is started, so the suite also runs headlessly. All
+ *            programs, disks, tapes, and cartridges are generated, so no
+ *            ROM images are needed. The CPU starts directly in the generated
+ *            code. The emulator runs in warp mode for a number of warm-up
+ *            frames, then for a fixed number of measured frames.
+ *
+ *            While the frames are measured, a sampling thread checks which
+ *            component is being executed (see C64::profilePhase). The
+ *            result is the time split between the components. Drives
+ *            executed on the threads of the drive scheduler are not sampled.
+ *
+ *            Results can be saved as a baseline and compared with later
+ *            runs. A run fails if a workload is slower than the baseline by
+ *            more than the tolerance. It also fails if the emulator state
+ *            after the last frame differs from the baseline, because the
+ *            emulation is no longer cycle-exact to the old version. Save a
+ *            new baseline if the change was intended.
+ */
+class Benchmark : public VC64Object {
+    
+    //! @brief    Number of measured frames per workload
+    unsigned frames = 500;
+    
+    //! @brief    Number of frames executed before measuring
+    unsigned warmupFrames = 50;
+    
+    //! @brief    Tolerated slowdown in percent
+    double tolerance = 10.0;
+    
+    //! @brief    Results of the most recent run
+    BenchmarkResult results[BENCH_COUNT];
+    
+    //! @brief    Reference results (frames is 0 for missing entries)
+    BenchmarkResult baseline[BENCH_COUNT];
+    
+    public:
+    
+    //! @brief    Constructor
+    Benchmark();
+    
+    //! @brief    Prints the results of the most recent run
+    void dump();
+    
+    //! @brief    Returns a short name of a workload (used in baseline files)
+    static const char *workloadName(BenchmarkWorkload workload);
+    
+    //! @brief    Returns the name of a profiled component
+    static const char *componentName(ProfiledComponent component);
+    
+    
+    //
+    //! @functiongroup Configuring
+    //
+    
+    unsigned getFrames() { return frames; }
+    void setFrames(unsigned value) { frames = value; }
+    
+    unsigned getWarmupFrames() { return warmupFrames; }
+    void setWarmupFrames(unsigned value) { warmupFrames = value; }
+    
+    double getTolerance() { return tolerance; }
+    void setTolerance(double percent) { tolerance = percent; }
+    
+    
+    //
+    //! @functiongroup Running
+    //
+    
+    //! @brief    Runs a single workload
+    bool run(BenchmarkWorkload workload);
+    
+    /*! @brief    Runs all workloads and compares them with the baseline
+     *  @return   false, if a workload failed or a regression was found.
+     */
+    bool runAll();
+    
+    //! @brief    Returns the result of a workload
+    BenchmarkResult getResult(BenchmarkWorkload workload) { return results[workload]; }
+    
+    
+    //
+    //! @functiongroup Comparing with a baseline
+    //
+    
+    //! @brief    Reads the baseline from a file
+    bool loadBaseline(const char *path);
+    
+    //! @brief    Writes the results of the most recent run as baseline
+    bool saveBaseline(const char *path);
+    
+    /*! @brief    Compares the results with the baseline
+     *  @details  Workloads that have not been run or have no baseline entry
+     *            are skipped.
+     *  @return   false, if a regression was found.
+     */
+    bool check();
+    
+    private:
+    
+    //! @brief    Prepares a C64 for running a workload
+    bool setup(C64 *c64, BenchmarkWorkload workload);
+};
+
+#endif
@@ -0,0 +1,70 @@
+/*!
+ * @header      Benchmark_types.h
+ * @author      Dirk W. Hoffmann, www.dirkwhoffmann.de
+ * @copyright   Dirk W. Hoffmann. All rights reserved.
+ */
+/*              This program is free software; you can redistribute it and/or modify
+ *              it under the terms of the GNU General Public License as published by
+ *              the Free Software Foundation; either version 2 of the License, or
+ *              (at your option) any later version.
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *              GNU General Public License for more details.
+ *
+ *              You should have received a copy of the GNU General Public License
+ *              along with this program; if not, write to the Free Software
+ *              Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef BENCHMARK_TYPES_H
+#define BENCHMARK_TYPES_H
+
+//! @brief    Workloads of the benchmark suite
+typedef enum {
+    BENCH_RASTER_IRQ = 0,  //!< Raster interrupts, sprites, and border effects
+    BENCH_DISK_LOAD,       //!< Drive reading a disk and driving the IEC bus
+    BENCH_TAPE_LOAD,       //!< Datasette feeding pulses into CIA 1
+    BENCH_SID,             //!< Three voices with sweeping frequencies and filter
+    BENCH_CARTRIDGE,       //!< Bank switching Magic Desk cartridge
+    BENCH_COUNT
+} BenchmarkWorkload;
+
+//! @brief    Components distinguished by the profiler
+typedef enum {
+    PROF_VIC = 0,          //!< VICII
+    PROF_CIA,              //!< Both CIAs
+    PROF_CPU,              //!< C64 CPU and memory accesses
+    PROF_DRIVE,            //!< Floppy drives and IEC bus
+    PROF_DATASETTE,        //!< Datasette
+    PROF_SID,              //!< SID
+    PROF_OTHER,            //!< Rasterline and frame management
+    PROF_COUNT
+} ProfiledComponent;
+
+//! @brief    Result of a single benchmark workload
+typedef struct {
+    
+    //! @brief    Number of measured frames (0 if the workload has not been run)
+    uint64_t frames;
+    
+    //! @brief    Number of measured CPU cycles
+    uint64_t cycles;
+    
+    //! @brief    Measured wall clock time in seconds
+    double seconds;
+    
+    //! @brief    Emulation speed
+    double framesPerSecond;
+    double cyclesPerSecond;
+    
+    //! @brief    Share of each component in the measured time (0.0 to 1.0)
+    double split[PROF_COUNT];
+    
+    //! @brief    Fingerprint of the emulator state after the last frame
+    uint64_t fingerprint;
+    
+} BenchmarkResult;
+
+#endif
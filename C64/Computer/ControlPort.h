@@ -76,6 +76,9 @@ public:
     //! @brief    Method from VirtualComponent
     void dump();
     
+    //! @brief    Returns the number of the represented control port (1 or 2)
+    int getNr() { return nr; }
+    
     //! @brief   Returns true if auto-fire mode is enabled.
     bool getAutofire() { return autofire; }
 
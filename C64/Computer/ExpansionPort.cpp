@@ -48,6 +48,7 @@ ExpansionPort::reset()
     if (cartridge) {
         cartridge->reset();
         cartridge->resetCartConfig();
+        updateRomPages();
     } else {
         setCartridgeMode(CRT_OFF);
     }
@@ -76,6 +77,7 @@ ExpansionPort::didLoadFromBuffer(uint8_t **buffer)
     if (cartridge != NULL) {
         delete cartridge;
         cartridge = NULL;
+        updateRomPages();
     }
     
     // Read cartridge type and cartridge (if any)
@@ -84,6 +86,8 @@ ExpansionPort::didLoadFromBuffer(uint8_t **buffer)
         cartridge = Cartridge::makeWithType(c64, cartridgeType);
         cartridge->loadFromBuffer(buffer);
     }
+    
+    updateRomPages();
 }
 
 void
@@ -95,6 +99,15 @@ ExpansionPort::didSaveToBuffer(uint8_t **buffer)
         cartridge->saveToBuffer(buffer);
 }
 
+uint64_t
+ExpansionPort::fingerprint()
+{
+    uint64_t hash = fingerprintItems(0xcbf29ce484222325);
+    
+    hash = combineFingerprints(hash, getCartridgeType());
+    return cartridge ? combineFingerprints(hash, cartridge->fingerprint()) : hash;
+}
+
 void
 ExpansionPort::dump()
 {
@@ -117,6 +130,22 @@ ExpansionPort::getCartridgeType()
     return cartridge ? cartridge->getCartridgeType() : CRT_NONE;
 }
 
+void
+ExpansionPort::updateRomPages()
+{
+    uint8_t **crtRom = c64->mem.crtRom;
+    
+    if (cartridge) {
+        for (unsigned page = 0x8; page <= 0xF; page++) {
+            if (page != 0xC && page != 0xD) {
+                crtRom[page] = cartridge->romPage(page);
+            }
+        }
+    } else {
+        memset(crtRom, 0, sizeof(c64->mem.crtRom));
+    }
+}
+
 uint8_t
 ExpansionPort::peek(uint16_t addr)
 {
@@ -186,6 +215,7 @@ ExpansionPort::poke(uint16_t addr, uint8_t value)
         cartridge->poke(addr, value);
     } else if (!c64->getUltimax()) {
         c64->mem.ram[addr] = value;
+        c64->mem.markDirty(addr);
     }
 }
 
@@ -205,6 +235,12 @@ ExpansionPort::pokeIO2(uint16_t addr, uint8_t value)
     if (cartridge) cartridge->pokeIO2(addr, value);
 }
 
+void
+ExpansionPort::pokeFF00()
+{
+    if (cartridge) cartridge->pokeFF00();
+}
+
 void
 ExpansionPort::setGameLine(bool value)
 {
@@ -270,6 +306,7 @@ ExpansionPort::attachCartridge(Cartridge *c)
     
     // Reset cartridge to update exrom and game line on the expansion port
     cartridge->reset();
+    updateRomPages();
     
     c64->putMessage(MSG_CARTRIDGE);
     if (cartridge->hasSwitch()) c64->putMessage(MSG_CART_SWITCH);
@@ -283,6 +320,12 @@ ExpansionPort::attachCartridgeAndReset(CRTFile *file)
 {
     assert(file != NULL);
     
+    // The file might have been truncated on disk since it has been scanned
+    if (!file->isIntact()) {
+        warn("Cannot attach cartridge. The CRT file has been truncated.\n");
+        return false;
+    }
+    
     Cartridge *cartridge = Cartridge::makeWithCRTFile(c64, file);
     
     if (cartridge) {
@@ -308,15 +351,34 @@ ExpansionPort::attachGeoRamCartridge(uint32_t capacity)
             return false;
     }
     
-    Cartridge *geoRAM = Cartridge::makeWithType(c64, CRT_GEO_RAM);
+    GeoRAM *geoRAM = (GeoRAM *)Cartridge::makeWithType(c64, CRT_GEO_RAM);
     uint32_t capacityInBytes = capacity * 1024;
-    geoRAM->setRamCapacity(capacityInBytes);
+    geoRAM->setCapacity(capacityInBytes);
     debug("Created GeoRAM cartridge (%d KB)\n", capacity);
     
     attachCartridge(geoRAM);
     return true;
 }
 
+bool
+ExpansionPort::attachReuCartridge(uint32_t capacity)
+{
+    switch (capacity) {
+        case 128: case 256: case 512:
+            break;
+        default:
+            warn("Cannot create REU of size %d\n", capacity);
+            return false;
+    }
+    
+    REU *reu = (REU *)Cartridge::makeWithType(c64, CRT_REU);
+    reu->setCapacity(capacity * 1024);
+    debug("Created REU (%d KB)\n", capacity);
+    
+    attachCartridge(reu);
+    return true;
+}
+
 void
 ExpansionPort::attachIsepicCartridge()
 {
@@ -335,6 +397,7 @@ ExpansionPort::detachCartridge()
         
         delete cartridge;
         cartridge = NULL;
+        updateRomPages();
         
         setCartridgeMode(CRT_OFF);
         
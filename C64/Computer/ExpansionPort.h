@@ -82,6 +82,12 @@ public:
     //! @brief    Method from VirtualComponent
     void didSaveToBuffer(uint8_t **buffer);
     
+    /*! @brief    Method from VirtualComponent
+     *  @details  The attached cartridge is fingerprinted by its own function
+     *            which avoids serializing Rom packets and RAM expansions.
+     */
+    uint64_t fingerprint();
+    
     //! @brief    Method from VirtualComponent
     void dump();	
     
@@ -117,6 +123,16 @@ public:
     //! @brief    Poke fallthrough for I/O space 2
     void pokeIO2(uint16_t addr, uint8_t value);
     
+    //! @brief    Informs the cartridge about a write access to $FF00
+    void pokeFF00();
+    
+    /*! @brief    Updates the direct ROM pointers in the C64 memory
+     *  @details  This function is called whenever the ROM mapping of the
+     *            attached cartridge changes, e.g., after a bank switch.
+     *  @seealso  Cartridge::romPage
+     */
+    void updateRomPages();
+    
     //! @brief    Returns the cartridge type
     CartridgeType getCartridgeType();
     
@@ -171,6 +187,11 @@ public:
     
     //! @brief    Creates and attaches a GeoRAM cartridge
     bool attachGeoRamCartridge(uint32_t capacity);
+    
+    /*! @brief    Creates and attaches a RAM Expansion Unit
+     *  @param    capacity is 128 (1700), 256 (1764), or 512 (1750) KB.
+     */
+    bool attachReuCartridge(uint32_t capacity);
 
     //! @brief    Creates and attaches an Isepic cartridge
     void attachIsepicCartridge();
@@ -31,7 +31,8 @@ IEC::IEC()
         { &clockLine,           sizeof(clockLine),              CLEAR_ON_RESET },
         { &dataLine,            sizeof(dataLine),               CLEAR_ON_RESET },
         { &isDirtyC64Side,      sizeof(isDirtyC64Side),         CLEAR_ON_RESET },
-        { &isDirtyDriveSide,    sizeof(isDirtyDriveSide),       CLEAR_ON_RESET },
+        { &isDirtyDrive1Side,   sizeof(isDirtyDrive1Side),      CLEAR_ON_RESET },
+        { &isDirtyDrive2Side,   sizeof(isDirtyDrive2Side),      CLEAR_ON_RESET },
 
         { &device1Atn,          sizeof(device1Atn),             CLEAR_ON_RESET },
         { &device1Clock,        sizeof(device1Clock),           CLEAR_ON_RESET },
@@ -100,6 +101,35 @@ IEC::dump()
     msg("   Bus activity : %d\n", busActivity); 
 
     msg("\n");
+    
+    if (trace.isRecording() || !trace.getEvents().empty()) {
+        trace.dump(c64->frequency);
+    }
+}
+
+void
+IEC::setRecording(bool value)
+{
+    c64->suspend();
+    value ? trace.startRecording() : trace.stopRecording();
+    c64->resume();
+}
+
+bool
+IEC::saveRecording(const char *path)
+{
+    c64->suspend();
+    bool result = trace.writeToFile(path);
+    c64->resume();
+    return result;
+}
+
+void
+IEC::dumpRecording(bool verbose)
+{
+    c64->suspend();
+    trace.dump(c64->frequency, verbose);
+    c64->resume();
 }
 
 void 
@@ -153,9 +183,10 @@ bool IEC::_updateIecLines()
 }
 
 void
-IEC::updateIecLines()
+IEC::updateIecLines(uint8_t source)
 {
 	bool signals_changed;
+    bool oldAtnLine = atnLine;
 
 	// Update bus lines
 	signals_changed = _updateIecLines();	
@@ -164,14 +195,21 @@ IEC::updateIecLines()
         
         c64->cia2.updatePA();
         
-        // ATN signal is connected to CA1 pin of VIA 1
-        c64->drive1.via1.CA1action(!atnLine);
-        c64->drive2.via1.CA1action(!atnLine);
+        // ATN signal is connected to CA1 pin of VIA 1. It is driven by the
+        // C64, only. Hence, a drive never touches the VIA of the other drive.
+        if (atnLine != oldAtnLine) {
+            c64->drive1.via1.CA1action(!atnLine);
+            c64->drive2.via1.CA1action(!atnLine);
+        }
         
         if (tracingEnabled()) {
             dumpTrace();
         }
         
+        if (trace.isRecording()) {
+            recordEvent(source);
+        }
+        
 		if (busActivity == 0) {
             
             // Reset watchdog counter
@@ -188,6 +226,29 @@ IEC::updateIecLines()
 	}
 }
 
+void
+IEC::recordEvent(uint8_t source)
+{
+    uint64_t c64Cycle, driveCycle;
+    uint8_t lines =
+    (atnLine ? IEC_ATN : 0) | (clockLine ? IEC_CLOCK : 0) | (dataLine ? IEC_DATA : 0);
+    
+    if (source == 0) {
+        
+        // The drives have caught up with the C64 when the C64 changes a line
+        c64Cycle = c64->cpu.cycle;
+        driveCycle = c64->drive1.isPoweredOn() ? c64->drive1.cpu.cycle : c64->drive2.cpu.cycle;
+        
+    } else {
+        
+        // The drive may lag behind the C64
+        c64Cycle = c64->driveScheduler.currentCycle(source);
+        driveCycle = (source == 1) ? c64->drive1.cpu.cycle : c64->drive2.cpu.cycle;
+    }
+    
+    trace.record(c64Cycle, driveCycle, lines, source);
+}
+
 void
 IEC::updateIecLinesC64Side()
 {
@@ -197,27 +258,38 @@ IEC::updateIecLinesC64Side()
     ciaClock = !!(ciaBits & 0x10);
     ciaData = !!(ciaBits & 0x20);
     
-    updateIecLines();
+    updateIecLines(0);
     isDirtyC64Side = false;
 }
 
 void
-IEC::updateIecLinesDriveSide()
+IEC::updateIecLinesDriveSide(unsigned nr)
 {
-    // Get bus signals from drive 1
-    uint8_t device1Bits = c64->drive1.via1.getPB();
-    device1Atn = !!(device1Bits & 0x10);
-    device1Clock = !!(device1Bits & 0x08);
-    device1Data = !!(device1Bits & 0x02);
-
-    // Get bus signals from drive 2
-    uint8_t device2Bits = c64->drive2.via1.getPB();
-    device2Atn = !!(device2Bits & 0x10);
-    device2Clock = !!(device2Bits & 0x08);
-    device2Data = !!(device2Bits & 0x02);
+    // Wait until the other drive has caught up
+    c64->driveScheduler.waitForBus(nr);
     
-    updateIecLines();
-    isDirtyDriveSide = false;
+    if (nr == 1) {
+        
+        // Get bus signals from drive 1
+        uint8_t device1Bits = c64->drive1.via1.getPB();
+        device1Atn = !!(device1Bits & 0x10);
+        device1Clock = !!(device1Bits & 0x08);
+        device1Data = !!(device1Bits & 0x02);
+        
+        updateIecLines(1);
+        isDirtyDrive1Side = false;
+        
+    } else {
+        
+        // Get bus signals from drive 2
+        uint8_t device2Bits = c64->drive2.via1.getPB();
+        device2Atn = !!(device2Bits & 0x10);
+        device2Clock = !!(device2Bits & 0x08);
+        device2Data = !!(device2Bits & 0x02);
+        
+        updateIecLines(2);
+        isDirtyDrive2Side = false;
+    }
 }
 
 void
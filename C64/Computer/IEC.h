@@ -22,6 +22,7 @@
 #define _IEC_INC
 
 #include "VirtualComponent.h"
+#include "IECTrace.h"
 
 class IEC : public VirtualComponent {
 
@@ -43,10 +44,13 @@ public:
     bool isDirtyC64Side;
 
     /*! @brief    Indicates if the bus lines variables need an undate,
-     *            because the values coming from the drive side have changed.
-     *  @deprecated
+     *            because the values coming from drive 1 or drive 2 have
+     *            changed.
+     *  @details  The drives use separate flags, because they may be
+     *            executed by different threads.
      */
-    bool isDirtyDriveSide;
+    bool isDirtyDrive1Side;
+    bool isDirtyDrive2Side;
 
     //! @brief    Bus driving values from drive 1 side
     bool device1Atn;
@@ -63,6 +67,9 @@ public:
     bool ciaClock;
     bool ciaData;
     
+    //! @brief    Records the bus activity
+    IECTrace trace;
+    
 private:
     
 	//! @brief    Used to determine if the bus is idle or if data is transferred
@@ -91,20 +98,34 @@ public:
     //! @brief    Returns true if the IEC currently transfers data.
     bool isBusy() { return busActivity > 0; }
     
+    //! @brief    Starts or stops recording the bus activity.
+    void setRecording(bool value);
+    
+    //! @brief    Saves the recorded bus activity in a file.
+    bool saveRecording(const char *path);
+    
+    //! @brief    Prints the decoded bus activity.
+    void dumpRecording(bool verbose);
+    
     //! @brief    Requensts an update of the bus lines from the C64 side.
     //! @deprecated
     void setNeedsUpdateC64Side() { isDirtyC64Side = true; }
 
-    //! @brief    Requensts an update of the bus lines from the drive side.
-    //! @deprecated
-    void setNeedsUpdateDriveSide() { isDirtyDriveSide = true; }
+    //! @brief    Requensts an update of the bus lines from a drive.
+    void setNeedsUpdateDriveSide(unsigned nr) {
+        if (nr == 1) isDirtyDrive1Side = true; else isDirtyDrive2Side = true; }
+
+    //! @brief    Checks if the bus lines need an update from a drive.
+    bool needsUpdateDriveSide(unsigned nr) {
+        return nr == 1 ? isDirtyDrive1Side : isDirtyDrive2Side; }
 
     //! @brief    Updates all three bus lines.
     /*! @details  The new values are determined by VIA1 (drive side) and
-     *            CIA2 (C64 side).
+     *            CIA2 (C64 side). The drive side function only considers the
+     *            VIA1 of the specified drive.
      */
     void updateIecLinesC64Side();
-    void updateIecLinesDriveSide();
+    void updateIecLinesDriveSide(unsigned nr);
 
 	//! @brief    Execution function for observing the bus activity.
     /*! @details  This method is invoked periodically. It's only purpose is to
@@ -114,7 +135,14 @@ public:
     
 private:
     
-    void updateIecLines();
+    /*! @brief    Updates the bus lines and informs all connected devices
+     *  @param    source    Component that triggered the update (0 = C64,
+     *                      1, 2 = drive)
+     */
+    void updateIecLines(uint8_t source);
+    
+    //! @brief    Records a change of the bus lines
+    void recordEvent(uint8_t source);
     
     //! @brief    Work horse for method updateIecLines
     /*! @details  Returns true if at least one line changed it's value.
@@ -0,0 +1,285 @@
+/*!
+ * @header      IECTrace.cpp
+ * @author      Dirk W. Hoffmann, www.dirkwhoffmann.de
+ * @copyright   Dirk W. Hoffmann. All rights reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "IECTrace.h"
+
+static const uint8_t magicBytes[] = { 'V', 'C', '6', '4', 'I', 'E', 'C', 0x01 };
+
+static void
+writeVarint(FILE *file, uint64_t value)
+{
+    while (value >= 0x80) {
+        fputc((int)(value & 0x7F) | 0x80, file);
+        value >>= 7;
+    }
+    fputc((int)value, file);
+}
+
+static bool
+readVarint(FILE *file, uint64_t *value)
+{
+    int c;
+    *value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        if ((c = fgetc(file)) == EOF) return false;
+        *value |= (uint64_t)(c & 0x7F) << shift;
+        if (!(c & 0x80)) return true;
+    }
+    return false;
+}
+
+IECTrace::IECTrace()
+{
+    setDescription("IECTrace");
+}
+
+void
+IECTrace::startRecording()
+{
+    events.clear();
+    recording = true;
+}
+
+void
+IECTrace::record(uint64_t c64Cycle, uint64_t driveCycle, uint8_t lines, uint8_t source)
+{
+    if (events.size() >= capacity) {
+        warn("IEC trace is full (%zu events). Recording stopped.\n", events.size());
+        recording = false;
+        return;
+    }
+
+    IECEvent event = { c64Cycle, driveCycle, lines, source };
+    events.push_back(event);
+}
+
+bool
+IECTrace::writeToFile(const char *path)
+{
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        warn("Cannot create file %s\n", path);
+        return false;
+    }
+
+    fwrite(magicBytes, 1, sizeof(magicBytes), file);
+
+    uint64_t c64Cycle = 0, driveCycle = 0;
+    for (IECEvent &event : events) {
+
+        // The drive cycle may go backwards if both drives are involved
+        int64_t delta = (int64_t)(event.driveCycle - driveCycle);
+        writeVarint(file, event.c64Cycle - c64Cycle);
+        writeVarint(file, (uint64_t)((delta << 1) ^ (delta >> 63)));
+        fputc(event.lines | (event.source << 4), file);
+
+        c64Cycle = event.c64Cycle;
+        driveCycle = event.driveCycle;
+    }
+
+    bool result = !ferror(file);
+    fclose(file);
+    return result;
+}
+
+bool
+IECTrace::readFromFile(const char *path)
+{
+    uint8_t magic[sizeof(magicBytes)];
+
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        warn("Cannot open file %s\n", path);
+        return false;
+    }
+
+    if (fread(magic, 1, sizeof(magic), file) != sizeof(magic) ||
+        memcmp(magic, magicBytes, sizeof(magic)) != 0) {
+        warn("%s is not an IEC trace file\n", path);
+        fclose(file);
+        return false;
+    }
+
+    recording = false;
+    events.clear();
+
+    uint64_t c64Delta, driveDelta, c64Cycle = 0, driveCycle = 0;
+    int flags;
+    while (readVarint(file, &c64Delta) &&
+           readVarint(file, &driveDelta) &&
+           (flags = fgetc(file)) != EOF) {
+
+        c64Cycle += c64Delta;
+        driveCycle += (uint64_t)((int64_t)(driveDelta >> 1) ^ -(int64_t)(driveDelta & 1));
+
+        IECEvent event = { c64Cycle, driveCycle, (uint8_t)(flags & 0x0F), (uint8_t)(flags >> 4) };
+        events.push_back(event);
+    }
+
+    fclose(file);
+    return true;
+}
+
+std::vector<IECTransfer>
+IECTrace::decode()
+{
+    // Decoder states
+    enum { WAIT, READY, BITS } state = WAIT;
+
+    std::vector<IECTransfer> result;
+    IECTransfer transfer = { 0, 0, 0, false, false };
+    unsigned bits = 0;
+    uint8_t lines = IEC_ATN | IEC_CLOCK | IEC_DATA;
+
+    for (IECEvent &event : events) {
+
+        uint8_t changed = lines ^ event.lines;
+        bool clock = event.lines & IEC_CLOCK;
+        bool data = event.lines & IEC_DATA;
+        lines = event.lines;
+
+        // Asserting or releasing ATN aborts any transfer
+        if (changed & IEC_ATN) {
+            state = WAIT;
+            continue;
+        }
+
+        switch (state) {
+
+            case WAIT:
+
+                // The listener is ready for data if both lines are released
+                if (clock && data) {
+                    transfer.eoi = false;
+                    state = READY;
+                }
+                break;
+
+            case READY:
+
+                // The talker starts sending by pulling the clock line
+                if ((changed & IEC_CLOCK) && !clock) {
+                    transfer.value = 0;
+                    transfer.atn = !(lines & IEC_ATN);
+                    bits = 0;
+                    state = BITS;
+                }
+
+                // If the talker hesitates, the listener signals EOI by
+                // pulling the data line for a moment
+                else if ((changed & IEC_DATA) && !data) {
+                    transfer.eoi = true;
+                }
+                break;
+
+            case BITS:
+
+                // Bits are valid when the clock line is released (LSB first)
+                if ((changed & IEC_CLOCK) && clock) {
+
+                    if (bits == 0) transfer.start = event.c64Cycle;
+                    if (data) transfer.value |= 1 << bits;
+
+                    if (++bits == 8) {
+                        transfer.end = event.c64Cycle;
+                        result.push_back(transfer);
+                        state = WAIT;
+                    }
+                }
+                break;
+        }
+    }
+
+    return result;
+}
+
+const char *
+IECTrace::commandName(uint8_t value)
+{
+    switch (value & 0xF0) {
+        case 0x20:
+        case 0x30: return value == 0x3F ? "UNLISTEN" : "LISTEN";
+        case 0x40:
+        case 0x50: return value == 0x5F ? "UNTALK" : "TALK";
+        case 0x60: return "SECOND";
+        case 0xE0: return "CLOSE";
+        case 0xF0: return "OPEN";
+        default:   return "???";
+    }
+}
+
+void
+IECTrace::dump(uint32_t frequency, bool verbose)
+{
+    std::vector<IECTransfer> transfers = decode();
+
+    // Count line changes
+    unsigned edges[3] = { 0, 0, 0 };
+    unsigned bySource[3] = { 0, 0, 0 };
+    uint8_t lines = IEC_ATN | IEC_CLOCK | IEC_DATA;
+    for (IECEvent &event : events) {
+        uint8_t changed = lines ^ event.lines;
+        for (unsigned i = 0; i < 3; i++) if (changed & (1 << i)) edges[i]++;
+        if (event.source < 3) bySource[event.source]++;
+        lines = event.lines;
+    }
+
+    // Collect transfer statistics
+    unsigned commands = 0, bytes = 0, eois = 0;
+    uint64_t first = 0, last = 0, busy = 0;
+    for (IECTransfer &t : transfers) {
+        if (t.atn) { commands++; continue; }
+        if (bytes++ == 0) first = t.start;
+        last = t.end;
+        busy += t.end - t.start;
+        if (t.eoi) eois++;
+    }
+
+    double seconds = frequency ? (double)(last - first) / frequency : 0.0;
+    uint64_t span = events.empty() ? 0 : events.back().c64Cycle - events.front().c64Cycle;
+
+    msg("IEC trace:\n");
+    msg("----------\n\n");
+    msg("         Events : %zu (%s)\n", events.size(), recording ? "recording" : "stopped");
+    msg("       Duration : %lld cycles\n", span);
+    msg("   Line changes : ATN %d, CLK %d, DATA %d\n", edges[0], edges[1], edges[2]);
+    msg("    Changed by  : C64 %d, drive 1 %d, drive 2 %d\n", bySource[0], bySource[1], bySource[2]);
+    msg("       Commands : %d\n", commands);
+    msg("     Data bytes : %d (%d with EOI)\n", bytes, eois);
+    if (bytes > 1 && seconds > 0.0) {
+        msg("     Throughput : %.1f bytes/sec\n", (bytes - 1) / seconds);
+        msg("  Cycles / byte : %lld (%lld on the wire)\n",
+            (last - first) / (bytes - 1), busy / bytes);
+    }
+    if (bytes == 0 && edges[1] + edges[2] > 0) {
+        msg("                  No standard transfers found (fast loader?)\n");
+    }
+    msg("\n");
+
+    if (!verbose) return;
+
+    for (IECTransfer &t : transfers) {
+        if (t.atn) {
+            msg("%12lld: %s %d (%02X)\n", t.start, commandName(t.value), t.value & 0x0F, t.value);
+        } else {
+            msg("%12lld: %02X%s\n", t.start, t.value, t.eoi ? " EOI" : "");
+        }
+    }
+}
@@ -0,0 +1,147 @@
+/*!
+ * @header      IECTrace.h
+ * @author      Dirk W. Hoffmann, www.dirkwhoffmann.de
+ * @copyright   Dirk W. Hoffmann. All rights reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _IECTRACE_INC
+#define _IECTRACE_INC
+
+#include "VC64Object.h"
+#include <vector>
+
+//! @brief    Bits of IECEvent::lines (set = line released, i.e., high)
+#define IEC_ATN   0x01
+#define IEC_CLOCK 0x02
+#define IEC_DATA  0x04
+
+//! @brief    A single change of the IEC bus lines
+typedef struct {
+
+    //! @brief    C64 cycle in which the lines changed
+    uint64_t c64Cycle;
+
+    //! @brief    Drive cycle in which the lines changed
+    uint64_t driveCycle;
+
+    //! @brief    New state of the bus lines (IEC_ATN | IEC_CLOCK | IEC_DATA)
+    uint8_t lines;
+
+    //! @brief    Component that changed the lines (0 = C64, 1, 2 = drive)
+    uint8_t source;
+
+} IECEvent;
+
+//! @brief    A byte transferred with the standard (Kernal) IEC protocol
+typedef struct {
+
+    //! @brief    C64 cycle in which the first bit was clocked in
+    uint64_t start;
+
+    //! @brief    C64 cycle in which the last bit was clocked in
+    uint64_t end;
+
+    //! @brief    The transferred byte
+    uint8_t value;
+
+    //! @brief    Indicates a command byte (sent while ATN was asserted)
+    bool atn;
+
+    //! @brief    Indicates the last byte of a transmission
+    bool eoi;
+
+} IECTransfer;
+
+/*! @brief    Records the IEC bus and decodes the recorded line changes
+ *  @details  While recording is enabled, IEC::updateIecLines() reports each
+ *            change of the bus lines. The events can be saved in a compact
+ *            binary format and loaded again for offline analysis.
+ *            The decoder follows the standard protocol used by the Kernal
+ *            and the 1541 DOS. Transfers of fast loaders are not decoded,
+ *            but still show up in the line statistics of the summary.
+ */
+class IECTrace : public VC64Object {
+
+    //! @brief    Recorded events in chronological order
+    std::vector<IECEvent> events;
+
+    //! @brief    Indicates if events are recorded
+    bool recording = false;
+
+    //! @brief    Maximum number of recorded events
+    size_t capacity = 1 << 20;
+
+    public:
+
+    //! @brief    Constructor
+    IECTrace();
+
+
+    //
+    //! @functiongroup Recording
+    //
+
+    bool isRecording() { return recording; }
+
+    //! @brief    Deletes all events and starts recording
+    void startRecording();
+
+    //! @brief    Stops recording (the events are kept)
+    void stopRecording() { recording = false; }
+
+    //! @brief    Sets the maximum number of recorded events
+    void setCapacity(size_t value) { capacity = value; }
+
+    //! @brief    Records a change of the bus lines
+    void record(uint64_t c64Cycle, uint64_t driveCycle, uint8_t lines, uint8_t source);
+
+    //! @brief    Returns all recorded events
+    const std::vector<IECEvent> &getEvents() { return events; }
+
+
+    //
+    //! @functiongroup Saving and loading
+    //
+
+    /*! @brief    Writes the trace to a file
+     *  @details  Cycle stamps are stored as variable-length deltas. Hence, a
+     *            typical event occupies three or four bytes.
+     */
+    bool writeToFile(const char *path);
+
+    //! @brief    Replaces the trace by the contents of a file
+    bool readFromFile(const char *path);
+
+
+    //
+    //! @functiongroup Analyzing
+    //
+
+    //! @brief    Decodes all bytes transferred with the standard protocol
+    std::vector<IECTransfer> decode();
+
+    /*! @brief    Prints the decoded transfers and a throughput summary
+     *  @param    frequency    C64 clock frequency in Hz
+     *  @param    verbose      Prints each decoded byte if true
+     */
+    void dump(uint32_t frequency, bool verbose = false);
+
+    //! @brief    Returns a textual description of an ATN command byte
+    static const char *commandName(uint8_t value);
+};
+
+#endif
@@ -0,0 +1,256 @@
+/*!
+ * @header      InputQueue.cpp
+ * @author      Dirk W. Hoffmann, www.dirkwhoffmann.de
+ * @copyright   Dirk W. Hoffmann. All rights reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "C64.h"
+
+// Keyboard matrix layout ('`' marks keys without an ASCII representation)
+static const char *unshiftedKeys[8] = {
+    "`\n``````", "3wa4zse`", "5rd6cftx", "7yg8bhuv",
+    "9ij0mkon", "+pl-.:@,", "`*;``=^/", "1_`2 `q`"
+};
+static const char *shiftedKeys[8] = {
+    "````````", "#``$````", "%``&````", "'``(````",
+    ")```````", "````>[`<", "``]````?", "!``\"````"
+};
+
+// Kernal variables used by the typist
+#define KERNAL_SFDX 0xCB  // Matrix code of the current key (64 = no key)
+#define KERNAL_NDX  0xC6  // Number of characters in the keyboard buffer
+#define KERNAL_XMAX 0x289 // Size of the keyboard buffer
+
+InputQueue::InputQueue()
+{
+    setDescription("InputQueue");
+    debug(3, "  Creating input queue at address %p...\n", this);
+    
+    pthread_mutex_init(&producerLock, NULL);
+    r = 0;
+    w = 0;
+}
+
+InputQueue::~InputQueue()
+{
+    pthread_mutex_destroy(&producerLock);
+}
+
+void
+InputQueue::reset()
+{
+    VirtualComponent::reset();
+    
+    r.store(w.load());
+    pending.clear();
+    typeBuffer.clear();
+    typist = TYPIST_IDLE;
+    typeCycle = 0;
+}
+
+void
+InputQueue::dump()
+{
+    msg("InputQueue:\n");
+    msg("-----------\n\n");
+    msg("       Ring buffer : %d events\n", w.load() - r.load());
+    msg("    Pending events : %d\n", pending.size());
+    if (!pending.empty()) {
+        msg("        Next event : cycle %lld\n", pending.front().cycle);
+    }
+    msg("   Characters left : %d\n", typeBuffer.size());
+    msg("      Typist state : %s\n",
+        typist == TYPIST_IDLE ? "idle" : typist == TYPIST_PRESSED ? "pressed" : "released");
+    msg("      Type timeout : %lld cycles\n\n", typeTimeout);
+}
+
+bool
+InputQueue::put(InputEvent event)
+{
+    pthread_mutex_lock(&producerLock);
+    
+    uint32_t rp = r.load(std::memory_order_acquire);
+    uint32_t wp = w.load(std::memory_order_relaxed);
+    
+    if (wp - rp >= capacity) {
+        pthread_mutex_unlock(&producerLock);
+        warn("Input queue is full. Event is lost.\n");
+        return false;
+    }
+    
+    ring[wp & (capacity - 1)] = event;
+    w.store(wp + 1, std::memory_order_release);
+    
+    pthread_mutex_unlock(&producerLock);
+    return true;
+}
+
+bool
+InputQueue::typeText(const char *text, uint64_t cycle)
+{
+    assert(text != NULL);
+    
+    for (; *text; text++) {
+        if (!put({ cycle, INPUT_TYPE_CHAR, (uint8_t)*text, 0 })) return false;
+    }
+    return true;
+}
+
+bool
+InputQueue::asciiToKey(char c, uint8_t *row, uint8_t *col, bool *shift)
+{
+    if (c == '\r') c = '\n';
+    if (c == '`') return false;
+    c = (char)tolower(c);
+    
+    for (uint8_t i = 0; i < 8; i++) {
+        for (uint8_t j = 0; j < 8; j++) {
+            if (unshiftedKeys[i][j] == c || shiftedKeys[i][j] == c) {
+                *row = i;
+                *col = j;
+                *shift = shiftedKeys[i][j] == c;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void
+InputQueue::execute()
+{
+    uint64_t now = c64->cpu.cycle;
+    
+    // Move all new events into the list of pending events
+    uint32_t rp = r.load(std::memory_order_relaxed);
+    uint32_t wp = w.load(std::memory_order_acquire);
+    for (; rp != wp; rp++) {
+        
+        InputEvent event = ring[rp & (capacity - 1)];
+        if (event.cycle == 0) event.cycle = now;
+        
+        // Keep events with the same cycle stamp in FIFO order
+        auto pos = pending.end();
+        while (pos != pending.begin() && (pos - 1)->cycle > event.cycle) pos--;
+        pending.insert(pos, event);
+    }
+    r.store(rp, std::memory_order_release);
+    
+    // Apply all events that are due
+    size_t due = 0;
+    while (due < pending.size() && pending[due].cycle <= now) {
+        apply(pending[due++]);
+    }
+    pending.erase(pending.begin(), pending.begin() + due);
+    
+    executeTypist();
+}
+
+void
+InputQueue::apply(InputEvent &event)
+{
+    switch (event.type) {
+            
+        case INPUT_PRESS_KEY:
+            c64->keyboard.pressKey(event.a & 7, event.b & 7);
+            break;
+            
+        case INPUT_RELEASE_KEY:
+            c64->keyboard.releaseKey(event.a & 7, event.b & 7);
+            break;
+            
+        case INPUT_RELEASE_ALL:
+            c64->keyboard.releaseAll();
+            c64->putMessage(MSG_KEYMATRIX);
+            break;
+            
+        case INPUT_PRESS_RESTORE:
+            c64->keyboard.pressRestoreKey();
+            break;
+            
+        case INPUT_RELEASE_RESTORE:
+            c64->keyboard.releaseRestoreKey();
+            break;
+            
+        case INPUT_SHIFT_LOCK:
+            c64->keyboard.setShiftLock(event.a != 0);
+            break;
+            
+        case INPUT_JOYSTICK:
+            (event.a == 1 ? c64->port1 : c64->port2).trigger((JoystickEvent)event.b);
+            break;
+            
+        case INPUT_TYPE_CHAR:
+            typeBuffer.push_back(event.a);
+            break;
+    }
+}
+
+void
+InputQueue::executeTypist()
+{
+    uint64_t now = c64->cpu.cycle;
+    uint8_t *ram = c64->mem.ram;
+    
+    switch (typist) {
+            
+        case TYPIST_IDLE:
+        {
+            if (typeBuffer.empty()) return;
+            
+            // Wait until the keyboard buffer has room. Values beyond the
+            // buffer size indicate that the Kernal isn't in charge.
+            uint8_t xmax = ram[KERNAL_XMAX];
+            uint8_t ndx = ram[KERNAL_NDX];
+            if (xmax == 0 || xmax > 10) xmax = 10;
+            if (ndx >= xmax && ndx <= 10) return;
+            
+            char c = (char)typeBuffer.front();
+            typeBuffer.pop_front();
+            if (!asciiToKey(c, &typeRow, &typeCol, &typeShift)) {
+                debug(2, "Cannot type character %02X\n", (uint8_t)c);
+                return;
+            }
+            
+            if (typeShift) c64->keyboard.pressKey(1, 7);
+            c64->keyboard.pressKey(typeRow, typeCol);
+            typist = TYPIST_PRESSED;
+            typeCycle = now;
+            break;
+        }
+            
+        case TYPIST_PRESSED:
+            
+            // Release the key once the Kernal has seen it
+            if (ram[KERNAL_SFDX] == 8 * typeRow + typeCol || now - typeCycle >= typeTimeout) {
+                c64->keyboard.releaseKey(typeRow, typeCol);
+                if (typeShift) c64->keyboard.releaseKey(1, 7);
+                typist = TYPIST_RELEASED;
+                typeCycle = now;
+            }
+            break;
+            
+        case TYPIST_RELEASED:
+            
+            // Continue once the Kernal has seen the release
+            if (ram[KERNAL_SFDX] == 64 || now - typeCycle >= typeTimeout) {
+                typist = TYPIST_IDLE;
+                typeCycle = now;
+            }
+            break;
+    }
+}
@@ -0,0 +1,195 @@
+/*!
+ * @header      InputQueue.h
+ * @author      Dirk W. Hoffmann, www.dirkwhoffmann.de
+ * @copyright   Dirk W. Hoffmann. All rights reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _INPUTQUEUE_INC
+#define _INPUTQUEUE_INC
+
+#include "VirtualComponent.h"
+#include "ControlPort_types.h"
+#include <atomic>
+#include <vector>
+#include <deque>
+
+//! @brief    Types of input events
+typedef enum {
+    INPUT_PRESS_KEY,        //!< Presses key (a, b) = (row, column)
+    INPUT_RELEASE_KEY,      //!< Releases key (a, b) = (row, column)
+    INPUT_RELEASE_ALL,      //!< Releases all keys
+    INPUT_PRESS_RESTORE,    //!< Presses the restore key
+    INPUT_RELEASE_RESTORE,  //!< Releases the restore key
+    INPUT_SHIFT_LOCK,       //!< Presses (a = 1) or releases (a = 0) shift lock
+    INPUT_JOYSTICK,         //!< Triggers JoystickEvent b in control port a
+    INPUT_TYPE_CHAR         //!< Types ASCII character a
+} InputEventType;
+
+//! @brief    A scheduled input event
+typedef struct {
+    
+    /*! @brief    CPU cycle in which the event takes effect
+     *  @details  0 means as soon as possible.
+     */
+    uint64_t cycle;
+    
+    InputEventType type;
+    uint8_t a;
+    uint8_t b;
+    
+} InputEvent;
+
+/*! @brief    Feeds keyboard and joystick input into the emulator
+ *  @details  Any thread may put events into a lock-free ring buffer. The
+ *            emulator thread drains the buffer at the beginning of each
+ *            rasterline and applies all events that are due. Hence, input
+ *            always takes effect at a well defined point in time, and
+ *            scripted input with cycle stamps is reproducible.
+ *            Typed characters are handled by a typist that presses a key
+ *            and releases it as soon as the Kernal has picked it up
+ *            (indicated by the current key location $CB). It waits for the key
+ *            to be reported as released before typing the next character.
+ *            If a program doesn't scan the keyboard via the Kernal, the
+ *            typist falls back to fixed timeouts.
+ */
+class InputQueue : public VirtualComponent {
+    
+    private:
+    
+    //! @brief    Capacity of the ring buffer (must be a power of two)
+    static const uint32_t capacity = 1024;
+    
+    //! @brief    The ring buffer
+    InputEvent ring[capacity];
+    
+    //! @brief    Read and write positions of the ring buffer
+    std::atomic<uint32_t> r;
+    std::atomic<uint32_t> w;
+    
+    //! @brief    Serializes multiple producers (never locked by the emulator thread)
+    pthread_mutex_t producerLock;
+    
+    //! @brief    Drained events that are not due yet, sorted by cycle
+    std::vector<InputEvent> pending;
+    
+    //! @brief    Characters waiting to be typed
+    std::deque<uint8_t> typeBuffer;
+    
+    //! @brief    Typist states
+    enum { TYPIST_IDLE, TYPIST_PRESSED, TYPIST_RELEASED } typist = TYPIST_IDLE;
+    
+    //! @brief    Key the typist is currently pressing
+    uint8_t typeRow = 0, typeCol = 0;
+    bool typeShift = false;
+    
+    //! @brief    CPU cycle of the last typist state change
+    uint64_t typeCycle = 0;
+    
+    /*! @brief    Maximum number of cycles a key is held down or released
+     *  @details  The typist waits that long for the Kernal to pick up a
+     *            key change. It doesn't time out while the keyboard buffer
+     *            is full.
+     */
+    uint64_t typeTimeout = 40000;
+    
+    public:
+    
+    //! @brief    Constructor
+    InputQueue();
+    
+    //! @brief    Destructor
+    ~InputQueue();
+    
+    //! @brief    Method from VirtualComponent
+    void reset();
+    
+    //! @brief    Method from VirtualComponent
+    void dump();
+    
+    
+    //
+    //! @functiongroup Putting in events (thread-safe)
+    //
+    
+    /*! @brief    Puts an event into the ring buffer
+     *  @return   false, if the ring buffer is full.
+     */
+    bool put(InputEvent event);
+    
+    bool pressKey(uint8_t row, uint8_t col, uint64_t cycle = 0) {
+        return put({ cycle, INPUT_PRESS_KEY, row, col }); }
+    bool releaseKey(uint8_t row, uint8_t col, uint64_t cycle = 0) {
+        return put({ cycle, INPUT_RELEASE_KEY, row, col }); }
+    bool releaseAll(uint64_t cycle = 0) {
+        return put({ cycle, INPUT_RELEASE_ALL, 0, 0 }); }
+    bool pressRestoreKey(uint64_t cycle = 0) {
+        return put({ cycle, INPUT_PRESS_RESTORE, 0, 0 }); }
+    bool releaseRestoreKey(uint64_t cycle = 0) {
+        return put({ cycle, INPUT_RELEASE_RESTORE, 0, 0 }); }
+    bool setShiftLock(bool value, uint64_t cycle = 0) {
+        return put({ cycle, INPUT_SHIFT_LOCK, (uint8_t)value, 0 }); }
+    bool trigger(unsigned port, JoystickEvent event, uint64_t cycle = 0) {
+        return put({ cycle, INPUT_JOYSTICK, (uint8_t)port, (uint8_t)event }); }
+    
+    /*! @brief    Types an ASCII string
+     *  @details  Letters are typed unshifted, i.e., they show up as upper
+     *            case characters in the C64's default character set. A
+     *            newline is typed as RETURN. Characters without a key are
+     *            skipped.
+     *  @return   false, if the ring buffer ran full.
+     */
+    bool typeText(const char *text, uint64_t cycle = 0);
+    
+    
+    //
+    //! @functiongroup Configuring the typist
+    //
+    
+    uint64_t getTypeTimeout() { return typeTimeout; }
+    void setTypeTimeout(uint64_t cycles) { typeTimeout = cycles; }
+    
+    /*! @brief    Looks up the key of an ASCII character
+     *  @return   false, if the character can't be typed.
+     */
+    static bool asciiToKey(char c, uint8_t *row, uint8_t *col, bool *shift);
+    
+    
+    //
+    //! @functiongroup Draining events (emulator thread)
+    //
+    
+    //! @brief    Returns true if execute() has something to do
+    bool needsService() {
+        return r.load(std::memory_order_relaxed) != w.load(std::memory_order_relaxed)
+        || !pending.empty() || typist != TYPIST_IDLE || !typeBuffer.empty(); }
+    
+    //! @brief    Applies all events that are due
+    void execute();
+    
+    //! @brief    Returns true while the typist has characters to type
+    bool isTyping() { return typist != TYPIST_IDLE || !typeBuffer.empty(); }
+    
+    private:
+    
+    //! @brief    Applies a single event
+    void apply(InputEvent &event);
+    
+    //! @brief    Advances the typist state machine
+    void executeTypist();
+};
+
+#endif
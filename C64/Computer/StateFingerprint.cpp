@@ -0,0 +1,170 @@
+/*!
+ * @header      StateFingerprint.cpp
+ * @author      Dirk W. Hoffmann, www.dirkwhoffmann.de
+ * @copyright   Dirk W. Hoffmann. All rights reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "StateFingerprint.h"
+
+StateFingerprint::StateFingerprint()
+{
+    setDescription("StateFingerprint");
+    pthread_mutex_init(&lock, NULL);
+    history.resize(256);
+}
+
+StateFingerprint::~StateFingerprint()
+{
+    pthread_mutex_destroy(&lock);
+}
+
+void
+StateFingerprint::dump()
+{
+    FrameFingerprint fp;
+    
+    msg("StateFingerprint:\n");
+    msg("-----------------\n\n");
+    msg("         Enabled : %s\n", enabled ? "yes" : "no");
+    msg("        Recorded : %zu of %zu frames\n", size(), getCapacity());
+    
+    if (latest(&fp)) {
+        msg("           Frame : %llu (cycle %llu)\n", fp.frame, fp.cycle);
+        for (unsigned i = 0; i < FP_COMPONENT_COUNT; i++) {
+            msg("%16s : %016llX\n", componentName((FingerprintComponent)i), fp.component[i]);
+        }
+        msg("        Combined : %016llX\n", fp.combined);
+    }
+    msg("\n");
+}
+
+const char *
+StateFingerprint::componentName(FingerprintComponent c)
+{
+    switch (c) {
+        case FP_CPU:    return "CPU";
+        case FP_MEMORY: return "Memory";
+        case FP_VIC:    return "VIC";
+        case FP_CIA1:   return "CIA1";
+        case FP_CIA2:   return "CIA2";
+        case FP_SID:    return "SID";
+        case FP_DRIVE1: return "Drive1";
+        case FP_DRIVE2: return "Drive2";
+        case FP_OTHER:  return "Other";
+        default:        return "???";
+    }
+}
+
+void
+StateFingerprint::setCapacity(size_t frames)
+{
+    pthread_mutex_lock(&lock);
+    history.resize(MAX(frames, 1));
+    first = count = 0;
+    pthread_mutex_unlock(&lock);
+}
+
+void
+StateFingerprint::record(const FrameFingerprint &fp)
+{
+    pthread_mutex_lock(&lock);
+    
+    size_t capacity = history.size();
+    
+    // Start over if the frame counter has been reset
+    if (count && fp.frame <= history[(first + count - 1) % capacity].frame) {
+        first = count = 0;
+    }
+    
+    if (count < capacity) {
+        history[(first + count++) % capacity] = fp;
+    } else {
+        history[first] = fp;
+        first = (first + 1) % capacity;
+    }
+    
+    pthread_mutex_unlock(&lock);
+}
+
+void
+StateFingerprint::clear()
+{
+    pthread_mutex_lock(&lock);
+    first = count = 0;
+    pthread_mutex_unlock(&lock);
+}
+
+size_t
+StateFingerprint::size()
+{
+    pthread_mutex_lock(&lock);
+    size_t result = count;
+    pthread_mutex_unlock(&lock);
+    return result;
+}
+
+bool
+StateFingerprint::get(uint64_t frame, FrameFingerprint *fp)
+{
+    bool result = false;
+    
+    pthread_mutex_lock(&lock);
+    
+    if (count) {
+        
+        // Usually, frames are recorded consecutively
+        uint64_t oldest = history[first].frame;
+        size_t i = (size_t)(frame - oldest);
+        
+        // If not, search the whole buffer
+        if (frame < oldest || i >= count || history[(first + i) % history.size()].frame != frame) {
+            for (i = 0; i < count && history[(first + i) % history.size()].frame != frame; i++);
+        }
+        if (i < count) {
+            *fp = history[(first + i) % history.size()];
+            result = true;
+        }
+    }
+    
+    pthread_mutex_unlock(&lock);
+    return result;
+}
+
+bool
+StateFingerprint::latest(FrameFingerprint *fp)
+{
+    bool result = false;
+    
+    pthread_mutex_lock(&lock);
+    if (count) {
+        *fp = history[(first + count - 1) % history.size()];
+        result = true;
+    }
+    pthread_mutex_unlock(&lock);
+    return result;
+}
+
+uint32_t
+StateFingerprint::diff(const FrameFingerprint &fp1, const FrameFingerprint &fp2)
+{
+    uint32_t result = 0;
+    
+    for (unsigned i = 0; i < FP_COMPONENT_COUNT; i++) {
+        if (fp1.component[i] != fp2.component[i]) result |= 1 << i;
+    }
+    return result;
+}
@@ -0,0 +1,116 @@
+/*!
+ * @header      StateFingerprint.h
+ * @author      Dirk W. Hoffmann, www.dirkwhoffmann.de
+ * @copyright   Dirk W. Hoffmann. All rights reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _STATEFINGERPRINT_INC
+#define _STATEFINGERPRINT_INC
+
+#include "VC64Object.h"
+#include "StateFingerprint_types.h"
+#include <pthread.h>
+#include <vector>
+
+/*! @brief    Records a fingerprint of the emulator state once per frame
+ *  @details  Fingerprints are a cheap alternative to comparing snapshots in
+ *            determinism tests. Two emulator instances are in the same state
+ *            if their fingerprints match (with a very high probability).
+ *            To keep the overhead low, memory arrays are not rehashed as a
+ *            whole. Only memory pages and halftracks that have been written
+ *            since the previous frame are hashed again.
+ *            The most recent fingerprints are kept in a ring buffer which
+ *            can be queried from any thread.
+ */
+class StateFingerprint : public VC64Object {
+    
+    private:
+    
+    //! @brief    Indicates if fingerprints are recorded
+    bool enabled = false;
+    
+    //! @brief    Recorded fingerprints (ring buffer)
+    std::vector<FrameFingerprint> history;
+    
+    //! @brief    Index of the oldest entry and number of entries
+    size_t first = 0;
+    size_t count = 0;
+    
+    //! @brief    Protects the ring buffer
+    pthread_mutex_t lock;
+    
+    public:
+    
+    //! @brief    Constructor
+    StateFingerprint();
+    
+    //! @brief    Destructor
+    ~StateFingerprint();
+    
+    //! @brief    Prints the most recent fingerprint
+    void dump();
+    
+    //! @brief    Returns the name of a component group
+    static const char *componentName(FingerprintComponent c);
+    
+    
+    //
+    //! @functiongroup Configuring
+    //
+    
+    bool isEnabled() { return enabled; }
+    void setEnabled(bool value) { enabled = value; }
+    
+    //! @brief    Returns the number of frames that are kept
+    size_t getCapacity() { return history.size(); }
+    
+    //! @brief    Sets the number of frames that are kept (clears the history)
+    void setCapacity(size_t frames);
+    
+    
+    //
+    //! @functiongroup Recording
+    //
+    
+    /*! @brief    Adds the fingerprint of a finished frame
+     *  @details  If the frame number doesn't increase, e.g., after a reset
+     *            or after loading a snapshot, the history is cleared first.
+     */
+    void record(const FrameFingerprint &fp);
+    
+    //! @brief    Removes all recorded fingerprints
+    void clear();
+    
+    
+    //
+    //! @functiongroup Querying
+    //
+    
+    //! @brief    Returns the number of recorded fingerprints
+    size_t size();
+    
+    //! @brief    Looks up the fingerprint of a frame. Returns false if unknown.
+    bool get(uint64_t frame, FrameFingerprint *fp);
+    
+    //! @brief    Returns the most recent fingerprint. Returns false if none.
+    bool latest(FrameFingerprint *fp);
+    
+    //! @brief    Returns a bit mask of the component groups that differ
+    static uint32_t diff(const FrameFingerprint &fp1, const FrameFingerprint &fp2);
+};
+
+#endif
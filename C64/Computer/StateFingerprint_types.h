@@ -0,0 +1,55 @@
+/*!
+ * @header      StateFingerprint_types.h
+ * @author      Dirk W. Hoffmann, www.dirkwhoffmann.de
+ * @copyright   Dirk W. Hoffmann. All rights reserved.
+ */
+/*              This program is free software; you can redistribute it and/or modify
+ *              it under the terms of the GNU General Public License as published by
+ *              the Free Software Foundation; either version 2 of the License, or
+ *              (at your option) any later version.
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *              GNU General Public License for more details.
+ *
+ *              You should have received a copy of the GNU General Public License
+ *              along with this program; if not, write to the Free Software
+ *              Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef STATEFINGERPRINT_TYPES_H
+#define STATEFINGERPRINT_TYPES_H
+
+//! @brief    Groups of components that are fingerprinted separately
+typedef enum {
+    FP_CPU = 0,       //!< CPU registers and interrupt lines
+    FP_MEMORY,        //!< RAM, color RAM, and memory mapping
+    FP_VIC,           //!< VICII
+    FP_CIA1,          //!< First CIA
+    FP_CIA2,          //!< Second CIA
+    FP_SID,           //!< SID
+    FP_DRIVE1,        //!< First floppy drive including the inserted disk
+    FP_DRIVE2,        //!< Second floppy drive including the inserted disk
+    FP_OTHER,         //!< Ports, cartridge, IEC bus, datasette, and the C64 itself
+    FP_COMPONENT_COUNT
+} FingerprintComponent;
+
+//! @brief    Fingerprint of the emulator state at the end of a frame
+typedef struct {
+    
+    //! @brief    Frame number
+    uint64_t frame;
+    
+    //! @brief    CPU cycle at the end of the frame
+    uint64_t cycle;
+    
+    //! @brief    Fingerprints of the individual components
+    uint64_t component[FP_COMPONENT_COUNT];
+    
+    //! @brief    Fingerprint of the whole emulator state
+    uint64_t combined;
+    
+} FrameFingerprint;
+
+#endif
@@ -0,0 +1,187 @@
+/*!
+ * @header      WarpPolicy.cpp
+ * @author      Dirk W. Hoffmann, www.dirkwhoffmann.de
+ * @copyright   Dirk W. Hoffmann. All rights reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "WarpPolicy.h"
+#include "Memory_types.h"
+
+// Reasons that bypass the hysteresis
+#define IMMEDIATE_REASONS ((1 << WARP_ALWAYS) | (1 << WARP_REQUEST))
+
+WarpPolicy::WarpPolicy()
+{
+    setDescription("WarpPolicy");
+    
+    WarpReasonConfig defaults[WARP_REASON_COUNT] = {
+        { true,  0,   0 },  // WARP_ALWAYS
+        { true,  0,   0 },  // WARP_REQUEST
+        { false, 0,   0 },  // WARP_IEC (the bus keeps itself busy for 30 frames)
+        { false, 0,   25 }, // WARP_TAPE
+        { false, 50,  0 },  // WARP_IDLE
+        { false, 100, 0 }   // WARP_SILENCE
+    };
+    
+    for (unsigned i = 0; i < WARP_REASON_COUNT; i++) {
+        config[i] = defaults[i];
+    }
+    
+    clearStats();
+    reset();
+}
+
+void
+WarpPolicy::reset()
+{
+    for (unsigned i = 0; i < WARP_REASON_COUNT; i++) {
+        present[i] = 0;
+        absent[i] = 0;
+    }
+    active = 0;
+    minPC = 0xFFFF;
+    maxPC = 0x0000;
+}
+
+void
+WarpPolicy::clearStats()
+{
+    for (unsigned i = 0; i < WARP_REASON_COUNT; i++) {
+        stats[i].frames = 0;
+        stats[i].activations = 0;
+    }
+    totalFrames = 0;
+    warpFrames = 0;
+}
+
+const char *
+WarpPolicy::reasonName(WarpReason reason)
+{
+    switch (reason) {
+        case WARP_ALWAYS:  return "Always";
+        case WARP_REQUEST: return "Request";
+        case WARP_IEC:     return "IEC bus";
+        case WARP_TAPE:    return "Datasette";
+        case WARP_IDLE:    return "CPU idle";
+        case WARP_SILENCE: return "SID silence";
+        default:           return "???";
+    }
+}
+
+void
+WarpPolicy::setConfig(WarpReason reason, WarpReasonConfig value)
+{
+    assert(reason < WARP_REASON_COUNT);
+    
+    config[reason] = value;
+    if (!value.enabled) {
+        active &= ~(1 << reason);
+        present[reason] = 0;
+    }
+}
+
+void
+WarpPolicy::setEnabled(WarpReason reason, bool value)
+{
+    WarpReasonConfig c = config[reason];
+    c.enabled = value;
+    setConfig(reason, c);
+}
+
+bool
+WarpPolicy::idleLoopDetected()
+{
+    bool result =
+    maxPC >= minPC &&
+    maxPC - minPC < idleWindow &&
+    !(minPC >= KERNAL_INPUT_LOOP_START && maxPC <= KERNAL_INPUT_LOOP_END);
+    
+    minPC = 0xFFFF;
+    maxPC = 0x0000;
+    return result;
+}
+
+void
+WarpPolicy::update(uint32_t signals)
+{
+    uint32_t old = getActiveReasons();
+    
+    for (unsigned i = 0; i < WARP_REASON_COUNT; i++) {
+        
+        uint32_t bit = 1 << i;
+        if (!config[i].enabled || (bit & IMMEDIATE_REASONS)) continue;
+        
+        if (signals & bit) {
+            
+            absent[i] = 0;
+            if (present[i] < UINT_MAX) present[i]++;
+            if (present[i] > config[i].enterDelay) active |= bit;
+            
+        } else {
+            
+            present[i] = 0;
+            if (absent[i] < UINT_MAX) absent[i]++;
+            if (absent[i] > config[i].exitDelay) active &= ~bit;
+        }
+    }
+    
+    // Update statistics
+    uint32_t now = getActiveReasons();
+    for (unsigned i = 0; i < WARP_REASON_COUNT; i++) {
+        uint32_t bit = 1 << i;
+        if (now & bit) stats[i].frames++;
+        if ((now & bit) && !(old & bit)) stats[i].activations++;
+    }
+    totalFrames++;
+    if (now) warpFrames++;
+}
+
+uint32_t
+WarpPolicy::getActiveReasons()
+{
+    uint32_t result = active;
+    
+    if (always && config[WARP_ALWAYS].enabled) result |= 1 << WARP_ALWAYS;
+    if (requests && config[WARP_REQUEST].enabled) result |= 1 << WARP_REQUEST;
+    
+    return result;
+}
+
+void
+WarpPolicy::dump()
+{
+    uint32_t reasons = getActiveReasons();
+    
+    msg("WarpPolicy:\n");
+    msg("-----------\n\n");
+    msg("         Frames : %lld (%lld in warp mode)\n", totalFrames, warpFrames);
+    msg("       Requests : %d\n", requests);
+    msg("    Idle window : %d bytes\n\n", idleWindow);
+    msg("         Reason   Enabled  Enter   Exit  Active     Frames  Activations\n");
+    
+    for (unsigned i = 0; i < WARP_REASON_COUNT; i++) {
+        msg("%15s   %7s  %5d  %5d  %6s  %9lld  %11lld\n",
+            reasonName((WarpReason)i),
+            config[i].enabled ? "yes" : "no",
+            config[i].enterDelay,
+            config[i].exitDelay,
+            (reasons & (1 << i)) ? "yes" : "no",
+            stats[i].frames,
+            stats[i].activations);
+    }
+    msg("\n");
+}
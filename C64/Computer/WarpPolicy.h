@@ -0,0 +1,167 @@
+/*!
+ * @header      WarpPolicy.h
+ * @author      Dirk W. Hoffmann, www.dirkwhoffmann.de
+ * @copyright   Dirk W. Hoffmann. All rights reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _WARPPOLICY_INC
+#define _WARPPOLICY_INC
+
+#include "VC64Object.h"
+#include "WarpPolicy_types.h"
+
+/*! @brief    Decides when the emulator runs at maximum speed
+ *  @details  Once per frame, the C64 reports which warp signals are present.
+ *            A signal activates its reason after it has been present for
+ *            enterDelay consecutive frames and deactivates it after it has
+ *            been absent for exitDelay consecutive frames. Warp mode is on
+ *            while at least one enabled reason is active.
+ *            WARP_ALWAYS and WARP_REQUEST bypass the hysteresis and take
+ *            effect immediately.
+ *            Idle loops are detected by sampling the program counter once
+ *            per rasterline. If all samples of a frame lie within a small
+ *            window, the CPU is considered idle. The Kernal's keyboard input
+ *            loop is excluded, because it waits for the user.
+ */
+class WarpPolicy : public VC64Object {
+    
+    private:
+    
+    //! @brief    Per-reason configuration
+    WarpReasonConfig config[WARP_REASON_COUNT];
+    
+    //! @brief    Per-reason statistics
+    WarpReasonStats stats[WARP_REASON_COUNT];
+    
+    //! @brief    Number of consecutive frames a signal has been present
+    unsigned present[WARP_REASON_COUNT];
+    
+    //! @brief    Number of consecutive frames a signal has been absent
+    unsigned absent[WARP_REASON_COUNT];
+    
+    //! @brief    Currently active reasons (bit mask)
+    uint32_t active = 0;
+    
+    //! @brief    Indicates that the emulator should always run at maximum speed
+    bool always = false;
+    
+    //! @brief    Number of outstanding warp requests
+    unsigned requests = 0;
+    
+    //! @brief    Lowest and highest program counter sampled in this frame
+    uint16_t minPC = 0xFFFF;
+    uint16_t maxPC = 0x0000;
+    
+    //! @brief    Maximum size of an idle loop in bytes
+    uint16_t idleWindow = 16;
+    
+    //! @brief    Total number of frames and number of frames run in warp mode
+    uint64_t totalFrames = 0;
+    uint64_t warpFrames = 0;
+    
+    public:
+    
+    //! @brief    Constructor
+    WarpPolicy();
+    
+    //! @brief    Clears the hysteresis state (configuration and statistics are kept)
+    void reset();
+    
+    //! @brief    Prints the configuration and the statistics
+    void dump();
+    
+    //! @brief    Returns a textual description of a warp reason
+    static const char *reasonName(WarpReason reason);
+    
+    
+    //
+    //! @functiongroup Configuring
+    //
+    
+    WarpReasonConfig getConfig(WarpReason reason) { return config[reason]; }
+    void setConfig(WarpReason reason, WarpReasonConfig value);
+    
+    bool isEnabled(WarpReason reason) { return config[reason].enabled; }
+    void setEnabled(WarpReason reason, bool value);
+    
+    uint16_t getIdleWindow() { return idleWindow; }
+    void setIdleWindow(uint16_t bytes) { idleWindow = bytes; }
+    
+    
+    //
+    //! @functiongroup Requesting warp mode
+    //
+    
+    //! @brief    Turns the WARP_ALWAYS signal on or off
+    void setAlways(bool value) { always = value; }
+    
+    /*! @brief    Requests warp mode until release() is called
+     *  @details  Requests are counted. Warp mode stays on until each request
+     *            has been released.
+     */
+    void request() { requests++; }
+    
+    //! @brief    Releases a request made with request()
+    void release() { if (requests) requests--; }
+    
+    //! @brief    Returns the number of outstanding requests
+    unsigned getRequests() { return requests; }
+    
+    
+    //
+    //! @functiongroup Evaluating
+    //
+    
+    //! @brief    Indicates if the program counter needs to be sampled
+    bool tracksIdle() { return config[WARP_IDLE].enabled; }
+    
+    //! @brief    Reports the program counter (called once per rasterline)
+    void samplePC(uint16_t pc) {
+        if (pc < minPC) minPC = pc;
+        if (pc > maxPC) maxPC = pc; }
+    
+    /*! @brief    Returns true if the sampled program counters of the current
+     *            frame indicate an idle loop
+     *  @details  The samples are cleared as a side effect.
+     */
+    bool idleLoopDetected();
+    
+    /*! @brief    Feeds in the signals of the frame that has just been finished
+     *  @param    signals  Bit mask with a bit set for each present signal
+     */
+    void update(uint32_t signals);
+    
+    //! @brief    Returns the currently active reasons (bit mask)
+    uint32_t getActiveReasons();
+    
+    //! @brief    Returns true if the emulator should run at maximum speed
+    bool shouldWarp() { return getActiveReasons() != 0; }
+    
+    
+    //
+    //! @functiongroup Querying statistics
+    //
+    
+    WarpReasonStats getStats(WarpReason reason) { return stats[reason]; }
+    uint64_t getTotalFrames() { return totalFrames; }
+    uint64_t getWarpFrames() { return warpFrames; }
+    
+    //! @brief    Clears all statistics
+    void clearStats();
+};
+
+#endif
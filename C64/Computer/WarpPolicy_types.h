@@ -0,0 +1,60 @@
+/*!
+ * @header      WarpPolicy_types.h
+ * @author      Dirk W. Hoffmann, www.dirkwhoffmann.de
+ * @copyright   Dirk W. Hoffmann. All rights reserved.
+ */
+/*              This program is free software; you can redistribute it and/or modify
+ *              it under the terms of the GNU General Public License as published by
+ *              the Free Software Foundation; either version 2 of the License, or
+ *              (at your option) any later version.
+ *
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *              GNU General Public License for more details.
+ *
+ *              You should have received a copy of the GNU General Public License
+ *              along with this program; if not, write to the Free Software
+ *              Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef WARPPOLICY_TYPES_H
+#define WARPPOLICY_TYPES_H
+
+//! @brief    Reasons for running the emulator at maximum speed
+typedef enum {
+    WARP_ALWAYS = 0,  //!< The user wants to run at maximum speed all the time
+    WARP_REQUEST,     //!< Requested via WarpPolicy::request()
+    WARP_IEC,         //!< The IEC bus is busy
+    WARP_TAPE,        //!< The datasette is playing a tape
+    WARP_IDLE,        //!< The CPU is spinning in a tight loop
+    WARP_SILENCE,     //!< SID doesn't produce any sound
+    WARP_REASON_COUNT
+} WarpReason;
+
+//! @brief    Configuration of a single warp reason
+typedef struct {
+    
+    //! @brief    Indicates if the reason is taken into account
+    bool enabled;
+    
+    //! @brief    Number of frames the signal must be present to enable warp
+    unsigned enterDelay;
+    
+    //! @brief    Number of frames warp is kept after the signal has vanished
+    unsigned exitDelay;
+    
+} WarpReasonConfig;
+
+//! @brief    Statistics of a single warp reason
+typedef struct {
+    
+    //! @brief    Number of frames the reason has been active
+    uint64_t frames;
+    
+    //! @brief    Number of times the reason has become active
+    uint64_t activations;
+    
+} WarpReasonStats;
+
+#endif
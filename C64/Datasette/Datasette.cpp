@@ -86,6 +86,7 @@ Datasette::didLoadFromBuffer(uint8_t **buffer)
         data = new uint8_t[size];
         readBlock(buffer, data, size);
     }
+    tapeFingerprint = size ? fnv_1a(data, size) : 0;
 }
 
 void
@@ -120,6 +121,7 @@ Datasette::insertTape(TAPFile *a)
     // Copy data
     data = (uint8_t *)malloc(size);
     memcpy(data, a->getData(), size);
+    tapeFingerprint = fnv_1a(data, size);
 
     // Determine tape length (by fast forwarding)
     rewind();
@@ -153,6 +155,7 @@ Datasette::ejectTape()
     size = 0;
     type = 0;
     durationInCycles = 0;
+    tapeFingerprint = 0;
     head = -1;
 
     c64->putMessage(MSG_VC1530_NO_TAPE);
@@ -33,6 +33,9 @@ class Datasette : public VirtualComponent {
     //! @brief    Data buffer (contains the raw data of the TAP archive)
     uint8_t *data = NULL;
     
+    //! @brief    Fingerprint of the data buffer (the tape is never modified)
+    uint64_t tapeFingerprint = 0;
+    
     //! @brief    Size of the attached data buffer
     uint64_t size = 0;
     
@@ -109,6 +112,9 @@ public:
     size_t stateSize();
     void didLoadFromBuffer(uint8_t **buffer);
     void didSaveToBuffer(uint8_t **buffer);
+    
+    //! @brief    Method from VirtualComponent (uses a cached tape fingerprint)
+    uint64_t fingerprint() { return fingerprintItems(tapeFingerprint); }
 
 
     //
@@ -91,6 +91,7 @@ Disk::Disk()
         { NULL,             0,                      0 }};
     
     registerSnapshotItems(items, sizeof(items));
+    markAllDirty();
 
     // Create bit expansion table
     // Note that this table expects a LITTLE ENDIAN architecture to work. If you compile
@@ -133,6 +134,22 @@ Disk::ping()
     VirtualComponent::ping();
 }
 
+uint64_t
+Disk::fingerprint()
+{
+    // Rehash all modified halftracks
+    for (Halftrack ht = 1; ht <= 84; ht++) {
+        if (dirtyHalftracks[ht]) {
+            halftrackFingerprints[ht] = fnv_1a(data.halftrack[ht], maxBytesOnTrack);
+            dirtyHalftracks[ht] = false;
+        }
+    }
+    uint64_t hash = fnv_1a((uint8_t *)&halftrackFingerprints[1], 84 * sizeof(uint64_t));
+    hash = fnv_1a((uint8_t *)length.halftrack, sizeof(length.halftrack), hash);
+    hash = combineFingerprints(hash, writeProtected);
+    return combineFingerprints(hash, modified);
+}
+
 void
 Disk::setModified(bool b)
 {
@@ -253,6 +270,7 @@ Disk::clearHalftrack(Halftrack ht)
 {
     memset(&data.halftrack[ht], 0x55, sizeof(data.halftrack[ht]));
     length.halftrack[ht] = sizeof(data.halftrack[ht]) * 8;
+    dirtyHalftracks[ht] = true;
 }
 
 void
@@ -649,6 +667,7 @@ Disk::encodeArchive(G64File *a)
             assert(b != -1);
             data.halftrack[ht][i] = (uint8_t)b;
         }
+        dirtyHalftracks[ht] = true;
         assert(a->readHalftrack() == -1 /* EOF */);
     }
 }
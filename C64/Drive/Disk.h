@@ -159,6 +159,14 @@ public:
         };
         uint16_t track[43][2];
     } length;
+    
+    /*! @brief    Halftracks that have been written since the last fingerprint
+     *  @details  Index 0 is unused.
+     */
+    bool dirtyHalftracks[85];
+    
+    //! @brief    Fingerprints of all halftracks
+    uint64_t halftrackFingerprints[85];
 
     
     //
@@ -209,6 +217,16 @@ public:
     
     void dump();
     void ping();
+    void didLoadFromBuffer(uint8_t **buffer) { markAllDirty(); }
+    
+    /*! @brief    Method from VirtualComponent
+     *  @details  Only halftracks that have been written since the last call
+     *            are rehashed.
+     */
+    uint64_t fingerprint();
+    
+    //! @brief    Marks all halftracks as modified
+    void markAllDirty() { memset(dirtyHalftracks, true, sizeof(dirtyHalftracks)); }
 
     
     
@@ -317,6 +335,7 @@ public:
      */
     void _writeBitToHalftrack(Halftrack ht, HeadPosition pos, bool bit) {
         assert(isValidHeadPositon(ht, pos));
+        dirtyHalftracks[ht] = true;
         if (bit) {
             data.halftrack[ht][pos / 8] |= (0x0080 >> (pos % 8));
         } else {
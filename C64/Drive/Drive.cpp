@@ -151,7 +151,7 @@ VC1541::execute(uint64_t duration)
             if (cycle >= via1.wakeUpCycle) via1.execute(); else via1.idleCounter++;
             if (cycle >= via2.wakeUpCycle) via2.execute(); else via2.idleCounter++;
             updateByteReady();
-            if (c64->iec.isDirtyDriveSide) c64->iec.updateIecLinesDriveSide();
+            if (c64->iec.needsUpdateDriveSide(deviceNr)) c64->iec.updateIecLinesDriveSide(deviceNr);
 
             nextClock += 10000;
 
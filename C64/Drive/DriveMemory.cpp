@@ -22,7 +22,7 @@
 
 #include "C64.h"
 
-VC1541Memory::VC1541Memory(VC1541 *drive)
+VC1541Memory::VC1541Memory(VC1541 *drive) : search(ram, sizeof(ram))
 {
     setDescription("1541MEM");
 	debug(3, "  Creating VC1541 memory at %p...\n", this);
@@ -30,6 +30,7 @@ VC1541Memory::VC1541Memory(VC1541 *drive)
     this->drive = drive;
     
     memset(rom, 0, sizeof(rom));
+    memset(pageVersions, 0, sizeof(pageVersions));
     stack = &ram[0x0100];
     
     // Register snapshot items
@@ -56,6 +57,7 @@ VC1541Memory::reset()
     for (unsigned i = 0; i < sizeof(ram); i++) {
         ram[i] = (i & 64) ? 0xFF : 0x00;
     }
+    markAllDirty();
 }
 
 void 
@@ -109,6 +111,18 @@ VC1541Memory::spypeek(uint16_t addr)
     }
 }
 
+uint64_t
+VC1541Memory::pageSignature(uint8_t page)
+{
+    if (page >= 0x80) {
+        return ((uint64_t)romVersion << 8) | M_ROM;
+    }
+    if ((page & 0x1F) < 0x08) {
+        return ((uint64_t)pageVersions[page & 0x07] << 8) | M_RAM;
+    }
+    return 0;
+}
+
 void 
 VC1541Memory::poke(uint16_t addr, uint8_t value)
 {
@@ -121,6 +135,7 @@ VC1541Memory::poke(uint16_t addr, uint8_t value)
     
     if (addr < 0x0800) { // RAM
         ram[addr] = value;
+        pageVersions[addr >> 8]++;
         return;
     }
     
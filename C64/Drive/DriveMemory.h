@@ -23,6 +23,7 @@
 #define _VC1541MEMORY_INC
 
 #include "Memory.h"
+#include "MemorySearch.h"
 
 class VC1541;
 
@@ -43,6 +44,15 @@ class VC1541Memory : public Memory {
     //! @brief    Read Only Memory
     uint8_t rom[0x4000];
     
+    //! @brief    Write counters of all RAM pages
+    uint32_t pageVersions[8];
+    
+    //! @brief    Incremented whenever the ROM changes
+    uint32_t romVersion = 0;
+    
+    //! @brief    Searches RAM for values, patterns, and changes
+    MemorySearch search;
+    
     
     //
     //! @functiongroup Creating and destructing
@@ -61,6 +71,17 @@ class VC1541Memory : public Memory {
 
 	void reset();
 	void dump();
+    
+    void didLoadFromBuffer(uint8_t **buffer) { markAllDirty(); }
+    
+    //! @brief    Method from VirtualComponent (the ROM is not included)
+    uint64_t fingerprint() { return fnv_1a(ram, sizeof(ram)); }
+    
+    //! @brief    Method from Memory (RAM and ROM pages can be cached)
+    uint64_t pageSignature(uint8_t page);
+    
+    //! @brief    Marks all pages as modified (also used when the ROM changes)
+    void markAllDirty() { for (unsigned i = 0; i < 8; i++) pageVersions[i]++; romVersion++; }
 
     
     //
@@ -71,7 +92,7 @@ class VC1541Memory : public Memory {
     bool romIsLoaded() { return rom[0] != 0x00; }
 
     //! @brief    Removes the ROM image from memory
-    void deleteRom() { memset(rom, 0, sizeof(rom)); }
+    void deleteRom() { memset(rom, 0, sizeof(rom)); markAllDirty(); }
 
     /*! @brief    Computes a 64-bit fingerprint for the VC1541 ROM.
      *  @return   fingerprint or 0, if no Basic ROM is installed.
@@ -93,7 +114,8 @@ class VC1541Memory : public Memory {
     
     // Writing into memory
     void poke(uint16_t addr, uint8_t value);
-    void pokeZP(uint8_t addr, uint8_t value) { ram[addr] = value; }
+    void pokeZP(uint8_t addr, uint8_t value) { ram[addr] = value; pageVersions[0]++; }
+    void pokeStack(uint8_t sp, uint8_t value) { stack[sp] = value; pageVersions[1]++; }
 };
 
 #endif
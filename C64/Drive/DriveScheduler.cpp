@@ -0,0 +1,183 @@
+/*!
+ * @header      DriveScheduler.cpp
+ * @author      Dirk W. Hoffmann, www.dirkwhoffmann.de
+ * @copyright   Dirk W. Hoffmann. All rights reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "C64.h"
+#include <sched.h>
+
+// Number of polls before a waiting thread gives up its time slice
+#define SPIN_LIMIT 1000
+
+// Number of polls before the idle worker thread goes to sleep
+#define IDLE_LIMIT 100000
+
+static void *
+runDriveWorker(void *scheduler)
+{
+    ((DriveScheduler *)scheduler)->runWorker();
+    return NULL;
+}
+
+DriveScheduler::DriveScheduler()
+{
+    setDescription("DriveScheduler");
+    pthread_mutex_init(&lock, NULL);
+    pthread_cond_init(&cond, NULL);
+    requested = 0;
+    completed = 0;
+    quit = false;
+    progress[0] = 0;
+    progress[1] = 0;
+}
+
+DriveScheduler::~DriveScheduler()
+{
+    setParallel(false);
+    pthread_cond_destroy(&cond);
+    pthread_mutex_destroy(&lock);
+}
+
+void
+DriveScheduler::setParallel(bool value)
+{
+    if (value == parallel) return;
+    
+    if (value) {
+        
+        quit = false;
+        if (pthread_create(&worker, NULL, runDriveWorker, this) != 0) {
+            warn("Failed to create drive thread. Executing drives serially.\n");
+            return;
+        }
+        
+    } else {
+        
+        pthread_mutex_lock(&lock);
+        quit = true;
+        pthread_cond_signal(&cond);
+        pthread_mutex_unlock(&lock);
+        pthread_join(worker, NULL);
+    }
+    
+    parallel = value;
+    debug(2, "Executing drives %s\n", parallel ? "in parallel" : "serially");
+}
+
+bool
+DriveScheduler::runSlice(VC1541 *drive, unsigned cycles, uint64_t duration,
+                         std::atomic<uint64_t> &counter)
+{
+    bool result = true;
+    
+    for (unsigned i = 0; i < cycles; i++) {
+        result &= drive->execute(duration);
+        counter.store(i + 1, std::memory_order_release);
+    }
+    return result;
+}
+
+bool
+DriveScheduler::execute(VC1541 *drive1, VC1541 *drive2,
+                        uint64_t first, unsigned cycles, uint64_t duration)
+{
+    bool result = true;
+    
+    base = first - 1;
+    progress[0].store(0, std::memory_order_relaxed);
+    progress[1].store(0, std::memory_order_relaxed);
+    
+    // Execute serially if a single drive is connected or the slice is short
+    if (!parallel || serialized || !drive1 || !drive2 || cycles < minParallelCycles) {
+        
+        for (unsigned i = 0; i < cycles; i++) {
+            if (drive1) result &= drive1->execute(duration);
+            if (drive2) result &= drive2->execute(duration);
+            progress[0].store(i + 1, std::memory_order_relaxed);
+            progress[1].store(i + 1, std::memory_order_relaxed);
+        }
+        return result;
+    }
+    
+    // Hand drive 2 over to the worker thread
+    sliceDrive = drive2;
+    sliceCycles = cycles;
+    sliceDuration = duration;
+    active = true;
+    
+    uint64_t slice = requested.load(std::memory_order_relaxed) + 1;
+    pthread_mutex_lock(&lock);
+    requested.store(slice, std::memory_order_release);
+    pthread_cond_signal(&cond);
+    pthread_mutex_unlock(&lock);
+    
+    // Execute drive 1 in this thread
+    result &= runSlice(drive1, cycles, duration, progress[0]);
+    
+    // Wait for the worker thread to finish
+    for (unsigned i = 0; completed.load(std::memory_order_acquire) != slice; i++) {
+        if (i >= SPIN_LIMIT) sched_yield();
+    }
+    
+    active = false;
+    return result && sliceResult;
+}
+
+void
+DriveScheduler::_waitForBus(unsigned nr)
+{
+    assert(nr == 1 || nr == 2);
+    
+    // In serial order, drive 1 executes C64 cycle n after drive 2 has
+    // finished cycle n - 1, and drive 2 executes C64 cycle n after drive 1
+    // has finished cycle n.
+    uint64_t cycle = progress[nr - 1].load(std::memory_order_relaxed);
+    uint64_t needed = (nr == 1) ? cycle : cycle + 1;
+    std::atomic<uint64_t> &other = progress[2 - nr];
+    
+    for (unsigned i = 0; other.load(std::memory_order_acquire) < needed; i++) {
+        if (i >= SPIN_LIMIT) sched_yield();
+    }
+}
+
+void
+DriveScheduler::runWorker()
+{
+    uint64_t slice = completed.load(std::memory_order_relaxed);
+    
+    while (true) {
+        
+        // Wait for the next slice. Poll for a while before going to sleep,
+        // because slices are requested at a high rate.
+        for (unsigned i = 0; requested.load(std::memory_order_acquire) == slice; i++) {
+            
+            if (quit) return;
+            if (i < IDLE_LIMIT) continue;
+            
+            pthread_mutex_lock(&lock);
+            while (requested.load(std::memory_order_acquire) == slice && !quit) {
+                pthread_cond_wait(&cond, &lock);
+            }
+            pthread_mutex_unlock(&lock);
+        }
+        
+        slice = requested.load(std::memory_order_acquire);
+        sliceResult = runSlice(sliceDrive, sliceCycles, sliceDuration, progress[1]);
+        completed.store(slice, std::memory_order_release);
+    }
+}
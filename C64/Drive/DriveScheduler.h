@@ -0,0 +1,154 @@
+/*!
+ * @header      DriveScheduler.h
+ * @author      Dirk W. Hoffmann, www.dirkwhoffmann.de
+ * @copyright   Dirk W. Hoffmann. All rights reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _DRIVESCHEDULER_INC
+#define _DRIVESCHEDULER_INC
+
+#include "VC64Object.h"
+#include <atomic>
+
+class VC1541;
+
+/*! @brief    Executes the pending cycles of both drives
+ *  @details  In serial mode, the drives are executed in the same interleaved
+ *            order as in lockstep mode, i.e., drive 1 executes C64 cycle n
+ *            before drive 2 does, and drive 2 executes C64 cycle n before
+ *            drive 1 executes C64 cycle n + 1.
+ *            In parallel mode, drive 2 is executed by a worker thread while
+ *            the calling thread executes drive 1. Both drives only interact
+ *            with each other via the IEC bus. Before a drive accesses the bus,
+ *            it calls waitForBus() which blocks until the other drive has
+ *            caught up with the serial order. Hence, the bus is accessed in
+ *            exactly the same order as in serial mode and both modes produce
+ *            identical results.
+ */
+class DriveScheduler : public VC64Object {
+    
+    private:
+    
+    //! @brief    Indicates if the drives are executed in parallel
+    bool parallel = false;
+    
+    //! @brief    Indicates if a parallel slice is being executed
+    bool active = false;
+    
+    /*! @brief    Forces serial execution even if parallel mode is enabled
+     *  @details  Set while a CPU trace is recorded, because both drive CPUs
+     *            write into the same trace file.
+     */
+    bool serialized = false;
+    
+    //! @brief    Slices shorter than this are always executed serially
+    unsigned minParallelCycles = 64;
+    
+    //! @brief    The worker thread executing drive 2
+    pthread_t worker;
+    
+    //! @brief    Wakes up the worker thread if it went to sleep
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    
+    //! @brief    Number of the slice to be executed by the worker thread
+    std::atomic<uint64_t> requested;
+    
+    //! @brief    Number of the last slice completed by the worker thread
+    std::atomic<uint64_t> completed;
+    
+    //! @brief    Asks the worker thread to terminate
+    std::atomic<bool> quit;
+    
+    //! @brief    The slice to be executed by the worker thread
+    VC1541 *sliceDrive = NULL;
+    unsigned sliceCycles = 0;
+    uint64_t sliceDuration = 0;
+    bool sliceResult = true;
+    
+    //! @brief    Number of C64 cycles each drive has completed in this slice
+    std::atomic<uint64_t> progress[2];
+    
+    //! @brief    C64 cycle preceding the first cycle of this slice
+    uint64_t base = 0;
+    
+    public:
+    
+    //! @brief    Constructor
+    DriveScheduler();
+    
+    //! @brief    Destructor
+    ~DriveScheduler();
+    
+    
+    //
+    //! @functiongroup Configuring
+    //
+    
+    bool getParallel() { return parallel; }
+    
+    /*! @brief    Enables or disables parallel execution
+     *  @details  The worker thread is created or destroyed accordingly.
+     *            Must not be called while the drives are executed.
+     */
+    void setParallel(bool value);
+    
+    /*! @brief    Forces or stops forcing serial execution
+     *  @details  Must not be called while the drives are executed.
+     */
+    void setSerialized(bool value) { serialized = value; }
+    
+    
+    //
+    //! @functiongroup Executing
+    //
+    
+    /*! @brief    Executes the same number of C64 cycles on both drives
+     *  @param    drive1   NULL, if the drive is powered off
+     *  @param    drive2   NULL, if the drive is powered off
+     *  @param    first    The C64 cycle to start with
+     *  @return   false, if a drive CPU has halted, e.g., on a breakpoint.
+     */
+    bool execute(VC1541 *drive1, VC1541 *drive2,
+                 uint64_t first, unsigned cycles, uint64_t duration);
+    
+    /*! @brief    Returns the C64 cycle a drive is currently executing
+     *  @details  Only meaningful while execute() is running.
+     */
+    uint64_t currentCycle(unsigned nr) {
+        return base + progress[nr - 1].load(std::memory_order_relaxed) + 1; }
+    
+    /*! @brief    Called by a drive before it reads or writes the IEC bus
+     *  @details  This function returns immediately unless a parallel slice
+     *            is being executed.
+     */
+    void waitForBus(unsigned nr) { if (active) _waitForBus(nr); }
+    
+    //! @brief    Entry point of the worker thread
+    void runWorker();
+    
+    private:
+    
+    //! @brief    Work horse for waitForBus()
+    void _waitForBus(unsigned nr);
+    
+    //! @brief    Executes a drive and reports the progress after each cycle
+    bool runSlice(VC1541 *drive, unsigned cycles, uint64_t duration,
+                  std::atomic<uint64_t> &counter);
+};
+
+#endif
@@ -57,7 +57,6 @@ VIA6522::VIA6522(VC1541 *drive)
         { &sr,              sizeof(sr),             CLEAR_ON_RESET },
         { &delay,           sizeof(delay),          CLEAR_ON_RESET },
         { &feed,            sizeof(feed),           CLEAR_ON_RESET },
-        { &tiredness,       sizeof(tiredness),      CLEAR_ON_RESET },
         { &wakeUpCycle,     sizeof(wakeUpCycle),    CLEAR_ON_RESET },
         { &idleCounter,     sizeof(idleCounter),    CLEAR_ON_RESET },
         { NULL,             0,                      0 }};
@@ -126,9 +125,6 @@ VIA6522::execute()
 {
     wakeUp();
     
-    uint64_t oldDelay = delay;
-    uint64_t oldFeed  = feed;
-    
     // Execute timers
     executeTimer1();
     executeTimer2();
@@ -154,14 +150,9 @@ VIA6522::execute()
     // Move trigger event flags left and feed in new bits
     delay = ((delay << 1) & VIAClearBits) | feed;
     
-    // Go into idle state if possible
-    if (oldDelay == delay && oldFeed == feed) {
-        if (++tiredness > 4) {
-            sleep();
-            tiredness = 0;
-        }
-    } else {
-        tiredness = 0;
+    // Go into idle state if the next cycle would look exactly the same
+    if (delay == (((delay << 1) & VIAClearBits) | feed)) {
+        sleep();
     }
 }
 
@@ -854,6 +845,10 @@ VIA6522::sleep()
     if (!(delay & VIACountA1)) sleepA = UINT64_MAX;
     if (!(delay & VIACountB1)) sleepB = UINT64_MAX;
     
+    // Underflows without an interrupt are replayed when the VIA wakes up
+    if (!timer1WillInterrupt()) sleepA = UINT64_MAX;
+    if (!timer2WillInterrupt()) sleepB = UINT64_MAX;
+    
     wakeUpCycle = MIN(sleepA, sleepB);
 }
 
@@ -867,8 +862,7 @@ VIA6522::wakeUp()
         if (delay & VIACountA1) {
             assert((delay & (VIACountA0)) != 0);
             assert((feed & (VIACountA0)) != 0);
-            assert(t1 > idleCycles);
-            t1 -= idleCycles;
+            fastForwardTimer1(idleCycles);
         } else {
             assert((delay & (VIACountA0)) == 0);
             assert((feed & (VIACountA0)) == 0);
@@ -876,8 +870,7 @@ VIA6522::wakeUp()
         if (delay & VIACountB1) {
             assert((delay & (VIACountB0)) != 0);
             assert((feed & (VIACountB0)) != 0);
-            assert(t2 > idleCycles);
-            t2 -= idleCycles;
+            fastForwardTimer2(idleCycles);
         } else {
             assert((delay & (VIACountB0)) == 0);
             assert((feed & (VIACountB0)) == 0);
@@ -887,6 +880,72 @@ VIA6522::wakeUp()
     wakeUpCycle = 0;
 }
 
+void
+VIA6522::fastForwardTimer1(uint64_t cycles)
+{
+    // The VIA only sleeps while no reload is pending
+    assert(t1 > 0);
+    assert(!(delay & (VIAReloadA1 | VIAReloadA2)));
+    
+    if (cycles < t1) {
+        t1 -= cycles;
+        return;
+    }
+    
+    // The counter hits zero after t1 cycles. From then on, it underflows
+    // every latch + 2 cycles (one cycle at 0xFFFF, one cycle for reloading).
+    uint64_t period = (uint64_t)HI_LO(t1_latch_hi, t1_latch_lo) + 2;
+    uint64_t underflows = 1 + (cycles - t1) / period;
+    uint64_t phase = (cycles - t1) % period;
+    
+    if (!(feed & VIAPostOneShotA0)) {
+        
+        // The VIA would have been woken up if an interrupt was due
+        assert(!timer1WillInterrupt());
+        SET_BIT(ifr, 6);
+        
+        // Toggle PB7 once per underflow (once in one-shot mode)
+        if (!freeRun()) {
+            underflows = 1;
+            feed |= VIAPostOneShotA0;
+        }
+        if (underflows & 1) {
+            feed ^= VIAPB7out0;
+        }
+        delay &= ~(VIAPostOneShotA0 | VIAPB7out0);
+        delay |= feed & (VIAPostOneShotA0 | VIAPB7out0);
+    }
+    
+    // Restore the reload pipeline
+    if (phase == 0) {
+        t1 = 0;
+        delay |= VIAReloadA1;
+    } else if (phase == 1) {
+        t1 = 0xFFFF;
+        delay |= VIAReloadA2;
+    } else {
+        t1 = (uint16_t)(HI_LO(t1_latch_hi, t1_latch_lo) - (phase - 2));
+    }
+}
+
+void
+VIA6522::fastForwardTimer2(uint64_t cycles)
+{
+    // Timer 2 is not reloaded. It wraps around and hits zero every 64K cycles.
+    uint64_t first = t2 ? t2 : 0x10000;
+    
+    if (cycles >= first && !(delay & VIAPostOneShotB0)) {
+        
+        // The VIA would have been woken up if an interrupt was due
+        assert(!timer2WillInterrupt());
+        SET_BIT(ifr, 5);
+        feed |= VIAPostOneShotB0;
+        delay |= VIAPostOneShotB0;
+    }
+    
+    t2 = (uint16_t)(t2 - cycles);
+}
+
 
 //
 // VIA 1
@@ -927,6 +986,9 @@ VIA1::portBexternal()
     // |  ATN  | Device addr.  |  ATN  | Clock | Clock | Data  | Data  |
     // |  in   |               |  ack  |  out  |  in   |  out  |  in   |
     
+    // Wait until the other drive has caught up
+    c64->driveScheduler.waitForBus(drive->getDeviceNr());
+    
     uint8_t external =
     (c64->iec.atnLine ? 0x00 : 0x80) |
     (c64->iec.clockLine ? 0x00 : 0x04) |
@@ -945,7 +1007,7 @@ void
 VIA1::updatePB()
 {
     VIA6522::updatePB();
-    c64->iec.setNeedsUpdateDriveSide(); 
+    c64->iec.setNeedsUpdateDriveSide(drive->getDeviceNr());
     // c64->iec.updateIecLinesDriveSide();
 }
 
@@ -230,14 +230,14 @@ class VIA6522 : public VirtualComponent {
     // Speeding up emulation (sleep logic)
     //
     
-    //! @brief    Idle counter
-    /*! @details  When the VIA state does not change during execution, this
-     *            variable is increased by one. If it exceeds a certain
-     *            threshhold, the chip is put into idle state via sleep()
+    /*! @brief    Wakeup cycle
+     *  @details  The VIA is put into idle state as soon as the trigger event
+     *            pipeline has settled. It is woken up in the cycle before the
+     *            next timer interrupt, or earlier if a register is accessed
+     *            or an edge occurs on CA1. Timer underflows that don't cause
+     *            an interrupt do not wake up the VIA. They are replayed in
+     *            wakeUp().
      */
-    uint8_t tiredness;
-    
-    //! @brief    Wakeup cycle
     uint64_t wakeUpCycle;
     
     //! @brief    Number of skipped executions
@@ -523,6 +523,25 @@ public:
     
     //! @brief    Emulates all previously skipped cycles.
     void wakeUp();
+    
+    private:
+    
+    //! @brief    Checks if the next underflow of timer 1 triggers an interrupt.
+    bool timer1WillInterrupt() {
+        return !(feed & VIAPostOneShotA0) && GET_BIT(ier, 6) && !GET_BIT(ifr, 6); }
+    
+    //! @brief    Checks if the next underflow of timer 2 triggers an interrupt.
+    bool timer2WillInterrupt() {
+        return !(delay & VIAPostOneShotB0) && GET_BIT(ier, 5) && !GET_BIT(ifr, 5); }
+    
+    /*! @brief    Replays timer 1 for the specified number of idle cycles
+     *  @details  The result is the same as executing executeTimer1() in each
+     *            cycle, including all underflows and reloads in between.
+     */
+    void fastForwardTimer1(uint64_t cycles);
+    
+    //! @brief    Replays timer 2 for the specified number of idle cycles
+    void fastForwardTimer2(uint64_t cycles);
 };
 
 
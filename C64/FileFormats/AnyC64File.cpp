@@ -19,6 +19,8 @@
  */
 
 #include "AnyC64File.h"
+#include <sys/stat.h>
+#include <unistd.h>
 
 AnyC64File::AnyC64File()
 {
@@ -45,7 +47,11 @@ AnyC64File::dealloc()
         return;
     }
     
-    delete[] data;
+    if (backend) {
+        backend.reset();
+    } else {
+        delete[] data;
+    }
     data = NULL;
     size = 0;
     fp = -1;
@@ -155,11 +161,18 @@ AnyC64File::readFromBuffer(const uint8_t *buffer, size_t length)
 {
     assert (buffer != NULL);
     
-    dealloc();
-    if ((data = new uint8_t[length]) == NULL)
-        return false;
+    std::shared_ptr<FileBackend> storage;
     
-    memcpy(data, buffer, length);
+    // Adopt the backend of readFromFile or copy the buffer
+    if (incoming && incoming->getData() == buffer && incoming->getSize() == length) {
+        storage = incoming;
+    } else {
+        storage = std::shared_ptr<FileBackend>(FileBackend::makeWithBuffer(buffer, length));
+    }
+    
+    dealloc();
+    backend = storage;
+    data = backend->getData();
     size = length;
     eof = length;
     fp = 0;
@@ -171,59 +184,31 @@ AnyC64File::readFromFile(const char *filename)
 {
     assert (filename != NULL);
     
-    bool success = false;
-	uint8_t *buffer = NULL;
-	FILE *file = NULL;
-	struct stat fileProperties;
-	
+    bool success;
+    
 	// Check file type
     if (!hasSameType(filename)) {
-		goto exit;
-	}
-	
-	// Get file properties
-    if (stat(filename, &fileProperties) != 0) {
-		goto exit;
-	}
-		
-	// Open file
-	if (!(file = fopen(filename, "r"))) {
-		goto exit;
-	}
-
-	// Allocate memory
-	if (!(buffer = new uint8_t[fileProperties.st_size])) {
-		goto exit;
-	}
-	
-	// Read from file
-	int c;
-	for (unsigned i = 0; i < fileProperties.st_size; i++) {
-		c = fgetc(file);
-		if (c == EOF)
-			break;
-		buffer[i] = (uint8_t)c;
+        return false;
 	}
 	
+    // Map or read the file
+    if (!(incoming = std::shared_ptr<FileBackend>(FileBackend::makeWithFile(filename)))) {
+        return false;
+    }
+    
 	// Read from buffer (subclass specific behaviour)
 	dealloc();
-	if (!readFromBuffer(buffer, (unsigned)fileProperties.st_size)) {
-		goto exit;
+    success = readFromBuffer(incoming->getData(), incoming->getSize());
+    incoming.reset();
+    
+    if (!success) {
+        return false;
 	}
 
     setPath(filename);
-    success = true;
     
-    debug(1, "File %s read successfully\n", path);
-	
-exit:
-	
-    if (file)
-		fclose(file);
-	if (buffer)
-		delete[] buffer;
-
-	return success;
+    debug(1, "File %s read successfully (%s)\n", path, backendType());
+    return true;
 }
 
 size_t
@@ -237,48 +222,59 @@ AnyC64File::writeToBuffer(uint8_t *buffer)
     return size;
 }
 
-bool 
+bool
 AnyC64File::writeToFile(const char *filename)
 {
-	bool success = false;
-	uint8_t *data = NULL;
-	FILE *file;
-	size_t filesize;
-   
+    bool success = false;
+    uint8_t *buffer = NULL;
+    char *tmpname = NULL;
+    FILE *file = NULL;
+    struct stat properties;
+    size_t filesize;
+    int fd;
+    
+    assert (filename != NULL);
+    
     // Determine file size
     filesize = writeToBuffer(NULL);
     if (filesize == 0)
         return false;
     
-	// Open file
-    assert (filename != NULL);
-	if (!(file = fopen(filename, "w"))) {
-		goto exit;
-	}
-		
-	// Allocate memory
-    if (!(data = new uint8_t[filesize])) {
-		goto exit;
-	}
-	
-	// Write to buffer 
-	if (!writeToBuffer(data)) {
-		goto exit;
-	}
-
-	// Write to file
-	for (unsigned i = 0; i < filesize; i++) {
-		fputc(data[i], file);
-	}	
-	
-	success = true;
-
+    // Write to buffer before touching the file on disk. The data of this
+    // object may be a mapping of the file that is about to be replaced.
+    buffer = new uint8_t[filesize];
+    if (!writeToBuffer(buffer)) {
+        goto exit;
+    }
+    
+    // Write to a temporary file in the same directory
+    tmpname = (char *)malloc(strlen(filename) + 8);
+    strcpy(tmpname, filename);
+    strcat(tmpname, ".XXXXXX");
+    if ((fd = mkstemp(tmpname)) < 0) {
+        goto exit;
+    }
+    fchmod(fd, stat(filename, &properties) == 0 ? properties.st_mode & 07777 : 0644);
+    if (!(file = fdopen(fd, "w"))) {
+        close(fd);
+        unlink(tmpname);
+        goto exit;
+    }
+    success = fwrite(buffer, 1, filesize, file) == filesize;
+    success &= fclose(file) == 0;
+    
+    // Move the temporary file into place. Existing mappings of the old file
+    // remain valid, because they still refer to the old inode.
+    if (success) {
+        success = rename(tmpname, filename) == 0;
+    }
+    if (!success) {
+        unlink(tmpname);
+    }
+    
 exit:
-		
-	if (file)
-        fclose(file);
-	if (data)
-        delete[] data;
-		
-	return success;
+    
+    free(tmpname);
+    delete[] buffer;
+    return success;
 }
@@ -23,6 +23,7 @@
 #define _ANYC64FILE_INC
 
 #include "VC64Object.h"
+#include "FileBackend.h"
 
 /*! @class    AnyC64File
  *  @brief    Base class for all supported file types.
@@ -50,6 +51,21 @@ protected:
     //! @brief    The raw data of this file.
     uint8_t *data = NULL;
     
+    /*! @brief    Storage holding the raw data
+     *  @details  If set, variable data points into the backend and the
+     *            backend is released instead of deleting data. If not set,
+     *            data has been allocated with new[].
+     */
+    std::shared_ptr<FileBackend> backend;
+    
+    /*! @brief    Backend handed over to readFromBuffer
+     *  @details  readFromFile passes the contents of this backend to
+     *            readFromBuffer. If the subclass implementation forwards the
+     *            same buffer to AnyC64File::readFromBuffer, the backend is
+     *            adopted instead of being copied.
+     */
+    std::shared_ptr<FileBackend> incoming;
+    
     //! @brief    The size of this file in bytes.
     size_t size = 0;
     
@@ -131,6 +147,12 @@ public:
      *  @details  After getSize() calls to read(), EOF is returned.
      */
     virtual size_t getSize() { return size; }
+    
+    //! @brief    Returns the backend type ("mmap", "stream", "memory" or "").
+    const char *backendType() { return backend ? backend->typeAsString() : ""; }
+
+    //! @brief    Computes a hash value over the raw file contents.
+    uint64_t fingerprint() { return data ? fnv_1a(data, size) : 0; }
 
     //! @brief    Moves the file pointer to the specified offset.
     /*! @details  Use seek(0) to return to the beginning of the file.
@@ -172,12 +194,13 @@ public:
     virtual bool readFromBuffer(const uint8_t *buffer, size_t length);
 	
     /*! @brief    Reads the file contents from a file.
-     *  @details  This function requires no custom implementation. It first
-     *            reads in the file contents in memory and invokes
-     *            readFromBuffer afterwards.
+     *  @details  This function requires no custom implementation. It maps
+     *            the file into memory (or reads it in chunks if it can't be
+     *            mapped) and invokes readFromBuffer afterwards. The mapping
+     *            becomes the backend of this object without being copied.
      *  @param    filename The name of a file on disk.
      */
-	bool readFromFile(const char *filename);
+	virtual bool readFromFile(const char *filename);
 
     /*! @brief    Writes the file contents into a memory buffer.
      *  @details  If a NULL pointer is passed in, a test run is performed. Test
@@ -188,7 +211,10 @@ public:
 
     /*! @brief    Writes the file contents to a file.
      *  @details  This function requires no custom implementation. It invokes
-     *            writeToBuffer first and writes the data to disk afterwards.
+     *            writeToBuffer first and writes the data to a temporary file
+     *            afterwards, which then replaces the target file. Hence, a
+     *            file can be written back to the path it has been read from,
+     *            even if its contents are still mapped into memory.
      *  @param    filename The name of a file to be written.
      */
 	bool writeToFile(const char *filename);
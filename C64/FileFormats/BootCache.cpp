@@ -0,0 +1,157 @@
+/*!
+ * @header      BootCache.cpp
+ * @author      Dirk W. Hoffmann, www.dirkwhoffmann.de
+ * @copyright   Dirk W. Hoffmann. All rights reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "C64.h"
+
+BootCache::BootCache()
+{
+    setDescription("BootCache");
+}
+
+void
+BootCache::dump()
+{
+    msg("BootCache:\n");
+    msg("----------\n\n");
+    msg("      Directory : %s\n", isEnabled() ? directory.c_str() : "(disabled)");
+    msg("      Recording : %s\n", recording ? "yes" : "no");
+    msg("           Hits : %lld\n", hits);
+    msg("         Misses : %lld\n\n", misses);
+}
+
+bool
+BootCache::isEligible(C64 *c64)
+{
+    return
+    c64->isRunnable() &&
+    !c64->expansionport.getCartridgeAttached() &&
+    !c64->drive1.hasDisk() &&
+    !c64->drive2.hasDisk() &&
+    !c64->datasette.hasTape();
+}
+
+uint64_t
+BootCache::key(C64 *c64)
+{
+    uint64_t values[] = {
+        
+        // Snapshot format
+        V_MAJOR, V_MINOR, V_SUBMINOR,
+        
+        // Hardware configuration
+        (uint64_t)c64->vic.getModel(),
+        (uint64_t)c64->vic.emulateGrayDotBug,
+        (uint64_t)c64->vic.getGlueLogic(),
+        (uint64_t)c64->cia1.getModel(),
+        (uint64_t)c64->cia1.getEmulateTimerBBug(),
+        (uint64_t)c64->sid.getModel(),
+        (uint64_t)c64->sid.getReSID(),
+        (uint64_t)c64->sid.getAudioFilter(),
+        (uint64_t)c64->mem.getRamInitPattern(),
+        
+        // ROMs
+        c64->mem.basicRomFingerprint(),
+        c64->mem.characterRomFingerprint(),
+        c64->mem.kernalRomFingerprint(),
+        c64->drive1.mem.romFingerprint(),
+        c64->drive2.mem.romFingerprint(),
+        
+        // Drive configuration
+        (uint64_t)c64->drive1.isPoweredOn(),
+        (uint64_t)c64->drive2.isPoweredOn()
+    };
+    
+    return fnv_1a((uint8_t *)values, sizeof(values));
+}
+
+std::string
+BootCache::path(uint64_t key)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "/boot-%016llx.vc64", (unsigned long long)key);
+    return directory + name;
+}
+
+bool
+BootCache::restore(C64 *c64)
+{
+    recording = false;
+    
+    if (!isEnabled() || !isEligible(c64))
+        return false;
+    
+    uint64_t k = key(c64);
+    std::string file = path(k);
+    
+    Snapshot *snapshot = Snapshot::isSupportedSnapshotFile(file.c_str()) ?
+    Snapshot::makeWithFile(file.c_str()) : NULL;
+    
+    if (snapshot == NULL) {
+        
+        debug(2, "Boot cache miss (%016llx)\n", k);
+        misses++;
+        recording = true;
+        recordKey = k;
+        return false;
+    }
+    
+    debug(2, "Boot cache hit (%016llx)\n", k);
+    c64->loadFromSnapshotUnsafe(snapshot);
+    delete snapshot;
+    hits++;
+    return true;
+}
+
+void
+BootCache::record(C64 *c64)
+{
+    recording = false;
+    
+    // Don't cache anything if the configuration has changed in the meantime
+    if (!isEligible(c64) || key(c64) != recordKey) {
+        debug(2, "Configuration has changed during boot. Nothing is cached.\n");
+        return;
+    }
+    
+    Snapshot *snapshot = Snapshot::makeWithC64(c64);
+    if (snapshot == NULL) return;
+    
+    // Write to a temporary file first to never expose half-written files
+    std::string file = path(recordKey);
+    char tmp[32];
+    snprintf(tmp, sizeof(tmp), ".%d.%p", (int)getpid(), (void *)c64);
+    std::string temp = file + tmp;
+    
+    if (snapshot->writeToFile(temp.c_str()) && rename(temp.c_str(), file.c_str()) == 0) {
+        debug(2, "Cached boot state in %s\n", file.c_str());
+    } else {
+        warn("Failed to write boot cache file %s\n", file.c_str());
+        unlink(temp.c_str());
+    }
+    delete snapshot;
+}
+
+void
+BootCache::invalidate(C64 *c64)
+{
+    if (isEnabled()) {
+        unlink(path(key(c64)).c_str());
+    }
+}
@@ -0,0 +1,127 @@
+/*!
+ * @header      BootCache.h
+ * @author      Dirk W. Hoffmann, www.dirkwhoffmann.de
+ * @copyright   Dirk W. Hoffmann. All rights reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _BOOTCACHE_INC
+#define _BOOTCACHE_INC
+
+#include "VC64Object.h"
+#include <string>
+
+class C64;
+
+/*! @brief    Caches the state of a freshly booted C64 on disk
+ *  @details  After a power up, the Kernal needs about 2 to 3 emulated
+ *            seconds for the RAM test and the BASIC initialization. If the
+ *            cache is enabled, C64::powerUp() restores a snapshot taken at
+ *            the end of a previous boot instead. Snapshots are keyed by a
+ *            hash over the hardware configuration, the ROM fingerprints,
+ *            and the drive configuration. If no matching snapshot exists,
+ *            the C64 boots normally and a snapshot is taken as soon as the
+ *            Kernal waits for keyboard input.
+ *            The cache is only used if no cartridge, disk, or tape is
+ *            inserted, because these are part of snapshots.
+ *            Files are written to a temporary name and renamed afterwards.
+ *            Hence, multiple emulator instances can share a directory.
+ */
+class BootCache : public VC64Object {
+    
+    private:
+    
+    //! @brief    Cache directory (empty = cache disabled)
+    std::string directory;
+    
+    //! @brief    Indicates that a snapshot is taken at the end of the boot
+    bool recording = false;
+    
+    //! @brief    Cache key of the configuration being booted
+    uint64_t recordKey = 0;
+    
+    //! @brief    Statistics
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    
+    public:
+    
+    //! @brief    Constructor
+    BootCache();
+    
+    //! @brief    Prints the configuration and statistics
+    void dump();
+    
+    
+    //
+    //! @functiongroup Configuring
+    //
+    
+    const char *getDirectory() { return directory.c_str(); }
+    
+    //! @brief    Sets the cache directory. An empty string disables the cache.
+    void setDirectory(const char *path) { directory = path ? path : ""; }
+    
+    bool isEnabled() { return !directory.empty(); }
+    
+    
+    //
+    //! @functiongroup Using the cache
+    //
+    
+    //! @brief    Returns true if the C64 can be booted from the cache
+    static bool isEligible(C64 *c64);
+    
+    //! @brief    Computes the cache key of the current configuration
+    static uint64_t key(C64 *c64);
+    
+    //! @brief    Returns the path of the snapshot file for a cache key
+    std::string path(uint64_t key);
+    
+    /*! @brief    Restores a cached boot state
+     *  @details  Must be called with the emulator suspended, right after a
+     *            reset. On a cache miss, a snapshot is taken at the end of
+     *            the boot.
+     *  @return   false, if the C64 needs to boot normally.
+     */
+    bool restore(C64 *c64);
+    
+    //! @brief    Returns true if a snapshot is to be taken at the end of the boot
+    bool isRecording() { return recording; }
+    
+    //! @brief    Stops waiting for the end of the boot
+    void cancelRecording() { recording = false; }
+    
+    /*! @brief    Writes the current state into the cache
+     *  @details  Called by the C64 when the Kernal waits for keyboard input.
+     *            Nothing is written if the configuration has changed during
+     *            the boot.
+     */
+    void record(C64 *c64);
+    
+    //! @brief    Deletes the cached snapshot of the current configuration
+    void invalidate(C64 *c64);
+    
+    
+    //
+    //! @functiongroup Querying statistics
+    //
+    
+    uint64_t getHits() { return hits; }
+    uint64_t getMisses() { return misses; }
+};
+
+#endif
@@ -155,6 +155,11 @@ CRTFile::CRTFile()
     memset(chips, 0, sizeof(chips));
 }
 
+CRTFile::~CRTFile()
+{
+    dealloc();
+}
+
 CRTFile *
 CRTFile::makeWithBuffer(const uint8_t *buffer, size_t length)
 {
@@ -184,17 +189,43 @@ CRTFile::makeWithFile(const char *filename)
 void
 CRTFile::dealloc()
 {
+    image.reset();
     AnyC64File::dealloc();
+    
     memset(chips, 0, sizeof(chips));
     numberOfChips = 0;
 }
-        
+
 bool
 CRTFile::readFromBuffer(const uint8_t *buffer, size_t length)
 {
+    assert(buffer != NULL);
+    
     if (!AnyC64File::readFromBuffer(buffer, length))
         return false;
     
+    // Chip packets share the backend. If the file has been mapped into
+    // memory, the mapping is released when the last packet is gone.
+    image = std::shared_ptr<uint8_t>(backend, data);
+    
+    return scanImage();
+}
+
+bool
+CRTFile::scanImage()
+{
+    size_t length = size;
+    
+    if (!isIntact()) {
+        warn("CRT file has been truncated on disk\n");
+        return false;
+    }
+    
+    if (length < 0x40) {
+        warn("CRT file is too short\n");
+        return false;
+    }
+    
     // Scan cartridge header
     if (memcmp("C64 CARTRIDGE   ", data, 16) != 0) {
         warn("Bad cartridge signature. Expected 'C64  CARTRIDGE  '\n");
@@ -214,7 +245,7 @@ CRTFile::readFromBuffer(const uint8_t *buffer, size_t length)
     msg("   Exrom:  %d\n", initialExromLine());
     
     // Load chip packets
-    uint8_t *ptr = &data[headerSize];
+    uint8_t *ptr = data + MIN(headerSize, length);
     for (numberOfChips = 0; ptr < data + length; numberOfChips++) {
         
         if (numberOfChips == MAX_PACKETS) {
@@ -222,7 +253,7 @@ CRTFile::readFromBuffer(const uint8_t *buffer, size_t length)
             break;
         }
         
-        if (memcmp("CHIP", ptr, 4) != 0) {
+        if (data + length - ptr < 0x10 || memcmp("CHIP", ptr, 4) != 0) {
             warn("Unexpected data in cartridge, expected 'CHIP'\n");
             return false;
         }
@@ -230,6 +261,13 @@ CRTFile::readFromBuffer(const uint8_t *buffer, size_t length)
         // Remember start address of each chip section
         chips[numberOfChips] = ptr;
         
+        // Packets are referenced in place. Hence, they must lie inside the file
+        if ((size_t)(data + length - ptr) < 0x10 + (size_t)chipSize(numberOfChips)) {
+            warn("Chip packet %d exceeds the end of file. Aborting!\n", numberOfChips);
+            chips[numberOfChips] = NULL;
+            return false;
+        }
+        
         ptr += 0x10;
         ptr += chipSize(numberOfChips);
     }
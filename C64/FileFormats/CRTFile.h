@@ -31,6 +31,7 @@
 #define _CRTFILE_INC
 
 #include "AnyC64File.h"
+#include <memory>
 
 /*! @class    CRTFile
  *  @brief    Represents a file of the CRT format type (cartridges).
@@ -44,12 +45,27 @@ private:
     
     //! @brief    Header signature
     static const uint8_t magicBytes[];
-        
+    
     //! @brief    Number of chips contained in cartridge file
     unsigned int numberOfChips = 0;
     
     //! @brief    Indicates where each chip section starts
     uint8_t *chips[MAX_PACKETS];
+    
+    /*! @brief    The file contents, sharing ownership of the backend
+     *  @details  Chip packets created from this file share the image and
+     *            keep it alive after the file object has been deleted.
+     *            Files read from disk usually stay mapped, independent of
+     *            their size. scanImage makes sure that all chip packets lie
+     *            inside the mapping and isIntact detects files that have
+     *            been truncated on disk afterwards. Files replaced by
+     *            AnyC64File::writeToFile are safe, because the old contents
+     *            remain accessible until the mapping is released.
+     */
+    std::shared_ptr<uint8_t> image;
+    
+    //! @brief    Scans the image for chip packets.
+    bool scanImage();
 
 public:
     
@@ -86,6 +102,9 @@ public:
     //! @brief    Constructor
     CRTFile();
     
+    //! @brief    Destructor
+    ~CRTFile();
+    
     //! @brief    Factory method
     static CRTFile *makeWithBuffer(const uint8_t *buffer, size_t length);
 
@@ -131,12 +150,28 @@ public:
     //! @functiongroup Retrieving chip information
     //
     
+    /*! @brief    Checks if the chip data can still be accessed safely
+     *  @details  Returns false if the file has been truncated on disk after
+     *            it was mapped into memory.
+     */
+    bool isIntact() { return backend == NULL || backend->isIntact(); }
+    
     //! @brief    Returns how many chips are contained in this cartridge
     uint8_t chipCount() { return numberOfChips; }
     
     //! @brief    Returns where the data of a certain chip can be found
     uint8_t *chipData(unsigned nr) { return chips[nr]+0x10; }
     
+    /*! @brief    Returns a shared reference to the data of a certain chip
+     *  @details  The returned pointer shares ownership of the file image.
+     *            Hence, it stays valid when this object is deleted. The data
+     *            must be treated as read-only. If the image is a memory
+     *            mapping, the file on disk must stay intact as long as the
+     *            pointer is in use (see image).
+     */
+    std::shared_ptr<uint8_t> sharedChipData(unsigned nr) {
+        return std::shared_ptr<uint8_t>(image, chipData(nr)); }
+    
     //! @brief    Returns the size of chip (8 KB or 16 KB)
     uint16_t chipSize(unsigned nr) { return LO_HI(chips[nr][0xF], chips[nr][0xE]); }
     
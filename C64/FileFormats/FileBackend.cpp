@@ -0,0 +1,162 @@
+/*!
+ * @header      FileBackend.cpp
+ * @author      Dirk W. Hoffmann, www.dirkwhoffmann.de
+ * @copyright   Dirk W. Hoffmann. All rights reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "FileBackend.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+FileBackend *
+FileBackend::makeWithFile(const char *path)
+{
+    FileBackend *backend;
+    
+    assert(path != NULL);
+    
+    if ((backend = MappedFileBackend::make(path)) != NULL)
+        return backend;
+    
+    return StreamFileBackend::make(path);
+}
+
+FileBackend *
+FileBackend::makeWithBuffer(const uint8_t *buffer, size_t length)
+{
+    return MemoryFileBackend::make(buffer, length);
+}
+
+MappedFileBackend *
+MappedFileBackend::make(const char *path)
+{
+    struct stat fileProperties;
+    
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+    
+    // Only regular files can be mapped
+    if (fstat(fd, &fileProperties) != 0 ||
+        !S_ISREG(fileProperties.st_mode) ||
+        fileProperties.st_size == 0) {
+        close(fd);
+        return NULL;
+    }
+    
+    // A private mapping lets the file objects modify their data in place
+    size_t length = (size_t)fileProperties.st_size;
+    void *addr = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    
+    if (addr == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+    
+    MappedFileBackend *backend = new MappedFileBackend();
+    backend->fd = fd;
+    backend->data = (uint8_t *)addr;
+    backend->size = length;
+    return backend;
+}
+
+MappedFileBackend::~MappedFileBackend()
+{
+    if (data) munmap(data, size);
+    if (fd >= 0) close(fd);
+}
+
+bool
+MappedFileBackend::isIntact()
+{
+    struct stat fileProperties;
+    
+    // The descriptor refers to the mapped file, even if it has been renamed
+    // or replaced on disk. Pages beyond the current end of file must not be
+    // accessed.
+    if (fstat(fd, &fileProperties) != 0)
+        return false;
+    
+    return (size_t)fileProperties.st_size >= size;
+}
+
+StreamFileBackend *
+StreamFileBackend::make(const char *path)
+{
+    FILE *file;
+    
+    if ((file = fopen(path, "r")) == NULL)
+        return NULL;
+    
+    // Start with the size reported by the file system. The buffer grows if
+    // the file turns out to be larger (e.g., if it isn't a regular file).
+    long expected = getSizeOfFile(path);
+    size_t capacity = expected > 0 ? (size_t)expected : chunkSize;
+    size_t length = 0;
+    uint8_t *buffer = new uint8_t[capacity];
+    
+    while (true) {
+        
+        if (length == capacity) {
+            uint8_t *larger = new uint8_t[2 * capacity];
+            memcpy(larger, buffer, length);
+            delete[] buffer;
+            buffer = larger;
+            capacity *= 2;
+        }
+        
+        size_t bytes = fread(buffer + length, 1, MIN(chunkSize, capacity - length), file);
+        if (bytes == 0) break;
+        length += bytes;
+    }
+    
+    fclose(file);
+    
+    if (length == 0) {
+        delete[] buffer;
+        return NULL;
+    }
+    
+    StreamFileBackend *backend = new StreamFileBackend();
+    backend->data = buffer;
+    backend->size = length;
+    return backend;
+}
+
+StreamFileBackend::~StreamFileBackend()
+{
+    delete[] data;
+}
+
+MemoryFileBackend *
+MemoryFileBackend::make(const uint8_t *buffer, size_t length)
+{
+    assert(buffer != NULL);
+    
+    MemoryFileBackend *backend = new MemoryFileBackend();
+    backend->data = new uint8_t[length];
+    backend->size = length;
+    memcpy(backend->data, buffer, length);
+    return backend;
+}
+
+MemoryFileBackend::~MemoryFileBackend()
+{
+    delete[] data;
+}
@@ -0,0 +1,130 @@
+/*!
+ * @header      FileBackend.h
+ * @author      Dirk W. Hoffmann, www.dirkwhoffmann.de
+ * @copyright   Dirk W. Hoffmann. All rights reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _FILEBACKEND_INC
+#define _FILEBACKEND_INC
+
+#include "basic.h"
+#include <memory>
+
+/*! @brief    Storage holding the contents of a file
+ *  @details  A backend provides the raw bytes of a file as a contiguous
+ *            block of memory. Depending on how the backend was created, the
+ *            block is a memory mapping of the file, a heap buffer that has
+ *            been filled in chunks, or a heap copy of a memory buffer.
+ *            The block is always writable. Writes never go back to disk.
+ */
+class FileBackend {
+    
+protected:
+    
+    //! @brief    The file contents
+    uint8_t *data = NULL;
+    
+    //! @brief    Size of the file contents in bytes
+    size_t size = 0;
+    
+public:
+    
+    virtual ~FileBackend() { };
+    
+    /*! @brief    Creates a backend for a file on disk
+     *  @details  The file is mapped into memory if possible. Otherwise, it is
+     *            read in chunks.
+     *  @return   NULL, if the file cannot be opened or is empty.
+     */
+    static FileBackend *makeWithFile(const char *path);
+    
+    //! @brief    Creates a backend holding a copy of a memory buffer
+    static FileBackend *makeWithBuffer(const uint8_t *buffer, size_t length);
+    
+    //! @brief    Returns the file contents
+    uint8_t *getData() { return data; }
+    
+    //! @brief    Returns the size of the file contents in bytes
+    size_t getSize() { return size; }
+    
+    //! @brief    Returns a short description of the backend type
+    virtual const char *typeAsString() = 0;
+    
+    /*! @brief    Returns true if the data is a memory mapping of the file
+     *  @details  Mapped data is read from disk on demand. Accessing it faults
+     *            if the file has been truncated in the meantime.
+     */
+    virtual bool isMapped() { return false; }
+    
+    /*! @brief    Checks if the data can still be accessed safely
+     *  @details  Returns false if the data is a mapping of a file that has
+     *            been truncated after it was mapped.
+     */
+    virtual bool isIntact() { return true; }
+};
+
+/*! @brief    A private, copy-on-write memory mapping of a file
+ *  @details  Only the pages that are accessed are read from disk. The file
+ *            stays open to be able to detect truncation.
+ */
+class MappedFileBackend : public FileBackend {
+    
+    //! @brief    File descriptor of the mapped file
+    int fd = -1;
+    
+public:
+    
+    //! @brief    Maps a file into memory (NULL on failure)
+    static MappedFileBackend *make(const char *path);
+    
+    ~MappedFileBackend();
+    const char *typeAsString() { return "mmap"; }
+    bool isMapped() { return true; }
+    bool isIntact();
+};
+
+/*! @brief    A heap buffer that is filled by reading the file in chunks
+ *  @details  This backend is used if a file cannot be mapped, e.g., because
+ *            it resides on a file system that does not support mmap.
+ */
+class StreamFileBackend : public FileBackend {
+    
+public:
+    
+    //! @brief    Number of bytes read with a single call to fread
+    static const size_t chunkSize = 0x10000;
+    
+    //! @brief    Reads a file into memory (NULL on failure)
+    static StreamFileBackend *make(const char *path);
+    
+    ~StreamFileBackend();
+    const char *typeAsString() { return "stream"; }
+};
+
+//! @brief    A heap copy of a memory buffer
+class MemoryFileBackend : public FileBackend {
+    
+public:
+    
+    //! @brief    Copies a memory buffer
+    static MemoryFileBackend *make(const uint8_t *buffer, size_t length);
+    
+    ~MemoryFileBackend();
+    const char *typeAsString() { return "memory"; }
+};
+
+#endif
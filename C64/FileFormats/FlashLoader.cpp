@@ -0,0 +1,314 @@
+/*!
+ * @header      FlashLoader.cpp
+ * @author      Dirk W. Hoffmann, www.dirkwhoffmann.de
+ * @copyright   Dirk W. Hoffmann. All rights reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "FlashLoader.h"
+#include <algorithm>
+
+FlashPayload *
+FlashPayload::makeWithItem(AnyArchive *archive, unsigned item)
+{
+    assert(archive != NULL);
+
+    if ((int)item >= archive->numberOfItems())
+        return NULL;
+
+    FlashPayload *payload = new FlashPayload();
+
+    archive->selectItem(item);
+    payload->addr = archive->getDestinationAddrOfItem();
+
+    // Same as AnyArchive::flashItem(), but without a target buffer
+    size_t room = 0x10000 - payload->addr;
+    payload->data.reserve(MIN(room, archive->getSize()));
+
+    int byte;
+    archive->seekItem(0);
+    while (payload->data.size() < room && (byte = archive->readItem()) != EOF) {
+        payload->data.push_back((uint8_t)byte);
+    }
+
+    return payload;
+}
+
+static void *
+runFlashWorker(void *loader)
+{
+    ((FlashLoader *)loader)->runWorker();
+    return NULL;
+}
+
+FlashLoader::FlashLoader()
+{
+    setDescription("FlashLoader");
+    pthread_mutex_init(&lock, NULL);
+    pthread_mutex_init(&poolLock, NULL);
+    pthread_cond_init(&workAvailable, NULL);
+    pthread_cond_init(&workerLeft, NULL);
+    setMaxThreads(0);
+}
+
+FlashLoader::~FlashLoader()
+{
+    pthread_mutex_lock(&poolLock);
+    quit = true;
+    pthread_cond_broadcast(&workAvailable);
+    pthread_mutex_unlock(&poolLock);
+    
+    for (pthread_t worker : workers) {
+        pthread_join(worker, NULL);
+    }
+    
+    pthread_cond_destroy(&workerLeft);
+    pthread_cond_destroy(&workAvailable);
+    pthread_mutex_destroy(&poolLock);
+    pthread_mutex_destroy(&lock);
+}
+
+FlashLoader &
+FlashLoader::shared()
+{
+    static FlashLoader loader;
+    return loader;
+}
+
+void
+FlashLoader::setCapacity(size_t value)
+{
+    pthread_mutex_lock(&lock);
+    capacity = MAX(value, 1);
+    while (history.size() > capacity) {
+        cache.erase(history.front());
+        history.pop_front();
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+void
+FlashLoader::setMaxThreads(unsigned value)
+{
+    if (value == 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        value = cores > 0 ? (unsigned)cores : 1;
+    }
+    maxThreads = value;
+}
+
+void
+FlashLoader::clear()
+{
+    pthread_mutex_lock(&lock);
+    cache.clear();
+    history.clear();
+    pthread_mutex_unlock(&lock);
+}
+
+size_t
+FlashLoader::getCachedItems()
+{
+    pthread_mutex_lock(&lock);
+    size_t result = cache.size();
+    pthread_mutex_unlock(&lock);
+    return result;
+}
+
+uint64_t
+FlashLoader::key(uint64_t fingerprint, AnyArchive *archive, unsigned item)
+{
+    // Include the file type, because PRG and P00 files may share contents
+    uint64_t values[3] = { fingerprint, (uint64_t)archive->type(), (uint64_t)item };
+    return fnv_1a((uint8_t *)values, sizeof(values));
+}
+
+FlashPayloadRef
+FlashLoader::lookup(uint64_t key)
+{
+    FlashPayloadRef result;
+
+    pthread_mutex_lock(&lock);
+    auto it = cache.find(key);
+    if (it != cache.end()) {
+        result = it->second;
+        hits++;
+    } else {
+        misses++;
+    }
+    pthread_mutex_unlock(&lock);
+
+    return result;
+}
+
+void
+FlashLoader::insert(uint64_t key, FlashPayloadRef payload)
+{
+    pthread_mutex_lock(&lock);
+    if (cache.find(key) == cache.end()) {
+
+        cache[key] = payload;
+        history.push_back(key);
+
+        // Evict the oldest entries
+        while (history.size() > capacity) {
+            cache.erase(history.front());
+            history.pop_front();
+        }
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+FlashPayloadRef
+FlashLoader::prepare(AnyArchive *archive, unsigned item)
+{
+    FlashRequest request = { archive, item };
+    return prepare(&request, 1)[0];
+}
+
+void
+FlashLoader::prepareArchive(const FlashRequest *requests,
+                            const std::vector<size_t> &indices,
+                            std::vector<FlashPayloadRef> &results)
+{
+    AnyArchive *archive = requests[indices[0]].archive;
+    uint64_t fingerprint = archive->fingerprint();
+
+    for (size_t i : indices) {
+
+        unsigned item = requests[i].item;
+        uint64_t k = key(fingerprint, archive, item);
+
+        if (!(results[i] = lookup(k))) {
+
+            FlashPayload *payload = FlashPayload::makeWithItem(archive, item);
+            if (payload) {
+                results[i] = FlashPayloadRef(payload);
+                insert(k, results[i]);
+            }
+        }
+    }
+}
+
+void
+FlashLoader::work(FlashJob *job)
+{
+    size_t nr;
+    while ((nr = job->next++) < job->groups.size()) {
+        prepareArchive(job->requests, job->groups[nr], job->results);
+    }
+}
+
+void
+FlashLoader::runWorker()
+{
+    pthread_mutex_lock(&poolLock);
+    
+    while (!quit) {
+        
+        // Join the first job that has room for another worker
+        auto it = std::find_if(jobs.begin(), jobs.end(), [](FlashJob *job) {
+            return job->workers < job->maxWorkers; });
+        
+        if (it == jobs.end()) {
+            pthread_cond_wait(&workAvailable, &poolLock);
+            continue;
+        }
+        
+        FlashJob *job = *it;
+        job->workers++;
+        pthread_mutex_unlock(&poolLock);
+        
+        work(job);
+        
+        pthread_mutex_lock(&poolLock);
+        
+        // All groups have been taken. Nobody else needs to join in.
+        it = std::find(jobs.begin(), jobs.end(), job);
+        if (it != jobs.end()) jobs.erase(it);
+        
+        job->workers--;
+        pthread_cond_broadcast(&workerLeft);
+    }
+    
+    pthread_mutex_unlock(&poolLock);
+}
+
+std::vector<FlashPayloadRef>
+FlashLoader::prepare(const FlashRequest *requests, size_t count)
+{
+    FlashJob job;
+    job.requests = requests;
+    job.results.resize(count);
+    job.next = 0;
+    job.workers = 0;
+    
+    // Group requests by archive
+    std::unordered_map<AnyArchive *, size_t> groupOf;
+    for (size_t i = 0; i < count; i++) {
+
+        assert(requests[i].archive != NULL);
+        auto it = groupOf.find(requests[i].archive);
+        if (it == groupOf.end()) {
+            groupOf[requests[i].archive] = job.groups.size();
+            job.groups.push_back(std::vector<size_t>());
+            job.groups.back().push_back(i);
+        } else {
+            job.groups[it->second].push_back(i);
+        }
+    }
+    
+    // The calling thread participates, too
+    unsigned numThreads = (unsigned)MIN((size_t)maxThreads, job.groups.size());
+    job.maxWorkers = numThreads > 1 ? numThreads - 1 : 0;
+    
+    if (job.maxWorkers) {
+        
+        pthread_mutex_lock(&poolLock);
+        
+        // Create missing worker threads
+        while (workers.size() < job.maxWorkers) {
+            pthread_t worker;
+            if (pthread_create(&worker, NULL, runFlashWorker, this) != 0) {
+                warn("Failed to create worker thread\n");
+                break;
+            }
+            workers.push_back(worker);
+        }
+        
+        jobs.push_back(&job);
+        pthread_cond_broadcast(&workAvailable);
+        pthread_mutex_unlock(&poolLock);
+    }
+    
+    work(&job);
+    
+    if (job.maxWorkers) {
+        
+        // Wait until all workers have left the job
+        pthread_mutex_lock(&poolLock);
+        auto it = std::find(jobs.begin(), jobs.end(), &job);
+        if (it != jobs.end()) jobs.erase(it);
+        while (job.workers > 0) {
+            pthread_cond_wait(&workerLeft, &poolLock);
+        }
+        pthread_mutex_unlock(&poolLock);
+    }
+    
+    debug(2, "Prepared %zu items in %zu groups with up to %u threads\n",
+          count, job.groups.size(), MAX(numThreads, 1u));
+    return job.results;
+}
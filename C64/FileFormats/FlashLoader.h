@@ -0,0 +1,202 @@
+/*!
+ * @header      FlashLoader.h
+ * @author      Dirk W. Hoffmann, www.dirkwhoffmann.de
+ * @copyright   Dirk W. Hoffmann. All rights reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _FLASHLOADER_INC
+#define _FLASHLOADER_INC
+
+#include "AnyArchive.h"
+#include <memory>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <atomic>
+
+/*! @brief    A decoded archive item, ready to be copied into C64 RAM
+ *  @details  The data is the same that AnyArchive::flashItem() would write,
+ *            i.e., the item bytes starting at the destination address,
+ *            truncated at the end of the address space.
+ */
+struct FlashPayload {
+
+    //! @brief    Destination address in C64 RAM
+    uint16_t addr;
+
+    //! @brief    Item data
+    std::vector<uint8_t> data;
+
+    //! @brief    Decodes an item of an archive
+    static FlashPayload *makeWithItem(AnyArchive *archive, unsigned item);
+};
+
+//! @brief    Payloads are immutable and shared between all machines
+typedef std::shared_ptr<const FlashPayload> FlashPayloadRef;
+
+//! @brief    An item to be flashed
+typedef struct {
+    AnyArchive *archive;
+    unsigned item;
+} FlashRequest;
+
+/*! @brief    A batch of requests processed by the worker threads
+ *  @details  Requests are grouped by archive. Each participating thread
+ *            repeatedly grabs the next unprocessed group.
+ */
+struct FlashJob {
+    
+    const FlashRequest *requests;
+    std::vector<std::vector<size_t>> groups;
+    std::vector<FlashPayloadRef> results;
+    
+    //! @brief    Next group to be processed
+    std::atomic<size_t> next;
+    
+    //! @brief    Number of worker threads that may join in
+    unsigned maxWorkers;
+    
+    //! @brief    Number of worker threads currently processing this job
+    unsigned workers;
+};
+
+/*! @brief    Prepares archive items for flashing in batches
+ *  @details  A batch of (archive, item) pairs is decoded by a pool of worker
+ *            threads. The workers are created on first use and live as long
+ *            as the loader. Items of the same archive are decoded by the
+ *            same thread, because selecting an item modifies the archive.
+ *            Decoded payloads are cached by a hash over the archive contents
+ *            and the item number. Hence, each program is decoded only once,
+ *            no matter how many machines it is flashed into.
+ *            All functions are thread-safe.
+ *  @seealso  C64::flash(const FlashPayload *)
+ */
+class FlashLoader : public VC64Object {
+
+    private:
+
+    //! @brief    Protects the cache
+    pthread_mutex_t lock;
+
+    //! @brief    Decoded payloads, indexed by content hash
+    std::unordered_map<uint64_t, FlashPayloadRef> cache;
+
+    //! @brief    Cache keys in insertion order (used for eviction)
+    std::deque<uint64_t> history;
+
+    //! @brief    Maximum number of cached payloads
+    size_t capacity = 1024;
+
+    //! @brief    Maximum number of threads decoding a batch
+    unsigned maxThreads;
+    
+    //! @brief    The worker threads
+    std::vector<pthread_t> workers;
+    
+    //! @brief    Protects the job queue and wakes up the workers
+    pthread_mutex_t poolLock;
+    pthread_cond_t workAvailable;
+    
+    //! @brief    Signals that a worker has left a job
+    pthread_cond_t workerLeft;
+    
+    //! @brief    Batches waiting for worker threads
+    std::deque<FlashJob *> jobs;
+    
+    //! @brief    Asks the worker threads to terminate
+    bool quit = false;
+
+    //! @brief    Cache statistics
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+
+    public:
+
+    //! @brief    Constructor
+    FlashLoader();
+
+    //! @brief    Destructor
+    ~FlashLoader();
+
+    //! @brief    Returns a loader that can be shared by all emulator instances
+    static FlashLoader &shared();
+
+
+    //
+    //! @functiongroup Configuring
+    //
+
+    //! @brief    Sets the maximum number of cached payloads
+    void setCapacity(size_t value);
+
+    //! @brief    Sets the maximum number of worker threads (0 = one per core)
+    void setMaxThreads(unsigned value);
+
+    //! @brief    Deletes all cached payloads
+    void clear();
+
+
+    //
+    //! @functiongroup Preparing payloads
+    //
+
+    /*! @brief    Decodes a single item, consulting the cache first
+     *  @return   NULL, if the item does not exist.
+     */
+    FlashPayloadRef prepare(AnyArchive *archive, unsigned item);
+
+    /*! @brief    Decodes a batch of items in parallel
+     *  @return   A payload for each request, in the same order. Entries are
+     *            NULL for items that do not exist.
+     */
+    std::vector<FlashPayloadRef> prepare(const FlashRequest *requests, size_t count);
+
+
+    //
+    //! @functiongroup Querying statistics
+    //
+
+    uint64_t getHits() { return hits; }
+    uint64_t getMisses() { return misses; }
+    size_t getCachedItems();
+
+    private:
+
+    //! @brief    Computes the cache key of an item
+    static uint64_t key(uint64_t fingerprint, AnyArchive *archive, unsigned item);
+
+    //! @brief    Looks up a payload in the cache
+    FlashPayloadRef lookup(uint64_t key);
+
+    //! @brief    Adds a payload to the cache
+    void insert(uint64_t key, FlashPayloadRef payload);
+
+    //! @brief    Decodes all requested items of a single archive
+    void prepareArchive(const FlashRequest *requests,
+                        const std::vector<size_t> &indices,
+                        std::vector<FlashPayloadRef> &results);
+    
+    //! @brief    Processes groups of a job until all have been taken
+    void work(FlashJob *job);
+    
+    public:
+    
+    //! @brief    Entry point of the worker threads
+    void runWorker();
+};
+
+#endif
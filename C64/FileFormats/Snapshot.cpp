@@ -22,6 +22,210 @@
 
 const uint8_t Snapshot::magicBytes[] = { 'V', 'C', '6', '4', 0x00 };
 
+/* Migration functions locate the modified data by passing over the preceding
+ * components with a scratch C64, because some of them have a variable size.
+ * A single scratch C64 is shared by all migrations. It is created on first
+ * use and locked while a migration function is running, because snapshot
+ * files may be upgraded by multiple threads in parallel.
+ */
+static pthread_mutex_t scratchLock = PTHREAD_MUTEX_INITIALIZER;
+
+static C64 *
+lockScratchC64()
+{
+    static C64 *scratch = NULL;
+    
+    pthread_mutex_lock(&scratchLock);
+    if (scratch == NULL) scratch = new C64();
+    
+    return scratch;
+}
+
+static void
+unlockScratchC64(C64 *c64)
+{
+    // Don't keep a large cartridge around until the next migration
+    c64->expansionport.detachCartridge();
+    
+    pthread_mutex_unlock(&scratchLock);
+}
+
+// Passes over the sub components that are saved before the specified one
+static bool
+copyComponentsBefore(SnapshotStream &stream, VirtualComponent *parent,
+                     VirtualComponent *component)
+{
+    VirtualComponent **sub = parent->getSubComponents();
+    
+    for (unsigned i = 0; sub != NULL && sub[i] != component; i++) {
+        if (sub[i] == NULL || !stream.copyComponent(sub[i])) return false;
+    }
+    return sub != NULL;
+}
+
+// 3.3.0 -> 3.3.1: IEC::isDirtyDriveSide has been split up per drive
+static bool
+migrateIECDirtyFlags(SnapshotStream &stream)
+{
+    C64 *c64 = lockScratchC64();
+    bool success = copyComponentsBefore(stream, c64, &c64->iec);
+    unlockScratchC64(c64);
+    
+    // atnLine, clockLine, dataLine, isDirtyC64Side
+    success = success && stream.copy(4);
+    
+    // isDirtyDriveSide becomes isDirtyDrive1Side and isDirtyDrive2Side
+    int isDirtyDriveSide = stream.peek8();
+    success = success && isDirtyDriveSide >= 0 && stream.copy(1);
+    if (success) stream.insert8((uint8_t)isDirtyDriveSide);
+    
+    return success && stream.copyRest();
+}
+
+// 3.3.1 -> 3.3.2: VIA6522::tiredness has been removed
+static bool
+dropTiredness(SnapshotStream &stream, VIA6522 *via)
+{
+    // The byte was followed by wakeUpCycle and idleCounter
+    size_t tail = 2 * sizeof(uint64_t);
+    
+    return
+    stream.copy(via->stateSize() - tail) &&
+    stream.skip(1) &&
+    stream.copy(tail);
+}
+
+static bool
+dropTiredness(SnapshotStream &stream, VC1541 *drive)
+{
+    VirtualComponent **sub = drive->getSubComponents();
+    size_t ownItems = drive->stateSize();
+    bool success = true;
+    
+    for (unsigned i = 0; success && sub[i] != NULL; i++) {
+        
+        ownItems -= sub[i]->stateSize();
+        
+        if (sub[i] == &drive->via1 || sub[i] == &drive->via2) {
+            success = dropTiredness(stream, (VIA6522 *)sub[i]);
+        } else {
+            success = stream.copyComponent(sub[i]);
+        }
+    }
+    
+    return success && stream.copy(ownItems);
+}
+
+static bool
+migrateVIATiredness(SnapshotStream &stream)
+{
+    C64 *c64 = lockScratchC64();
+    VirtualComponent **sub = c64->getSubComponents();
+    unsigned drives = 0;
+    bool success = true;
+    
+    // Pass over all components up to the second drive
+    for (unsigned i = 0; success && drives < 2 && sub[i] != NULL; i++) {
+        
+        if (sub[i] == &c64->drive1 || sub[i] == &c64->drive2) {
+            success = dropTiredness(stream, (VC1541 *)sub[i]);
+            drives++;
+        } else {
+            success = stream.copyComponent(sub[i]);
+        }
+    }
+    unlockScratchC64(c64);
+    
+    return success && drives == 2 && stream.copyRest();
+}
+
+/* Schema registry
+ * Whenever the snapshot format changes, add an entry that converts snapshots
+ * of the previous version into the new one. Snapshots of older versions are
+ * upgraded by chaining all entries on the way to the current version.
+ */
+const SnapshotMigration Snapshot::migrations[] = {
+    
+    { 3, 3, 0, 3, 3, 1, migrateIECDirtyFlags },
+    { 3, 3, 1, 3, 3, 2, migrateVIATiredness },
+    { 0, 0, 0, 0, 0, 0, NULL }
+};
+
+const unsigned Snapshot::maxMigrationSteps =
+sizeof(Snapshot::migrations) / sizeof(SnapshotMigration) - 1;
+
+SnapshotStream::SnapshotStream(const uint8_t *data, size_t length)
+{
+    src = data;
+    end = data + length;
+    dst.reserve(length);
+}
+
+bool
+SnapshotStream::copy(size_t n)
+{
+    if (n > remaining()) return false;
+    
+    dst.insert(dst.end(), src, src + n);
+    src += n;
+    return true;
+}
+
+bool
+SnapshotStream::skip(size_t n)
+{
+    if (n > remaining()) return false;
+    
+    src += n;
+    return true;
+}
+
+bool
+SnapshotStream::copyComponent(VirtualComponent *component)
+{
+    assert(component != NULL);
+    
+    // The state size of a fresh component is a lower bound
+    if (component->stateSize() > remaining()) return false;
+    
+    uint8_t *ptr = (uint8_t *)src;
+    component->loadFromBuffer(&ptr);
+    
+    return copy(ptr - src);
+}
+
+const SnapshotMigration *
+Snapshot::findMigration(uint8_t major, uint8_t minor, uint8_t subminor)
+{
+    for (unsigned i = 0; migrations[i].migrate != NULL; i++) {
+        
+        if (migrations[i].major == major &&
+            migrations[i].minor == minor &&
+            migrations[i].subminor == subminor) return &migrations[i];
+    }
+    return NULL;
+}
+
+bool
+Snapshot::isSupportedVersion(uint8_t major, uint8_t minor, uint8_t subminor)
+{
+    const SnapshotMigration *m;
+    unsigned steps = 0;
+    
+    while (major != V_MAJOR || minor != V_MINOR || subminor != V_SUBMINOR) {
+        
+        if (!(m = findMigration(major, minor, subminor))) return false;
+        
+        // A path longer than the registry must contain a cycle
+        if (++steps > maxMigrationSteps) return false;
+        
+        major = m->newMajor;
+        minor = m->newMinor;
+        subminor = m->newSubminor;
+    }
+    return true;
+}
+
 bool
 Snapshot::isSnapshot(const uint8_t *buffer, size_t length)
 {
@@ -42,7 +246,8 @@ Snapshot::isSnapshot(const uint8_t *buffer, size_t length,
 bool
 Snapshot::isSupportedSnapshot(const uint8_t *buffer, size_t length)
 {
-    return isSnapshot(buffer, length, V_MAJOR, V_MINOR, V_SUBMINOR);
+    if (!isSnapshot(buffer, length)) return false;
+    return isSupportedVersion(buffer[4], buffer[5], buffer[6]);
 }
 
 bool
@@ -78,7 +283,17 @@ Snapshot::isSnapshotFile(const char *path, uint8_t major, uint8_t minor, uint8_t
 bool
 Snapshot::isSupportedSnapshotFile(const char *path)
 {
-    return isSnapshotFile(path, V_MAJOR, V_MINOR, V_SUBMINOR);
+    uint8_t header[7];
+    
+    assert(path != NULL);
+    
+    if (!isSnapshotFile(path))
+        return false;
+    
+    if (readFileHeader(path, header, sizeof(header)) != sizeof(header))
+        return false;
+    
+    return isSupportedVersion(header[4], header[5], header[6]);
 }
 
 bool
@@ -147,10 +362,104 @@ Snapshot::makeWithC64(C64 *c64)
     return snapshot;
 }
 
+bool
+Snapshot::upgradeSnapshotFile(const char *path)
+{
+    uint8_t header[7];
+    
+    assert(path != NULL);
+    
+    // Leave the file untouched if it is up to date already
+    if (readFileHeader(path, header, sizeof(header)) == sizeof(header) &&
+        checkBufferHeader(header, sizeof(header), magicBytes) &&
+        header[4] == V_MAJOR && header[5] == V_MINOR && header[6] == V_SUBMINOR) {
+        return true;
+    }
+    
+    Snapshot *snapshot = makeWithFile(path);
+    
+    if (snapshot == NULL)
+        return false;
+    
+    bool result = snapshot->writeToFile(path);
+    delete snapshot;
+    return result;
+}
+
 bool 
 Snapshot::hasSameType(const char *filename)
 {
-    return Snapshot::isSnapshotFile(filename, V_MAJOR, V_MINOR, V_SUBMINOR);
+    return Snapshot::isSupportedSnapshotFile(filename);
+}
+
+bool
+Snapshot::readFromBuffer(const uint8_t *buffer, size_t length)
+{
+    if (length < sizeof(SnapshotHeader) || !isSnapshot(buffer, length))
+        return false;
+    
+    if (!AnyC64File::readFromBuffer(buffer, length))
+        return false;
+    
+    return isUpToDate() || migrate();
+}
+
+bool
+Snapshot::isUpToDate()
+{
+    SnapshotHeader *header = getHeader();
+    
+    return
+    header->major == V_MAJOR &&
+    header->minor == V_MINOR &&
+    header->subminor == V_SUBMINOR;
+}
+
+bool
+Snapshot::migrate()
+{
+    const SnapshotMigration *m;
+    unsigned steps = 0;
+    
+    while (!isUpToDate()) {
+        
+        SnapshotHeader *header = getHeader();
+        if (!(m = findMigration(header->major, header->minor, header->subminor)) ||
+            ++steps > maxMigrationSteps) {
+            warn("No migration path for snapshot version %d.%d.%d\n",
+                 header->major, header->minor, header->subminor);
+            return false;
+        }
+        
+        // Run the migration function on the core data
+        SnapshotStream stream(getData(), size - sizeof(SnapshotHeader));
+        if (!m->migrate(stream) || stream.remaining() != 0) {
+            warn("Failed to migrate snapshot version %d.%d.%d\n",
+                 header->major, header->minor, header->subminor);
+            return false;
+        }
+        
+        // Replace the core data by the migrated data
+        std::vector<uint8_t> &result = stream.result();
+        size_t newSize = sizeof(SnapshotHeader) + result.size();
+        uint8_t *newData = new uint8_t[newSize];
+        memcpy(newData, data, sizeof(SnapshotHeader));
+        memcpy(newData + sizeof(SnapshotHeader), result.data(), result.size());
+        
+        dealloc();
+        data = newData;
+        size = eof = newSize;
+        fp = 0;
+        
+        header = getHeader();
+        header->major = m->newMajor;
+        header->minor = m->newMinor;
+        header->subminor = m->newSubminor;
+        
+        debug(2, "Snapshot migrated to version %d.%d.%d\n",
+              header->major, header->minor, header->subminor);
+    }
+    return true;
 }
 
 void
@@ -23,9 +23,11 @@
 #define _SNAPSHOT_INC
 
 #include "AnyC64File.h"
+#include <vector>
 
 // Forward declarations
 class C64;
+class VirtualComponent;
 
 // Snapshot header
 typedef struct {
@@ -55,6 +57,92 @@ typedef struct {
 } SnapshotHeader;
 
 
+/*! @brief    Streaming rewriter used by snapshot migration functions
+ *  @details  A migration function walks through the core data of an outdated
+ *            snapshot from front to back and tells the stream which parts to
+ *            keep, to drop, or to add. The result is written into a freshly
+ *            allocated buffer in a single pass.
+ */
+class SnapshotStream {
+    
+    //! @brief    Read pointer into the outdated snapshot data
+    const uint8_t *src;
+    
+    //! @brief    End of the outdated snapshot data
+    const uint8_t *end;
+    
+    //! @brief    Migrated snapshot data
+    std::vector<uint8_t> dst;
+    
+    public:
+    
+    SnapshotStream(const uint8_t *data, size_t length);
+    
+    //! @brief    Returns the number of bytes that haven't been processed yet
+    size_t remaining() { return end - src; }
+    
+    //! @brief    Returns the migrated data
+    std::vector<uint8_t> &result() { return dst; }
+    
+    //! @brief    Copies the next n bytes unmodified
+    bool copy(size_t n);
+    
+    //! @brief    Copies all remaining bytes unmodified
+    bool copyRest() { return copy(remaining()); }
+    
+    //! @brief    Drops the next n bytes
+    bool skip(size_t n);
+    
+    //! @brief    Returns the read pointer
+    const uint8_t *position() { return src; }
+    
+    /*! @brief    Peeks a big endian value without consuming it
+     *  @return   -1, if not enough data is left.
+     */
+    int peek8() { return remaining() < 1 ? -1 : src[0]; }
+    int peek16() { return remaining() < 2 ? -1 : HI_LO(src[0], src[1]); }
+    
+    /*! @brief    Copies the state of a component unmodified
+     *  @details  The data is parsed by loading it into the component. Hence,
+     *            components of variable size (e.g., the expansion port) can
+     *            be passed over, as long as their layout hasn't changed
+     *            between the two versions. The component is modified.
+     *  @return   false, if the component has consumed more data than left.
+     */
+    bool copyComponent(VirtualComponent *component);
+    
+    //! @brief    Adds new data in big endian format
+    void insert8(uint8_t value) { dst.push_back(value); }
+    void insert16(uint16_t value) { insert8(HI_BYTE(value)); insert8(LO_BYTE(value)); }
+    void insert32(uint32_t value) { insert16(value >> 16); insert16(value & 0xFFFF); }
+    void insert64(uint64_t value) { insert32(value >> 32); insert32(value & 0xFFFFFFFF); }
+    void insertZeroes(size_t n) { dst.insert(dst.end(), n, 0); }
+};
+
+/*! @brief    Converts the core data of a snapshot to the next version
+ *  @return   false, if the data could not be converted.
+ */
+typedef bool (*SnapshotMigrator)(SnapshotStream &stream);
+
+//! @brief    Entry of the snapshot schema registry
+typedef struct {
+    
+    //! @brief    Version of the outdated snapshot
+    uint8_t major;
+    uint8_t minor;
+    uint8_t subminor;
+    
+    //! @brief    Version of the snapshot created by the migration function
+    uint8_t newMajor;
+    uint8_t newMinor;
+    uint8_t newSubminor;
+    
+    //! @brief    Migration function
+    SnapshotMigrator migrate;
+    
+} SnapshotMigration;
+
+
 /*! @class   Snapshot
  *  @brief   The Snapshot class declares the programmatic interface for a file
  *           in V64 format (VirtualC64 snapshot files).
@@ -66,6 +154,21 @@ class Snapshot : public AnyC64File {
     //! @brief    Header signature
     static const uint8_t magicBytes[];
     
+    /*! @brief    Schema registry
+     *  @details  Lists all migration functions that are known to this release.
+     *            The list is terminated by an entry with a NULL function.
+     */
+    static const SnapshotMigration migrations[];
+    
+    /*! @brief    Maximum number of migrations applied to a single snapshot
+     *  @details  Guards against cycles in the schema registry.
+     */
+    static const unsigned maxMigrationSteps;
+    
+    //! @brief    Looks up the migration function for a certain version
+    static const SnapshotMigration *findMigration(uint8_t major, uint8_t minor,
+                                                  uint8_t subminor);
+    
     
     //
     //! @functiongroup Class methods
@@ -80,6 +183,11 @@ class Snapshot : public AnyC64File {
     static bool isSnapshot(const uint8_t *buffer, size_t length,
                            uint8_t major, uint8_t minor, uint8_t subminor);
     
+    /*! @brief    Returns true iff a snapshot of the specified version can be
+     *            loaded, either directly or by applying migration functions.
+     */
+    static bool isSupportedVersion(uint8_t major, uint8_t minor, uint8_t subminor);
+    
     //! @brief    Returns true iff buffer contains a snapshot with a supported version number.
     static bool isSupportedSnapshot(const uint8_t *buffer, size_t length);
     
@@ -121,6 +229,13 @@ class Snapshot : public AnyC64File {
     //! @brief    Factory method
     static Snapshot *makeWithC64(C64 *c64);
     
+    /*! @brief    Upgrades a snapshot file to the current version in place.
+     *  @details  The function has no side effects besides file access. Hence,
+     *            large collections of snapshot files can be upgraded by calling
+     *            it from multiple threads in parallel.
+     */
+    static bool upgradeSnapshotFile(const char *path);
+    
     
     //
     //! @functiongroup Methods from AnyC64File
@@ -129,6 +244,22 @@ class Snapshot : public AnyC64File {
     C64FileType type() { return V64_FILE; }
     const char *typeAsString() { return "V64"; }
     bool hasSameType(const char *filename);
+    bool readFromBuffer(const uint8_t *buffer, size_t length);
+    
+    
+    //
+    //! @functiongroup Migrating snapshots
+    //
+    
+    //! @brief    Returns true iff the snapshot matches the current version
+    bool isUpToDate();
+    
+    /*! @brief    Converts the snapshot to the current version.
+     *  @details  The registered migration functions are applied one after
+     *            another until the current version has been reached.
+     *  @return   false, if no migration path exists or a migration failed.
+     */
+    bool migrate();
     
     
     //
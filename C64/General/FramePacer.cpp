@@ -0,0 +1,193 @@
+/*!
+ * @header      FramePacer.cpp
+ * @author      Dirk W. Hoffmann, www.dirkwhoffmann.de
+ * @copyright   Dirk W. Hoffmann. All rights reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "FramePacer.h"
+
+#ifdef __APPLE__
+static mach_timebase_info_data_t timebase;
+#endif
+
+FramePacer::FramePacer()
+{
+    setDescription("FramePacer");
+    
+#ifdef __APPLE__
+    mach_timebase_info(&timebase);
+#endif
+    
+    clearStatistics();
+}
+
+uint64_t
+FramePacer::now()
+{
+#ifdef __APPLE__
+    return mach_absolute_time() * timebase.numer / timebase.denom;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+void
+FramePacer::sleepUntil(uint64_t nanos)
+{
+#ifdef __APPLE__
+    mach_wait_until(nanos * timebase.denom / timebase.numer);
+#else
+    struct timespec ts;
+    ts.tv_sec = (time_t)(nanos / 1000000000);
+    ts.tv_nsec = (long)(nanos % 1000000000);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) { }
+#endif
+}
+
+void
+FramePacer::setMaxCorrection(int32_t ppm)
+{
+    maxCorrection = MAX(ppm, 0);
+    correction = MAX(MIN(correction, maxCorrection), -maxCorrection);
+}
+
+void
+FramePacer::restart(uint64_t frameDelay)
+{
+    targetTime = now() + frameDelay;
+}
+
+void
+FramePacer::feedAudio(uint32_t readPtr, double fill, double target)
+{
+    bool consuming = readPtr != lastReadPtr;
+    lastReadPtr = readPtr;
+    
+    if (!consuming) {
+        
+        // Nobody listens. Fade out the correction.
+        correction /= 2;
+        smoothedFill = -1.0;
+        return;
+    }
+    
+    // Smooth out the fill level, because the consumer reads in chunks
+    if (smoothedFill < 0.0) smoothedFill = fill;
+    smoothedFill += (fill - smoothedFill) * 0.02;
+    
+    // Slow down if the buffer fills up, speed up if it runs dry. A deviation
+    // of 10% of the buffer size results in the maximum correction.
+    double error = (smoothedFill - target) * 10.0;
+    error = MAX(MIN(error, 1.0), -1.0);
+    correction = (int32_t)(error * maxCorrection);
+}
+
+int64_t
+FramePacer::pace(uint64_t frameDelay)
+{
+    uint64_t time = now();
+    
+    // Restart the timer if we're far off (e.g., after the emulator was paused)
+    int64_t timediff = (int64_t)targetTime - (int64_t)time;
+    if (timediff > 200000000 || timediff < -200000000 /* 0.2 sec */) {
+        
+        debug(2, "Emulator lost synchronization (%lld). Restarting timer.\n", timediff);
+        targetTime = time;
+        restarts++;
+    }
+    
+    int64_t jitter = 0;
+    
+    if (time < targetTime) {
+        
+        // Sleep coarsely and spin for the rest of the time
+        if (targetTime - time > spinThreshold) {
+            sleepUntil(targetTime - spinThreshold);
+        }
+        while ((jitter = (int64_t)now() - (int64_t)targetTime) < 0) { }
+        recordJitter(jitter);
+        
+    } else {
+        
+        // We're late. Don't sleep at all.
+        jitter = (int64_t)(time - targetTime);
+        lateFrames++;
+        recordJitter(jitter);
+    }
+    
+    // Compute the wake-up time of the next frame
+    targetTime += frameDelay + (int64_t)frameDelay * correction / 1000000;
+    
+    return jitter;
+}
+
+void
+FramePacer::recordJitter(int64_t jitter)
+{
+    uint64_t micros = (uint64_t)MAX(jitter, 0) / 1000;
+    
+    unsigned bucket = 0;
+    while (micros && bucket < PACER_HISTOGRAM_SIZE - 1) {
+        micros >>= 1;
+        bucket++;
+    }
+    
+    histogram[bucket]++;
+    frames++;
+    totalJitter += MAX(jitter, 0);
+    maxJitter = MAX(maxJitter, (uint64_t)MAX(jitter, 0));
+}
+
+void
+FramePacer::clearStatistics()
+{
+    for (unsigned i = 0; i < PACER_HISTOGRAM_SIZE; i++) {
+        histogram[i] = 0;
+    }
+    frames = 0;
+    lateFrames = 0;
+    maxJitter = 0;
+    totalJitter = 0;
+    restarts = 0;
+}
+
+void
+FramePacer::dump()
+{
+    msg("FramePacer:\n");
+    msg("-----------\n\n");
+    msg(" Spin threshold : %lld usec\n", spinThreshold / 1000);
+    msg("     Correction : %d ppm (max %d ppm)\n", correction, maxCorrection);
+    msg("         Frames : %lld (%lld late)\n", frames, lateFrames);
+    msg("         Jitter : %lld usec average, %lld usec max\n",
+        getAverageJitter() / 1000, maxJitter / 1000);
+    msg("       Restarts : %lld\n\n", restarts);
+    
+    for (unsigned i = 0; i < PACER_HISTOGRAM_SIZE; i++) {
+        if (histogram[i] == 0) continue;
+        if (i == 0) {
+            msg("        < 1 usec : %lld\n", histogram[i]);
+        } else if (i == PACER_HISTOGRAM_SIZE - 1) {
+            msg("   >= %6d usec : %lld\n", 1 << (i - 1), histogram[i]);
+        } else {
+            msg("   < %7d usec : %lld\n", 1 << i, histogram[i]);
+        }
+    }
+    msg("\n");
+}
@@ -0,0 +1,160 @@
+/*!
+ * @header      FramePacer.h
+ * @author      Dirk W. Hoffmann, www.dirkwhoffmann.de
+ * @copyright   Dirk W. Hoffmann. All rights reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _FRAMEPACER_INC
+#define _FRAMEPACER_INC
+
+#include "VC64Object.h"
+
+//! @brief    Number of buckets of the jitter histogram
+#define PACER_HISTOGRAM_SIZE 16
+
+/*! @brief    Paces the emulator thread to the frame rate of the emulated machine
+ *  @details  The pacer sleeps until shortly before the target time and spins
+ *            for the rest of the time. On macOS, it sleeps with
+ *            mach_wait_until(). On other systems, it sleeps with
+ *            clock_nanosleep() and an absolute time. Target times are
+ *            computed by adding the frame delay to the previous target
+ *            time. Hence, wake-up jitter does not accumulate.
+ *            If the audio ring buffer is consumed, the frame delay is
+ *            stretched or shrunk slightly to keep the fill level at its
+ *            target value. This keeps the emulator in sync with the audio
+ *            clock. Without the correction, the fill level slowly drifts
+ *            until the buffer underflows or overflows.
+ */
+class FramePacer : public VC64Object {
+    
+    private:
+    
+    //! @brief    Wake-up time of the next frame in nanoseconds
+    uint64_t targetTime = 0;
+    
+    //! @brief    Time spent spinning before the target time in nanoseconds
+    uint64_t spinThreshold = 1500000;
+    
+    //! @brief    Maximum frame delay correction in parts per million
+    int32_t maxCorrection = 5000;
+    
+    //! @brief    Current frame delay correction in parts per million
+    int32_t correction = 0;
+    
+    //! @brief    Smoothed audio buffer fill level
+    double smoothedFill = -1.0;
+    
+    //! @brief    Read pointer of the audio buffer seen in the previous frame
+    uint32_t lastReadPtr = 0;
+    
+    /*! @brief    Jitter histogram
+     *  @details  Bucket 0 counts frames that woke up less than 1 microsecond
+     *            late, bucket n counts frames that woke up between 2^(n-1)
+     *            and 2^n microseconds late. The last bucket collects all
+     *            remaining frames.
+     */
+    uint64_t histogram[PACER_HISTOGRAM_SIZE];
+    
+    //! @brief    Jitter statistics in nanoseconds
+    uint64_t frames = 0;
+    uint64_t lateFrames = 0;
+    uint64_t maxJitter = 0;
+    uint64_t totalJitter = 0;
+    
+    //! @brief    Number of times the timer had to be restarted
+    uint64_t restarts = 0;
+    
+    public:
+    
+    //! @brief    Constructor
+    FramePacer();
+    
+    //! @brief    Prints the configuration and the jitter histogram
+    void dump();
+    
+    
+    //
+    //! @functiongroup Accessing the system clock
+    //
+    
+    //! @brief    Returns the value of a monotonic clock in nanoseconds
+    static uint64_t now();
+    
+    //! @brief    Sleeps until the monotonic clock has reached a certain value
+    static void sleepUntil(uint64_t nanos);
+    
+    
+    //
+    //! @functiongroup Configuring
+    //
+    
+    uint64_t getSpinThreshold() { return spinThreshold; }
+    void setSpinThreshold(uint64_t nanos) { spinThreshold = nanos; }
+    
+    int32_t getMaxCorrection() { return maxCorrection; }
+    void setMaxCorrection(int32_t ppm);
+    
+    
+    //
+    //! @functiongroup Pacing
+    //
+    
+    //! @brief    Forces the timer to restart in the next call to pace()
+    void invalidate() { targetTime = 0; }
+    
+    //! @brief    Restarts the timer. The next frame is due in one frame delay.
+    void restart(uint64_t frameDelay);
+    
+    /*! @brief    Reports the state of the audio ring buffer
+     *  @details  Call this function once per frame before pace(). If the
+     *            read pointer hasn't moved since the last call, nobody
+     *            consumes audio and the correction fades out.
+     *  @param    fill     Current fill level (0.0 to 1.0)
+     *  @param    target   Desired fill level (0.0 to 1.0)
+     */
+    void feedAudio(uint32_t readPtr, double fill, double target);
+    
+    /*! @brief    Waits until the current frame is due
+     *  @param    frameDelay   Nominal duration of a frame in nanoseconds
+     *  @return   Wake-up jitter in nanoseconds
+     */
+    int64_t pace(uint64_t frameDelay);
+    
+    
+    //
+    //! @functiongroup Querying statistics
+    //
+    
+    int32_t getCorrection() { return correction; }
+    uint64_t getHistogram(unsigned bucket) {
+        return bucket < PACER_HISTOGRAM_SIZE ? histogram[bucket] : 0; }
+    uint64_t getFrames() { return frames; }
+    uint64_t getLateFrames() { return lateFrames; }
+    uint64_t getMaxJitter() { return maxJitter; }
+    uint64_t getAverageJitter() { return frames ? totalJitter / frames : 0; }
+    uint64_t getRestarts() { return restarts; }
+    
+    //! @brief    Clears the jitter histogram and all other statistics
+    void clearStatistics();
+    
+    private:
+    
+    //! @brief    Adds a wake-up jitter to the statistics
+    void recordJitter(int64_t jitter);
+};
+
+#endif
@@ -0,0 +1,235 @@
+/*!
+ * @header      FramePipeline.cpp
+ * @author      Dirk W. Hoffmann, www.dirkwhoffmann.de
+ * @copyright   Dirk W. Hoffmann. All rights reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "FramePipeline.h"
+
+static void *
+runFrameWorker(void *pipeline)
+{
+    ((FramePipeline *)pipeline)->runWorker();
+    return NULL;
+}
+
+FramePipeline::FramePipeline()
+{
+    setDescription("FramePipeline");
+    
+    pthread_mutex_init(&lock, NULL);
+    pthread_cond_init(&notEmpty, NULL);
+    pthread_cond_init(&notFull, NULL);
+}
+
+FramePipeline::~FramePipeline()
+{
+    setEnabled(false);
+    
+    for (FrameRecord *record : pool) delete record;
+    pthread_cond_destroy(&notFull);
+    pthread_cond_destroy(&notEmpty);
+    pthread_mutex_destroy(&lock);
+}
+
+void
+FramePipeline::setEnabled(bool value)
+{
+    if (value == enabled) return;
+    
+    if (value) {
+        
+        quit = false;
+        if (pthread_create(&worker, NULL, runFrameWorker, this) != 0) {
+            warn("Failed to create presentation thread.\n");
+            return;
+        }
+        
+    } else {
+        
+        flush();
+        pthread_mutex_lock(&lock);
+        quit = true;
+        pthread_cond_signal(&notEmpty);
+        pthread_mutex_unlock(&lock);
+        pthread_join(worker, NULL);
+        
+        pendingMessages.clear();
+    }
+    
+    enabled = value;
+    debug(2, "Frame pipeline %s\n", enabled ? "enabled" : "disabled");
+}
+
+void
+FramePipeline::setConsumer(FrameConsumer *func, const void *ctx)
+{
+    assert(!enabled);
+    
+    consumer = func;
+    context = ctx;
+}
+
+void
+FramePipeline::setCapacity(size_t value)
+{
+    pthread_mutex_lock(&lock);
+    capacity = MAX(value, 1);
+    pthread_mutex_unlock(&lock);
+}
+
+FrameRecord *
+FramePipeline::acquire()
+{
+    FrameRecord *result;
+    
+    pthread_mutex_lock(&lock);
+    if (pool.empty()) {
+        result = new FrameRecord();
+    } else {
+        result = pool.back();
+        pool.pop_back();
+    }
+    pthread_mutex_unlock(&lock);
+    
+    result->samples.clear();
+    result->messages.clear();
+    return result;
+}
+
+void
+FramePipeline::recycle(FrameRecord *record)
+{
+    pool.push_back(record);
+}
+
+void
+FramePipeline::submit(FrameRecord *record)
+{
+    pthread_mutex_lock(&lock);
+    
+    record->messages.swap(pendingMessages);
+    pendingMessages.clear();
+    
+    if (queue.size() >= capacity) {
+        
+        if (dropWhenFull) {
+            
+            recycle(queue.front());
+            queue.pop_front();
+            dropped++;
+            
+        } else {
+            
+            // The emulator thread might get cancelled while waiting
+            stalls++;
+            stalled = record;
+            pthread_cleanup_push(cancelSubmit, this);
+            while (queue.size() >= capacity) {
+                pthread_cond_wait(&notFull, &lock);
+            }
+            pthread_cleanup_pop(0);
+            stalled = NULL;
+        }
+    }
+    
+    queue.push_back(record);
+    pthread_cond_signal(&notEmpty);
+    pthread_mutex_unlock(&lock);
+}
+
+void
+FramePipeline::cancelSubmit(void *pipeline)
+{
+    FramePipeline *p = (FramePipeline *)pipeline;
+    
+    // Keep the messages for the next frame
+    p->pendingMessages.swap(p->stalled->messages);
+    p->recycle(p->stalled);
+    p->stalled = NULL;
+    
+    // pthread_cond_wait has reacquired the lock before the handler was called
+    pthread_mutex_unlock(&p->lock);
+}
+
+void
+FramePipeline::recordMessage(MessageType type, long data)
+{
+    Message msg = { type, data };
+    
+    pthread_mutex_lock(&lock);
+    pendingMessages.push_back(msg);
+    pthread_mutex_unlock(&lock);
+}
+
+void
+FramePipeline::flush()
+{
+    pthread_mutex_lock(&lock);
+    while (!queue.empty() || busy) {
+        pthread_cond_wait(&notFull, &lock);
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+void
+FramePipeline::runWorker()
+{
+    pthread_mutex_lock(&lock);
+    
+    while (true) {
+        
+        while (queue.empty() && !quit) {
+            pthread_cond_wait(&notEmpty, &lock);
+        }
+        if (queue.empty()) break;
+        
+        FrameRecord *record = queue.front();
+        queue.pop_front();
+        busy = true;
+        pthread_mutex_unlock(&lock);
+        
+        if (consumer) consumer(context, record);
+        
+        pthread_mutex_lock(&lock);
+        recycle(record);
+        busy = false;
+        delivered++;
+        pthread_cond_broadcast(&notFull);
+    }
+    
+    pthread_mutex_unlock(&lock);
+}
+
+void
+FramePipeline::dump()
+{
+    pthread_mutex_lock(&lock);
+    size_t queued = queue.size();
+    size_t pooled = pool.size();
+    pthread_mutex_unlock(&lock);
+    
+    msg("FramePipeline:\n");
+    msg("--------------\n\n");
+    msg("        Enabled : %s\n", enabled ? "yes" : "no");
+    msg("       Capacity : %d frames (%s when full)\n",
+        capacity, dropWhenFull ? "drop" : "wait");
+    msg("         Queued : %d (%d recycled records)\n", queued, pooled);
+    msg("      Delivered : %lld\n", delivered);
+    msg("        Dropped : %lld\n", dropped);
+    msg("         Stalls : %lld\n\n", stalls);
+}
@@ -0,0 +1,199 @@
+/*!
+ * @header      FramePipeline.h
+ * @author      Dirk W. Hoffmann, www.dirkwhoffmann.de
+ * @copyright   Dirk W. Hoffmann. All rights reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _FRAMEPIPELINE_INC
+#define _FRAMEPIPELINE_INC
+
+#include "VC64Object.h"
+#include "C64_types.h"
+#include <vector>
+#include <deque>
+
+//! @brief    Everything the emulator has produced in a single frame
+typedef struct {
+    
+    //! @brief    Frame number
+    uint64_t frame;
+    
+    //! @brief    CPU cycle at the end of the frame
+    uint64_t cycle;
+    
+    //! @brief    Indicates if the frame has been computed in warp mode
+    bool warp;
+    
+    //! @brief    The finished screen buffer
+    std::vector<int> pixels;
+    
+    //! @brief    Audio samples produced in this frame
+    std::vector<float> samples;
+    
+    //! @brief    Messages sent in this frame
+    std::vector<Message> messages;
+    
+} FrameRecord;
+
+//! @brief    Callback invoked on the presentation thread for each frame
+typedef void FrameConsumer(const void *context, const FrameRecord *record);
+
+/*! @brief    Hands off finished frames to a presentation thread
+ *  @details  At the end of each frame, the emulator thread copies the screen
+ *            buffer, the audio samples, and the messages of the frame into a
+ *            FrameRecord and puts it into a bounded queue. A worker thread
+ *            passes the records to the consumer. Hence, presenting or
+ *            encoding frame n overlaps with emulating frame n + 1.
+ *            If the queue is full, the emulator thread waits for the
+ *            consumer. Alternatively, the oldest queued frame is dropped.
+ *            Records are recycled to avoid allocating buffers in each frame.
+ *  @note     The consumer must not suspend or halt the emulator, because the
+ *            emulator thread might be waiting for the consumer.
+ */
+class FramePipeline : public VC64Object {
+    
+    private:
+    
+    //! @brief    Indicates if the worker thread is running
+    bool enabled = false;
+    
+    //! @brief    Maximum number of queued frames
+    size_t capacity = 3;
+    
+    //! @brief    Drop the oldest frame instead of waiting if the queue is full
+    bool dropWhenFull = false;
+    
+    //! @brief    The consumer and its context
+    FrameConsumer *consumer = NULL;
+    const void *context = NULL;
+    
+    //! @brief    The worker thread
+    pthread_t worker;
+    
+    //! @brief    Protects all variables below
+    pthread_mutex_t lock;
+    
+    //! @brief    Signals a new frame or a request to quit
+    pthread_cond_t notEmpty;
+    
+    //! @brief    Signals that the consumer has finished a frame
+    pthread_cond_t notFull;
+    
+    //! @brief    Frames waiting for the consumer
+    std::deque<FrameRecord *> queue;
+    
+    //! @brief    Recycled records
+    std::vector<FrameRecord *> pool;
+    
+    //! @brief    Messages sent since the last frame has been submitted
+    std::vector<Message> pendingMessages;
+    
+    //! @brief    Indicates that the consumer is processing a frame
+    bool busy = false;
+    
+    //! @brief    Asks the worker thread to terminate
+    bool quit = false;
+    
+    //! @brief    Record of a submit() call waiting for a free slot
+    FrameRecord *stalled = NULL;
+    
+    //! @brief    Statistics
+    uint64_t delivered = 0;
+    uint64_t dropped = 0;
+    uint64_t stalls = 0;
+    
+    public:
+    
+    //! @brief    Constructor
+    FramePipeline();
+    
+    //! @brief    Destructor
+    ~FramePipeline();
+    
+    //! @brief    Prints the queue state and statistics
+    void dump();
+    
+    
+    //
+    //! @functiongroup Configuring
+    //
+    
+    bool isEnabled() { return enabled; }
+    
+    /*! @brief    Starts or stops the worker thread
+     *  @details  When stopping, all queued frames are delivered first.
+     */
+    void setEnabled(bool value);
+    
+    //! @brief    Sets the consumer. Must be called while the pipeline is disabled.
+    void setConsumer(FrameConsumer *func, const void *ctx);
+    
+    size_t getCapacity() { return capacity; }
+    void setCapacity(size_t value);
+    
+    bool getDropWhenFull() { return dropWhenFull; }
+    void setDropWhenFull(bool value) { dropWhenFull = value; }
+    
+    
+    //
+    //! @functiongroup Feeding the pipeline
+    //
+    
+    /*! @brief    Returns an empty record to be filled by the emulator thread
+     *  @details  The record must be passed back with submit().
+     */
+    FrameRecord *acquire();
+    
+    /*! @brief    Queues a filled record
+     *  @details  The messages collected by recordMessage() are attached. If
+     *            the queue is full, the function waits for the consumer or
+     *            drops the oldest frame.
+     */
+    void submit(FrameRecord *record);
+    
+    //! @brief    Collects a message for the frame that is currently emulated
+    void recordMessage(MessageType type, long data);
+    
+    //! @brief    Waits until all queued frames have been delivered
+    void flush();
+    
+    //! @brief    Entry point of the worker thread
+    void runWorker();
+    
+    
+    //
+    //! @functiongroup Querying statistics
+    //
+    
+    uint64_t getDelivered() { return delivered; }
+    uint64_t getDropped() { return dropped; }
+    uint64_t getStalls() { return stalls; }
+    
+    private:
+    
+    //! @brief    Returns a record to the pool (lock must be held)
+    void recycle(FrameRecord *record);
+    
+    /*! @brief    Cleanup handler of submit()
+     *  @details  Invoked if the emulator thread is cancelled while waiting
+     *            for a free slot. The stalled record is returned to the pool
+     *            and the lock is released.
+     */
+    static void cancelSubmit(void *pipeline);
+};
+
+#endif
@@ -22,85 +22,196 @@
 #ifndef _TIME_DELAYED_INC
 #define _TIME_DELAYED_INC
 
-template <class T> class TimeDelayed {
-    
-    private:
-    
-    /*! @brief    Value pipeline (history buffer)
-     *  @details  Semantics:
-     *            pipeline[0]: Value that was written at time timeStamp
-     *            pipeline[n]: Value that was written at time timeStamp - n
-     */
-    T *pipeline = NULL;
-    
+#include "basic.h"
+#include <array>
+
+/*! @brief    Storage backend of a TimeDelayed pipeline
+ *  @details  The generic implementation keeps all pipeline elements in a
+ *            fixed size array. Semantics:
+ *            get(0): Value that was written at time timeStamp
+ *            get(n): Value that was written at time timeStamp - n
+ */
+template <class T, int capacity, bool packed> class DelayPipeline {
+
+    std::array<T, capacity> slot;
+
+    public:
+
+    T get(int i) const { return slot[i]; }
+    void set(int i, T value) { slot[i] = value; }
+    void fill(T value) { slot.fill(value); }
+
+    //! @brief   Ages all elements by diff cycles.
+    void shift(int64_t diff) {
+        if (diff <= 0) return;
+        for (int i = capacity - 1; i > 0; i--) {
+            slot[i] = (i - diff > 0) ? slot[i - diff] : slot[0];
+        }
+    }
+};
+
+/*! @brief    Shift register implementation of a TimeDelayed pipeline
+ *  @details  If the pipeline fits into 64 bits and its capacity is a power of
+ *            two, all elements are packed into a single integer. Element n
+ *            occupies bits n * width ... (n + 1) * width - 1. Aging the
+ *            pipeline boils down to a single shift operation.
+ */
+template <class T, int capacity> class DelayPipeline<T, capacity, true> {
+
+    static constexpr int width = 8 * sizeof(T);
+    static constexpr uint64_t mask = (width == 64) ? ~0ULL : (1ULL << width) - 1;
+
+    //! @brief   Bit pattern with the lowest bit of each element set
+    static constexpr uint64_t ones = ~0ULL / mask;
+
+    uint64_t bits = 0;
+
+    public:
+
+    T get(int i) const { return (T)((bits >> (i * width)) & mask); }
+    void set(int i, T value) {
+        bits = (bits & ~(mask << (i * width))) | (((uint64_t)value & mask) << (i * width));
+    }
+    void fill(T value) { bits = ((uint64_t)value & mask) * ones; }
+
+    //! @brief   Ages all elements by diff cycles.
+    void shift(int64_t diff) {
+        if (diff <= 0) return;
+        uint64_t head = ((bits & mask) * ones);
+        if (diff >= capacity) {
+            bits = head;
+        } else {
+            uint64_t low = (1ULL << (diff * width)) - 1;
+            bits = (bits << (diff * width)) | (head & low);
+        }
+    }
+};
+
+/*! @brief    A value that shows up delayed by a fixed number of cycles
+ *  @details  The delay is a compile time constant and the value history is
+ *            stored inline. Hence, no heap allocation takes place and the
+ *            whole object can be kept in registers by the compiler.
+ *  @param    T is the type of the stored value.
+ *  @param    delay is the number of cycles to elapse until a written value
+ *            shows up.
+ */
+template <class T, int delay> class TimeDelayed {
+
+    public:
+
     //! @brief   Number of elements hold in pipeline
-    uint8_t capacity = 0;
-    
+    static constexpr int capacity = delay + 1;
+
+    //! @brief   Indicates if the pipeline is implemented as a shift register
+    static constexpr bool packed =
+    (capacity & (capacity - 1)) == 0 && capacity * sizeof(T) <= sizeof(uint64_t);
+
+    private:
+
+    //! @brief    Value pipeline (history buffer)
+    DelayPipeline<T, capacity, packed> pipeline;
+
     //! @brief  Remembers the time of the most recent call to write()
     int64_t timeStamp = 0;
-    
-    //! @brief  Number of cycles to elapse until a written value shows up
-    uint8_t delay = 0;
-    
+
     //! @brief   Pointer to reference clock
     int64_t *clock = NULL;
-    
+
     public:
-    
+
     //! @brief   Constructors
-    TimeDelayed(uint8_t delay, uint8_t capacity, uint64_t *clock);
-    TimeDelayed(uint8_t delay, uint8_t capacity) : TimeDelayed(delay, capacity, NULL) { };
-    TimeDelayed(uint8_t delay, uint64_t *clock) : TimeDelayed(delay, delay + 1, clock) { };
-    TimeDelayed(uint8_t delay) : TimeDelayed(delay, delay + 1, NULL) { };
-    
-    //! @brief   Destructor
-    ~TimeDelayed();
-    
+    TimeDelayed(uint64_t *clock) { setClock(clock); clear(); }
+    TimeDelayed() : TimeDelayed(NULL) { };
+
     /*! @brief   Sets the reference clock
      *  @param   clock is either the clock of the C64 CPU or the clock of the
      *           a drive CPU.
      */
     void setClock(uint64_t *clock) { this->clock = (int64_t *)clock; }
-    
+
     //! @brief   Overwrites all pipeline entries with a reset value.
     void reset(T value) {
-        for (unsigned i = 0; i < capacity; i++) pipeline[i] = value;
+        pipeline.fill(value);
         timeStamp = 0;
     }
-    
+
     //! @brief   Zeroes out all pipeline entries.
     void clear() { reset((T)0); }
-    
+
     //! @brief   Write a value into the pipeline.
     void write(T value) { writeWithDelay(value, 0); }
-    
+
     //! @brief   Work horse for writing a value.
-    void writeWithDelay(T value, uint8_t waitCycles);
-    
+    void writeWithDelay(T value, uint8_t waitCycles) {
+
+        int64_t referenceTime = *clock + waitCycles;
+
+        // Shift pipeline
+        pipeline.shift(referenceTime - timeStamp);
+
+        // Assign new value
+        timeStamp = referenceTime;
+        pipeline.set(0, value);
+    }
+
     //! @brief   Reads the most recent pipeline element.
-    T current() { return pipeline[0]; }
-    
+    T current() const { return pipeline.get(0); }
+
     //! @brief   Reads a value from the pipeline with the standard delay.
-    // T delayed() { return pipeline[MAX(0, timeStamp - *clock + delay)]; }
-    T delayed() {
+    T delayed() const {
         int64_t offset = timeStamp - *clock + delay;
         if (__builtin_expect(offset <= 0, 1)) {
-            return pipeline[0];
+            return pipeline.get(0);
         } else {
-            return pipeline[offset];
+            return pipeline.get((int)offset);
         }
     }
-    
+
     //! @brief   Reads a value from the pipeline with a custom delay.
-    T readWithDelay(uint8_t delay) {
-        assert(delay <= this->capacity);
-        return pipeline[MAX(0, timeStamp - *clock + delay)];
+    T readWithDelay(uint8_t d) const {
+        assert(d < capacity);
+        return pipeline.get((int)MAX(0, timeStamp - *clock + d));
+    }
+
+
+    //
+    //! @functiongroup Loading and saving snapshots
+    //
+
+    /*! @brief   Returns the size of the internal state in bytes
+     *  @details Each element is stored as a 64 bit value, followed by the
+     *           time stamp. The layout is independent of the storage backend.
+     */
+    static constexpr size_t stateSize() {
+        return capacity * sizeof(uint64_t) + sizeof(int64_t);
+    }
+
+    void loadFromBuffer(uint8_t **buffer) {
+        for (int i = 0; i < capacity; i++) {
+            pipeline.set(i, (T)read64(buffer));
+        }
+        timeStamp = read64(buffer);
+    }
+
+    void saveToBuffer(uint8_t **buffer) const {
+        for (int i = 0; i < capacity; i++) {
+            write64(buffer, (uint64_t)pipeline.get(i));
+        }
+        write64(buffer, timeStamp);
+    }
+
+    void debug() const {
+        for (int i = delay; i >= 0; i--) {
+            printf("%llX ", (uint64_t)pipeline.get(i));
+        }
+        printf("\n");
+
+        printf("delayed() = %llX\n", (uint64_t)delayed());
+        for (int i = 0; i <= delay; i++) {
+            printf("readWithDelay(%d) = %llX\n", i, (uint64_t)readWithDelay(i));
+        }
+        printf("timeStamp = %lld clock = %lld delay = %d\n", timeStamp, *clock, delay);
     }
-    
-    size_t stateSize();
-    void loadFromBuffer(uint8_t **buffer);
-    void saveToBuffer(uint8_t **buffer);
-    void debug();
 };
 
 #endif
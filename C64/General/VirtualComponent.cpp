@@ -31,6 +31,9 @@ VirtualComponent::~VirtualComponent()
 
     if (snapshotItems)
         delete [] snapshotItems;
+    
+    if (snapshotChunks)
+        delete [] snapshotChunks;
 }
 
 void
@@ -123,6 +126,61 @@ VirtualComponent::registerSnapshotItems(SnapshotItem *items, unsigned length) {
     // Determine size of snapshot on disk
     for (i = snapshotSize = 0; snapshotItems[i].data != NULL; i++)
         snapshotSize += snapshotItems[i].size;
+    
+    compileSnapshotChunks(numItems);
+}
+
+size_t
+VirtualComponent::elementWidth(SnapshotItem &item)
+{
+    switch (item.flags & 0x0F) {
+            
+        case 0: // Auto detect size
+            return (item.size == 2 || item.size == 4 || item.size == 8) ? item.size : 1;
+            
+        case BYTE_ARRAY: return 1;
+        case WORD_ARRAY: return 2;
+        case DWORD_ARRAY: return 4;
+        case QWORD_ARRAY: return 8;
+            
+        default:
+            assert(false);
+            return 1;
+    }
+}
+
+void
+VirtualComponent::compileSnapshotChunks(unsigned numItems)
+{
+    assert(snapshotChunks == NULL);
+    
+    // Allocate enough space to hold one chunk per item in the worst case
+    snapshotChunks = new SnapshotItem[numItems];
+    
+    unsigned numChunks = 0;
+    for (unsigned i = 0; snapshotItems[i].data != NULL; i++) {
+        
+        SnapshotItem &item = snapshotItems[i];
+        size_t width = elementWidth(item);
+        uint8_t format = (width == 1) ? BYTE_ARRAY : (width == 2) ? WORD_ARRAY :
+        (width == 4) ? DWORD_ARRAY : QWORD_ARRAY;
+        
+        // Append item to the previous chunk if it directly follows in memory
+        if (numChunks > 0) {
+            
+            SnapshotItem &last = snapshotChunks[numChunks - 1];
+            if (last.flags == format &&
+                (uint8_t *)last.data + last.size == (uint8_t *)item.data) {
+                last.size += item.size;
+                continue;
+            }
+        }
+        
+        snapshotChunks[numChunks++] = { item.data, item.size, format };
+    }
+    snapshotChunks[numChunks] = { NULL, 0, 0 };
+    
+    debug(3, "%d snapshot items merged into %d chunks\n", numItems - 1, numChunks);
 }
 
 size_t
@@ -153,32 +211,17 @@ VirtualComponent::loadFromBuffer(uint8_t **buffer)
             subComponents[i]->loadFromBuffer(buffer);
 
     // Load own internal state
-    void *data; size_t size; int flags;
-    for (unsigned i = 0; snapshotItems != NULL && snapshotItems[i].data != NULL; i++) {
+    for (unsigned i = 0; snapshotChunks != NULL && snapshotChunks[i].data != NULL; i++) {
         
-        data  = snapshotItems[i].data;
-        flags = snapshotItems[i].flags & 0x0F;
-        size  = snapshotItems[i].size;
+        void *data = snapshotChunks[i].data;
+        size_t size = snapshotChunks[i].size;
         
-        if (flags == 0) { // Auto detect size
-
-            switch (snapshotItems[i].size) {
-                case 1:  *(uint8_t *)data  = read8(buffer); break;
-                case 2:  *(uint16_t *)data = read16(buffer); break;
-                case 4:  *(uint32_t *)data = read32(buffer); break;
-                case 8:  *(uint64_t *)data = read64(buffer); break;
-                default: readBlock(buffer, (uint8_t *)data, size);
-            }
-
-        } else { // Format is specified manually
-            
-            switch (flags) {
-                case BYTE_ARRAY: readBlock(buffer, (uint8_t *)data, size); break;
-                case WORD_ARRAY: readBlock16(buffer, (uint16_t *)data, size); break;
-                case DWORD_ARRAY: readBlock32(buffer, (uint32_t *)data, size); break;
-                case QWORD_ARRAY: readBlock64(buffer, (uint64_t *)data, size); break;
-                default: assert(0);
-            }
+        switch (snapshotChunks[i].flags) {
+            case BYTE_ARRAY: readBlock(buffer, (uint8_t *)data, size); break;
+            case WORD_ARRAY: readBlock16(buffer, (uint16_t *)data, size); break;
+            case DWORD_ARRAY: readBlock32(buffer, (uint32_t *)data, size); break;
+            case QWORD_ARRAY: readBlock64(buffer, (uint64_t *)data, size); break;
+            default: assert(0);
         }
     }
     
@@ -210,32 +253,17 @@ VirtualComponent::saveToBuffer(uint8_t **buffer)
     }
     
     // Save own internal state
-    void *data; size_t size; int flags;
-    for (unsigned i = 0; snapshotItems != NULL && snapshotItems[i].data != NULL; i++) {
+    for (unsigned i = 0; snapshotChunks != NULL && snapshotChunks[i].data != NULL; i++) {
         
-        data  = snapshotItems[i].data;
-        flags = snapshotItems[i].flags & 0x0F;
-        size  = snapshotItems[i].size;
-
-        if (flags == 0) { // Auto detect size
-            
-            switch (snapshotItems[i].size) {
-                case 1:  write8(buffer, *(uint8_t *)data); break;
-                case 2:  write16(buffer, *(uint16_t *)data); break;
-                case 4:  write32(buffer, *(uint32_t *)data); break;
-                case 8:  write64(buffer, *(uint64_t *)data); break;
-                default: writeBlock(buffer, (uint8_t *)data, size);
-            }
-            
-        } else { // Format is specified manually
-            
-            switch (flags) {
-                case BYTE_ARRAY: writeBlock(buffer, (uint8_t *)data, size); break;
-                case WORD_ARRAY: writeBlock16(buffer, (uint16_t *)data, size); break;
-                case DWORD_ARRAY: writeBlock32(buffer, (uint32_t *)data, size); break;
-                case QWORD_ARRAY: writeBlock64(buffer, (uint64_t *)data, size); break;
-                default: assert(0);
-            }
+        void *data = snapshotChunks[i].data;
+        size_t size = snapshotChunks[i].size;
+        
+        switch (snapshotChunks[i].flags) {
+            case BYTE_ARRAY: writeBlock(buffer, (uint8_t *)data, size); break;
+            case WORD_ARRAY: writeBlock16(buffer, (uint16_t *)data, size); break;
+            case DWORD_ARRAY: writeBlock32(buffer, (uint32_t *)data, size); break;
+            case QWORD_ARRAY: writeBlock64(buffer, (uint64_t *)data, size); break;
+            default: assert(0);
         }
     }
     
@@ -249,3 +277,53 @@ VirtualComponent::saveToBuffer(uint8_t **buffer)
         assert(false);
     }
 }
+
+uint64_t
+VirtualComponent::fingerprint()
+{
+    size_t size = stateSize() - snapshotSize;
+    uint64_t hash = 0xcbf29ce484222325;
+    
+    // Combine the fingerprints of all sub components
+    if (subComponents != NULL) {
+        for (unsigned i = 0; subComponents[i] != NULL; i++) {
+            size -= subComponents[i]->stateSize();
+            hash = combineFingerprints(hash, subComponents[i]->fingerprint());
+        }
+    }
+    
+    // Hash the custom items written by the delegation methods
+    std::vector<uint8_t> buffer(size);
+    uint8_t *ptr = buffer.data();
+    
+    willSaveToBuffer(&ptr);
+    hash = fingerprintItems(hash);
+    didSaveToBuffer(&ptr);
+    assert(ptr - buffer.data() == (ptrdiff_t)buffer.size());
+    
+    return fnv_1a(buffer.data(), buffer.size(), hash);
+}
+
+uint64_t
+VirtualComponent::fingerprintItems(uint64_t hash)
+{
+    // Serialize the snapshot items like saveToBuffer() does
+    std::vector<uint8_t> buffer(snapshotSize);
+    uint8_t *ptr = buffer.data();
+    
+    for (unsigned i = 0; snapshotChunks != NULL && snapshotChunks[i].data != NULL; i++) {
+        
+        void *data = snapshotChunks[i].data;
+        size_t size = snapshotChunks[i].size;
+        
+        switch (snapshotChunks[i].flags) {
+            case BYTE_ARRAY: writeBlock(&ptr, (uint8_t *)data, size); break;
+            case WORD_ARRAY: writeBlock16(&ptr, (uint16_t *)data, size); break;
+            case DWORD_ARRAY: writeBlock32(&ptr, (uint32_t *)data, size); break;
+            case QWORD_ARRAY: writeBlock64(&ptr, (uint64_t *)data, size); break;
+            default: assert(0);
+        }
+    }
+    
+    return fnv_1a(buffer.data(), buffer.size(), hash);
+}
@@ -81,6 +81,15 @@ protected:
     //! @brief    List of snapshot items of this component
     SnapshotItem *snapshotItems = NULL;
     
+    /*! @brief    Snapshot items grouped into contiguous memory chunks
+     *  @details  This list is derived from snapshotItems when the items are
+     *            registered. Items that are adjacent in memory and share the
+     *            same element width are merged into a single chunk. Saving
+     *            and loading a snapshot operates on chunks which reduces the
+     *            number of copy operations significantly.
+     */
+    SnapshotItem *snapshotChunks = NULL;
+    
     //! @brief    Snapshot size on disk (in bytes)
     unsigned snapshotSize = 0;
     
@@ -173,6 +182,13 @@ public:
      */
     void registerSubComponents(VirtualComponent **subComponents, unsigned length);
     
+    /*! @brief    Returns the registered sub components
+     *  @details  The components are listed in the order they appear in a
+     *            snapshot. The end of the list is marked by a NULL pointer.
+     *  @return   NULL, if no sub components have been registered.
+     */
+    VirtualComponent **getSubComponents() { return subComponents; }
+    
     /*! @brief    Registers all snapshot items for this component
      *  @abstract Snaphshot items are usually registered in the constructor of
      *            a virtual component.
@@ -182,6 +198,14 @@ public:
      */
     void registerSnapshotItems(SnapshotItem *items, unsigned length);
     
+private:
+    
+    //! @brief    Returns the element width of a snapshot item in bytes
+    static size_t elementWidth(SnapshotItem &item);
+    
+    //! @brief    Merges adjacent snapshot items into snapshotChunks
+    void compileSnapshotChunks(unsigned numItems);
+    
 
 public:
     
@@ -223,6 +247,32 @@ public:
      */
     virtual void  willSaveToBuffer(uint8_t **buffer) { };
     virtual void  didSaveToBuffer(uint8_t **buffer) { };
+    
+    
+    //
+    //! @functiongroup Fingerprinting the internal state
+    //
+    
+    /*! @brief    Computes a 64-bit fingerprint of the internal state
+     *  @details  Two components have the same fingerprint if their snapshots
+     *            match (with a very high probability). By default, the own
+     *            snapshot items are serialized as they would be for a
+     *            snapshot and hashed together with the fingerprints of all
+     *            sub components. Components with large memory arrays
+     *            overwrite this function to rehash modified parts only.
+     */
+    virtual uint64_t fingerprint();
+    
+    protected:
+    
+    //! @brief    Continues a fingerprint computation with the own snapshot items
+    uint64_t fingerprintItems(uint64_t hash);
+    
+    public:
+    
+    //! @brief    Combines two fingerprints into one
+    static uint64_t combineFingerprints(uint64_t hash, uint64_t value) {
+        return fnv_1a((uint8_t *)&value, sizeof(value), hash); }
 };
 
 #endif
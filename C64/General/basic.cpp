@@ -231,24 +231,35 @@ checkFileSize(const char *filename, long min, long max)
 bool 
 checkFileHeader(const char *filename, const uint8_t *header)
 {
-	int i, c;
-	bool result = true;
-	FILE *file;
+	uint8_t buffer[64];
 
 	assert(filename != NULL);
 	assert(header != NULL);
 	
+	size_t length = strlen((const char *)header);
+	assert(length <= sizeof(buffer));
+
+	if (readFileHeader(filename, buffer, length) != length)
+		return false;
+
+	return memcmp(buffer, header, length) == 0;
+}
+
+size_t
+readFileHeader(const char *filename, uint8_t *buffer, size_t length)
+{
+	FILE *file;
+
+	assert(filename != NULL);
+	assert(buffer != NULL);
+
 	if ((file = fopen(filename, "r")) == NULL)
-		return false; 
-
-	for (i = 0; header[i] != 0; i++) {
-		c = fgetc(file);
-		if (c != (int)header[i]) {
-			result = false;
-			break;
-		}
-	}
-	    
+		return 0;
+
+	// Don't let stdio read ahead a full buffer
+	setvbuf(file, NULL, _IONBF, 0);
+	size_t result = fread(buffer, 1, length, file);
+
 	fclose(file);
 	return result;
 }
@@ -323,12 +334,83 @@ uint64_t
 fnv_1a(uint8_t *addr, size_t size)
 {
     uint64_t basis = 0xcbf29ce484222325;
-    uint64_t prime = 0x100000001b3;
-    uint64_t hash = basis;
+    
+    return fnv_1a(addr, size, basis);
+}
 
+uint64_t
+fnv_1a(uint8_t *addr, size_t size, uint64_t hash)
+{
+    uint64_t prime = 0x100000001b3;
+    
     for (size_t i = 0; i < size; i++) {
         hash = (hash ^ (uint64_t)addr[i]) * prime;
     }
     
     return hash;
 }
+
+size_t
+rleEncode(const uint8_t *src, size_t srcSize, uint8_t *dst, size_t dstSize)
+{
+    size_t i = 0, o = 0;
+    
+    while (i < srcSize) {
+        
+        // Determine the length of the run starting at position i
+        size_t run = 1;
+        while (i + run < srcSize && run < 130 && src[i + run] == src[i]) run++;
+        
+        if (run >= 3) {
+            
+            if (o + 2 > dstSize) return 0;
+            dst[o++] = (uint8_t)(run + 125);
+            dst[o++] = src[i];
+            i += run;
+            continue;
+        }
+        
+        // Collect literals until the next run of three or more bytes
+        size_t start = i, count = 0;
+        while (i < srcSize && count < 128) {
+            if (i + 2 < srcSize && src[i] == src[i + 1] && src[i] == src[i + 2]) break;
+            i++; count++;
+        }
+        
+        if (o + 1 + count > dstSize) return 0;
+        dst[o++] = (uint8_t)(count - 1);
+        memcpy(dst + o, src + start, count);
+        o += count;
+    }
+    
+    return o;
+}
+
+size_t
+rleDecode(const uint8_t *src, size_t srcSize, uint8_t *dst, size_t dstSize)
+{
+    size_t i = 0, o = 0;
+    
+    while (i < srcSize) {
+        
+        uint8_t c = src[i++];
+        
+        if (c < 128) {
+            
+            size_t count = c + 1;
+            if (i + count > srcSize || o + count > dstSize) return 0;
+            memcpy(dst + o, src + i, count);
+            i += count;
+            o += count;
+            
+        } else {
+            
+            size_t count = c - 125;
+            if (i >= srcSize || o + count > dstSize) return 0;
+            memset(dst + o, src[i++], count);
+            o += count;
+        }
+    }
+    
+    return o;
+}
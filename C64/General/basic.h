@@ -131,20 +131,47 @@ inline bool is_uint5_t(uint5_t value) { return value < 32; }
 //! @functiongroup Handling buffers
 //
 
+//! @brief    Converts a word value between host and big endian byte order.
+inline uint16_t bigEndian16(uint16_t value) {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return value;
+#else
+    return __builtin_bswap16(value);
+#endif
+}
+
+//! @brief    Converts a double word value between host and big endian byte order.
+inline uint32_t bigEndian32(uint32_t value) {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return value;
+#else
+    return __builtin_bswap32(value);
+#endif
+}
+
+//! @brief    Converts a quad word value between host and big endian byte order.
+inline uint64_t bigEndian64(uint64_t value) {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return value;
+#else
+    return __builtin_bswap64(value);
+#endif
+}
+
 //! @brief    Writes a byte value into a buffer.
 inline void write8(uint8_t **ptr, uint8_t value) { *((*ptr)++) = value; }
 
 //! @brief    Writes a word value into a buffer in big endian format.
 inline void write16(uint8_t **ptr, uint16_t value) {
-    write8(ptr, (uint8_t)(value >> 8)); write8(ptr, (uint8_t)value); }
+    value = bigEndian16(value); memcpy(*ptr, &value, 2); *ptr += 2; }
 
 //! @brief    Writes a double byte value into a buffer in big endian format.
 inline void write32(uint8_t **ptr, uint32_t value) {
-    write16(ptr, (uint16_t)(value >> 16)); write16(ptr, (uint16_t)value); }
+    value = bigEndian32(value); memcpy(*ptr, &value, 4); *ptr += 4; }
 
 //! @brief    Writes a quad word value into a buffer in big endian format.
 inline void write64(uint8_t **ptr, uint64_t value) {
-    write32(ptr, (uint32_t)(value >> 32)); write32(ptr, (uint32_t)value); }
+    value = bigEndian64(value); memcpy(*ptr, &value, 8); *ptr += 8; }
 
 //! @brief    Writes a memory block into a buffer in big endian format.
 inline void writeBlock(uint8_t **ptr, uint8_t *values, size_t length) {
@@ -168,15 +195,15 @@ inline uint8_t read8(uint8_t **ptr) { return (uint8_t)(*((*ptr)++)); }
 
 //! @brief    Reads a word value from a buffer in big endian format.
 inline uint16_t read16(uint8_t **ptr) {
-    return ((uint16_t)read8(ptr) << 8) | (uint16_t)read8(ptr); }
+    uint16_t value; memcpy(&value, *ptr, 2); *ptr += 2; return bigEndian16(value); }
 
 //! @brief    Reads a double word value from a buffer in big endian format.
 inline uint32_t read32(uint8_t **ptr) {
-    return ((uint32_t)read16(ptr) << 16) | (uint32_t)read16(ptr); }
+    uint32_t value; memcpy(&value, *ptr, 4); *ptr += 4; return bigEndian32(value); }
 
 //! @brief    Reads a quad word value from a buffer in big endian format.
 inline uint64_t read64(uint8_t **ptr) {
-    return ((uint64_t)read32(ptr) << 32) | (uint64_t)read32(ptr); }
+    uint64_t value; memcpy(&value, *ptr, 8); *ptr += 8; return bigEndian64(value); }
 
 //! @brief    Reads a memory block from a buffer.
 inline void readBlock(uint8_t **ptr, uint8_t *values, size_t length) {
@@ -297,6 +324,13 @@ bool checkFileSize(const char *filename, long min, long max);
 */
 bool checkFileHeader(const char *filename, const uint8_t *header);
 
+/*! @brief    Reads the first bytes of a file.
+ *  @details  The file is opened unbuffered. Hence, only the requested bytes
+ *            are read from disk, no matter how large the file is.
+ *  @return   Number of bytes read (less than length if the file is shorter).
+ */
+size_t readFileHeader(const char *filename, uint8_t *buffer, size_t length);
+
 //
 //! @functiongroup Managing time
 //
@@ -335,6 +369,24 @@ void sleepMicrosec(unsigned usec);
  */
 int64_t sleepUntil(uint64_t kernelTargetTime, uint64_t kernelEarlyWakeup);
 
+
+//
+//! @functiongroup Compressing data
+//
+
+/*! @brief    Compresses a buffer with a simple run-length encoding
+ *  @details  Each block starts with a control byte c. If c < 128, c + 1
+ *            literal bytes follow. Otherwise, the next byte is repeated
+ *            c - 125 times.
+ *  @return   Number of bytes written, or 0 if dstSize has been exceeded.
+ */
+size_t rleEncode(const uint8_t *src, size_t srcSize, uint8_t *dst, size_t dstSize);
+
+/*! @brief    Decompresses a buffer that has been created by rleEncode
+ *  @return   Number of bytes written, or 0 if the data is corrupt.
+ */
+size_t rleDecode(const uint8_t *src, size_t srcSize, uint8_t *dst, size_t dstSize);
+
 #endif
 
 //
@@ -343,3 +395,9 @@ int64_t sleepUntil(uint64_t kernelTargetTime, uint64_t kernelEarlyWakeup);
 
 //! @brief    Computes a fingeprint based on the FNV-1a hash algorithm
 uint64_t fnv_1a(uint8_t *addr, size_t size);
+
+/*! @brief    Continues a FNV-1a hash computation
+ *  @details  Pass the result of a previous call to fnv_1a() to hash data
+ *            that is scattered over several memory locations.
+ */
+uint64_t fnv_1a(uint8_t *addr, size_t size, uint64_t hash);
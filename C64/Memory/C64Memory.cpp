@@ -20,14 +20,18 @@
 
 #include "C64.h"
 
-C64Memory::C64Memory()
+C64Memory::C64Memory() : search(ram, sizeof(ram))
 {	
 	setDescription("C64 memory");
     
 	debug (3, "  Creating main memory at address %p...\n", this);
 		
     memset(rom, 0, sizeof(rom));
+    memset(crtRom, 0, sizeof(crtRom));
     stack = &ram[0x0100];
+    watcher.setTarget(this);
+    memset(pageVersions, 0, sizeof(pageVersions));
+    memset(fingerprintVersions, 0xFF, sizeof(fingerprintVersions));
     
     // Register snapshot items
     SnapshotItem items[] = {
@@ -153,7 +157,16 @@ C64Memory::dump()
 			msg("Hard breakpoint at %04X\n", addr);
         if (c64->cpu.softBreakpoint(addr))
             msg("Soft breakpoint at %04X\n", addr);
+        if (c64->cpu.conditionalBreakpoint(addr))
+            msg("Conditional breakpoint at %04X: %s\n",
+                addr, c64->cpu.breakpointCondition(addr));
 	}
+    for (Watchpoint &wp : watchpoints) {
+        msg("Watchpoint %d: %04X - %04X (%s%s) %s [%lld hits]\n",
+            wp.id, wp.from, wp.to,
+            (wp.type & WATCH_READ) ? "R" : "", (wp.type & WATCH_WRITE) ? "W" : "",
+            wp.condition.getSource(), wp.hits);
+    }
 	msg("\n");
     
     /*
@@ -167,6 +180,74 @@ C64Memory::dump()
     */
 }
 
+void
+C64Memory::willSaveToBuffer(uint8_t **buffer)
+{
+    // Snapshots store the real lookup tables
+    removeWatchOverlay();
+}
+
+void
+C64Memory::didSaveToBuffer(uint8_t **buffer)
+{
+    applyWatchOverlay();
+}
+
+void
+C64Memory::didLoadFromBuffer(uint8_t **buffer)
+{
+    applyWatchOverlay();
+    markAllDirty();
+}
+
+uint64_t
+C64Memory::fingerprint()
+{
+    // Rehash all modified pages
+    for (unsigned page = 0; page < 256; page++) {
+        if (fingerprintVersions[page] != pageVersions[page]) {
+            pageFingerprints[page] = fnv_1a(ram + 256 * page, 256);
+            fingerprintVersions[page] = pageVersions[page];
+        }
+    }
+    uint64_t hash = fnv_1a((uint8_t *)pageFingerprints, sizeof(pageFingerprints));
+    hash = fnv_1a(colorRam, sizeof(colorRam), hash);
+    
+    // Hash the lookup tables without the watchpoint overlay
+    uint8_t tables[32];
+    for (unsigned i = 0; i < 16; i++) {
+        tables[i] = (uint8_t)getPeekSource(i << 12);
+        tables[16 + i] = (uint8_t)getPokeTarget(i << 12);
+    }
+    hash = fnv_1a(tables, sizeof(tables), hash);
+    
+    return combineFingerprints(hash, (uint64_t)ramInitPattern);
+}
+
+uint64_t
+C64Memory::pageSignature(uint8_t page)
+{
+    MemoryType source = getPeekSource(page << 8);
+    
+    switch (source) {
+            
+        case M_RAM:
+        case M_ROM:
+            return ((uint64_t)pageVersions[page] << 8) | source;
+            
+        default:
+            return 0;
+    }
+}
+
+void
+C64Memory::markDirty(uint16_t addr, size_t size)
+{
+    for (size_t page = addr >> 8; size && page <= (addr + size - 1) >> 8 && page < 256; page++) {
+        pageVersions[page]++;
+    }
+}
+
 void
 C64Memory::eraseWithPattern(RamInitPattern pattern)
 {
@@ -185,6 +266,7 @@ C64Memory::eraseWithPattern(RamInitPattern pattern)
     
     // Make the screen look nice on startup
     memset(&ram[0x400], 0x01, 40*25);
+    markAllDirty();
 }
 
 void 
@@ -208,6 +290,9 @@ C64Memory::updatePeekPokeLookupTables()
     // An attached cartridge may influence the settings. Let's give it a chance
     // to modify the tables...
     c64->expansionport.updatePeekPokeLookupTables();
+    
+    // Instrument watched pages
+    if (unlikely(watchedReads | watchedWrites)) applyWatchOverlay();
 }
 
 uint8_t
@@ -226,6 +311,9 @@ C64Memory::peek(uint16_t addr, MemoryType source)
         
         case M_CRTLO:
         case M_CRTHI:
+        if (crtRom[addr >> 12]) {
+            return crtRom[addr >> 12][addr & 0xFFF];
+        }
         return c64->expansionport.peek(addr);
         
         case M_PP:
@@ -240,6 +328,9 @@ C64Memory::peek(uint16_t addr, MemoryType source)
         case M_NONE:
         return c64->vic.getDataBusPhi1();
         
+        case M_WATCH:
+        return peekWatched(addr);
+        
         default:
         assert(0);
         return 0;
@@ -310,6 +401,8 @@ C64Memory::peekIO(uint16_t addr)
 	
         case 0xD: // CIA 2
             
+            // Port A reflects the IEC bus lines which the drives may change
+            if ((addr & 0x000F) == 0x00) c64->synchronizeDrives();
             return c64->cia2.peek(addr & 0x000F);
             
         case 0xE: // I/O space 1
@@ -341,6 +434,9 @@ C64Memory::spypeek(uint16_t addr, MemoryType source)
             
         case M_CRTLO:
         case M_CRTHI:
+            if (crtRom[addr >> 12]) {
+                return crtRom[addr >> 12][addr & 0xFFF];
+            }
             return c64->expansionport.spypeek(addr);
             
         case M_PP:
@@ -349,6 +445,9 @@ C64Memory::spypeek(uint16_t addr, MemoryType source)
         case M_NONE:
             return ram[addr];
             
+        case M_WATCH:
+            return spypeek(addr, watchedPeekSrc[addr >> 12]);
+            
         default:
             assert(0);
             return 0;
@@ -408,6 +507,10 @@ C64Memory::poke(uint16_t addr, uint8_t value, MemoryType target)
         case M_RAM:
         case M_ROM:
             ram[addr] = value;
+            markDirty(addr);
+            
+            // The REU can be triggered by writing into this cell
+            if (unlikely(addr == 0xFF00)) c64->expansionport.pokeFF00();
             return;
             
         case M_IO:
@@ -422,6 +525,7 @@ C64Memory::poke(uint16_t addr, uint8_t value, MemoryType target)
         case M_PP:
             if (likely(addr >= 0x02)) {
                 ram[addr] = value;
+                markDirty(addr);
             } else if (addr == 0x00) {
                 c64->processorPort.writeDirection(value);
             } else {
@@ -432,6 +536,10 @@ C64Memory::poke(uint16_t addr, uint8_t value, MemoryType target)
         case M_NONE:
             return;
             
+        case M_WATCH:
+            pokeWatched(addr, value);
+            return;
+            
         default:
             assert(0);
             return;
@@ -453,6 +561,7 @@ C64Memory::pokeZP(uint8_t addr, uint8_t value)
 {
     if (likely(addr >= 0x02)) {
         ram[addr] = value;
+        pageVersions[0]++;
     } else if (addr == 0x00) {
         c64->processorPort.writeDirection(value);
     } else {
@@ -524,7 +633,7 @@ C64Memory::pokeIO(uint16_t addr, uint8_t value)
 uint16_t
 C64Memory::nmiVector() {
     
-    if (peekSrc[0xF] != M_ROM || kernalRomIsLoaded()) {
+    if (getPeekSource(0xF000) != M_ROM || kernalRomIsLoaded()) {
         return LO_HI(peek(0xFFFA), peek(0xFFFB));
     } else {
         return 0xFE43;
@@ -534,7 +643,7 @@ C64Memory::nmiVector() {
 uint16_t
 C64Memory::irqVector() {
     
-    if (peekSrc[0xF] != M_ROM || kernalRomIsLoaded()) {
+    if (getPeekSource(0xF000) != M_ROM || kernalRomIsLoaded()) {
         return LO_HI(peek(0xFFFE), peek(0xFFFF));
     } else {
         return 0xFF48;
@@ -544,11 +653,260 @@ C64Memory::irqVector() {
 uint16_t
 C64Memory::resetVector() {
     
-    if (peekSrc[0xF] != M_ROM || kernalRomIsLoaded()) {
-        debug("Grabbing reset vector from source %d\n", peekSrc[0xF]);
+    if (getPeekSource(0xF000) != M_ROM || kernalRomIsLoaded()) {
+        debug("Grabbing reset vector from source %d\n", getPeekSource(0xF000));
         return LO_HI(peek(0xFFFC), peek(0xFFFD));
     } else {
         return 0xFCE2;
     }
 }
 
+
+int
+C64Memory::addWatchpoint(uint16_t from, uint16_t to, WatchType type,
+                         const char *condition, bool halt)
+{
+    Watchpoint wp;
+    
+    if (!wp.condition.compile(condition)) {
+        warn("Syntax error in watchpoint condition '%s'\n", condition);
+        return -1;
+    }
+    
+    wp.id = nextWatchpointId++;
+    wp.from = MIN(from, to);
+    wp.to = MAX(from, to);
+    wp.type = type;
+    wp.halt = halt;
+    wp.hits = 0;
+    wp.lastAddr = 0;
+    wp.lastValue = 0;
+    wp.lastPC = 0;
+    wp.lastCycle = 0;
+    
+    suspend();
+    watchpoints.push_back(wp);
+    updateWatchedPages();
+    resume();
+    
+    return wp.id;
+}
+
+bool
+C64Memory::deleteWatchpoint(int id)
+{
+    for (auto it = watchpoints.begin(); it != watchpoints.end(); it++) {
+        if (it->id == id) {
+            suspend();
+            watchpoints.erase(it);
+            updateWatchedPages();
+            resume();
+            return true;
+        }
+    }
+    return false;
+}
+
+void
+C64Memory::deleteAllWatchpoints()
+{
+    suspend();
+    watchpoints.clear();
+    updateWatchedPages();
+    resume();
+}
+
+const Watchpoint *
+C64Memory::getWatchpoint(int id)
+{
+    for (Watchpoint &wp : watchpoints) {
+        if (wp.id == id) return &wp;
+    }
+    return NULL;
+}
+
+uint64_t
+C64Memory::watchpointHits(int id)
+{
+    const Watchpoint *wp = getWatchpoint(id);
+    return wp ? wp->hits : 0;
+}
+
+void
+C64Memory::clearWatchpointHits()
+{
+    for (Watchpoint &wp : watchpoints) {
+        wp.hits = 0;
+    }
+}
+
+void
+C64Memory::updateWatchedPages()
+{
+    removeWatchOverlay();
+    
+    watchedReads = watchedWrites = 0;
+    
+    for (Watchpoint &wp : watchpoints) {
+        
+        // Watching an I/O register means watching all of its mirrors. They
+        // are located in the same page, so there is nothing special to do.
+        uint16_t pages = 0;
+        for (unsigned page = wp.from >> 12; page <= (unsigned)(wp.to >> 12); page++) {
+            pages |= 1 << page;
+        }
+        if (wp.type & WATCH_READ) watchedReads |= pages;
+        if (wp.type & WATCH_WRITE) watchedWrites |= pages;
+    }
+    
+    applyWatchOverlay();
+}
+
+void
+C64Memory::applyWatchOverlay()
+{
+    for (unsigned page = 0; page < 16; page++) {
+        
+        if ((watchedReads & (1 << page)) && peekSrc[page] != M_WATCH) {
+            watchedPeekSrc[page] = peekSrc[page];
+            peekSrc[page] = M_WATCH;
+        }
+        if ((watchedWrites & (1 << page)) && pokeTarget[page] != M_WATCH) {
+            watchedPokeTarget[page] = pokeTarget[page];
+            pokeTarget[page] = M_WATCH;
+        }
+    }
+    
+    // Zero page and stack accesses bypass the lookup tables
+    bool zeroPage = ((watchedReads | watchedWrites) & 1) != 0;
+    c64->cpu.connectMemory(zeroPage ? (Memory *)&watcher : (Memory *)this);
+}
+
+void
+C64Memory::removeWatchOverlay()
+{
+    for (unsigned page = 0; page < 16; page++) {
+        
+        if (peekSrc[page] == M_WATCH) peekSrc[page] = watchedPeekSrc[page];
+        if (pokeTarget[page] == M_WATCH) pokeTarget[page] = watchedPokeTarget[page];
+    }
+    
+    c64->cpu.connectMemory(this);
+}
+
+uint16_t
+C64Memory::canonicalAddr(uint16_t addr, MemoryType type)
+{
+    if (type != M_IO) return addr;
+    
+    switch ((addr >> 8) & 0xF) {
+            
+        case 0x0: case 0x1: case 0x2: case 0x3: // VIC
+            return 0xD000 | (addr & 0x3F);
+            
+        case 0x4: case 0x5: case 0x6: case 0x7: // SID
+            return 0xD400 | (addr & 0x1F);
+            
+        case 0xC: // CIA 1
+            return 0xDC00 | (addr & 0x0F);
+            
+        case 0xD: // CIA 2
+            return 0xDD00 | (addr & 0x0F);
+            
+        default:
+            return addr;
+    }
+}
+
+void
+C64Memory::checkWatchpoints(uint16_t addr, uint8_t value, WatchType type, MemoryType real)
+{
+    uint16_t reg = canonicalAddr(addr, real);
+    
+    for (Watchpoint &wp : watchpoints) {
+        
+        if (!(wp.type & type)) continue;
+        if ((reg < wp.from || reg > wp.to) && (addr < wp.from || addr > wp.to)) continue;
+        
+        if (!wp.condition.isEmpty() &&
+            !wp.condition.eval(c64->cpu.conditionContext(addr, value), this)) continue;
+        
+        wp.hits++;
+        wp.lastAddr = addr;
+        wp.lastValue = value;
+        wp.lastPC = c64->cpu.getPC();
+        wp.lastCycle = c64->cpu.cycle;
+        
+        if (wp.halt) {
+            debug(1, "Watchpoint %d reached (%04X)\n", wp.id, addr);
+            c64->cpu.setErrorState(CPU_WATCHPOINT_REACHED);
+        }
+    }
+}
+
+uint8_t
+C64Memory::peekWatched(uint16_t addr)
+{
+    MemoryType real = watchedPeekSrc[addr >> 12];
+    uint8_t value = peek(addr, real);
+    
+    checkWatchpoints(addr, value, WATCH_READ, real);
+    return value;
+}
+
+void
+C64Memory::pokeWatched(uint16_t addr, uint8_t value)
+{
+    MemoryType real = watchedPokeTarget[addr >> 12];
+    poke(addr, value, real);
+    
+    checkWatchpoints(addr, value, WATCH_WRITE, real);
+}
+
+uint8_t
+WatchedMemory::peek(uint16_t addr)
+{
+    return target->peek(addr);
+}
+
+uint8_t
+WatchedMemory::peekZP(uint8_t addr)
+{
+    return target->peek(addr);
+}
+
+uint8_t
+WatchedMemory::peekStack(uint8_t sp)
+{
+    return target->peek(0x100 | sp);
+}
+
+uint8_t
+WatchedMemory::spypeek(uint16_t addr)
+{
+    return target->spypeek(addr);
+}
+
+uint64_t
+WatchedMemory::pageSignature(uint8_t page)
+{
+    return target->pageSignature(page);
+}
+
+void
+WatchedMemory::poke(uint16_t addr, uint8_t value)
+{
+    target->poke(addr, value);
+}
+
+void
+WatchedMemory::pokeZP(uint8_t addr, uint8_t value)
+{
+    target->poke(addr, value);
+}
+
+void
+WatchedMemory::pokeStack(uint8_t sp, uint8_t value)
+{
+    target->poke(0x100 | sp, value);
+}
@@ -22,6 +22,70 @@
 #define _C64MEMORY_INC
 
 #include "Memory.h"
+#include "MemorySearch.h"
+#include "Condition.h"
+#include <vector>
+
+class C64Memory;
+
+//! @brief    A watched range of memory cells
+typedef struct {
+    
+    //! @brief    Identifier returned by C64Memory::addWatchpoint()
+    int id;
+    
+    //! @brief    First and last watched address
+    uint16_t from;
+    uint16_t to;
+    
+    //! @brief    Kind of access the watchpoint reacts to
+    WatchType type;
+    
+    //! @brief    Indicates if the CPU is halted when the watchpoint triggers
+    bool halt;
+    
+    //! @brief    Additional predicate (empty = always true)
+    Condition condition;
+    
+    //! @brief    Number of times the watchpoint has triggered
+    uint64_t hits;
+    
+    //! @brief    Details about the most recent hit
+    uint16_t lastAddr;
+    uint8_t lastValue;
+    uint16_t lastPC;
+    uint64_t lastCycle;
+    
+} Watchpoint;
+
+/*! @brief    Routes zero page and stack accesses through the lookup tables
+ *  @details  The CPU accesses the zero page and the stack via dedicated
+ *            functions bypassing the peek and poke lookup tables. While page 0
+ *            is watched, the CPU is connected to this object instead of the
+ *            C64 memory which maps these accesses to ordinary peeks and pokes.
+ */
+class WatchedMemory : public Memory {
+    
+    C64Memory *target = NULL;
+    
+    public:
+    
+    void setTarget(C64Memory *mem) { target = mem; }
+    
+    private:
+    
+    uint8_t peek(uint16_t addr);
+    uint8_t peekZP(uint8_t addr);
+    uint8_t peekStack(uint8_t sp);
+    
+    public:
+    
+    uint8_t spypeek(uint16_t addr);
+    void poke(uint16_t addr, uint8_t value);
+    void pokeZP(uint8_t addr, uint8_t value);
+    void pokeStack(uint8_t sp, uint8_t value);
+    uint64_t pageSignature(uint8_t page);
+};
 
 /*! @brief    This class represents RAM and ROM of the virtual C64
  *  @details  Due to the limited address space, RAM, ROM, and I/O memory are
@@ -108,6 +172,52 @@ public:
     //! @brief    Poke target lookup table
     MemoryType pokeTarget[16];
     
+    /*! @brief    Direct pointers into cartridge ROM
+     *  @details  If a memory page is mapped to M_CRTLO or M_CRTHI and the
+     *            corresponding pointer is not NULL, the page is read directly
+     *            from this location instead of asking the expansion port. The
+     *            pointers are maintained by ExpansionPort::updateRomPages().
+     */
+    uint8_t *crtRom[16];
+    
+    //! @brief    Searches RAM for values, patterns, and changes
+    MemorySearch search;
+    
+private:
+    
+    //! @brief    All watchpoints
+    std::vector<Watchpoint> watchpoints;
+    
+    //! @brief    Identifier of the next watchpoint
+    int nextWatchpointId = 1;
+    
+    //! @brief    Pages containing watched cells (one bit per page)
+    uint16_t watchedReads = 0;
+    uint16_t watchedWrites = 0;
+    
+    /*! @brief    Real peek sources and poke targets of watched pages
+     *  @details  In the lookup tables, watched pages are mapped to M_WATCH.
+     */
+    MemoryType watchedPeekSrc[16];
+    MemoryType watchedPokeTarget[16];
+    
+    //! @brief    Forwards zero page and stack accesses while page 0 is watched
+    WatchedMemory watcher;
+    
+    /*! @brief    Write counters of all RAM pages
+     *  @details  A counter is incremented whenever the page is written. All
+     *            code writing into RAM directly (bypassing poke) has to call
+     *            markDirty() to keep fingerprints and disassembler caches
+     *            up to date.
+     */
+    uint32_t pageVersions[256];
+    
+    //! @brief    Fingerprints of all RAM pages
+    uint64_t pageFingerprints[256];
+    
+    //! @brief    Page versions the fingerprints have been computed for
+    uint32_t fingerprintVersions[256];
+    
 public:
     
 	//! @brief    Constructor
@@ -124,24 +234,45 @@ public:
 
 	//! @brief    Method from VirtualComponent
 	void dump();
+    
+    //! @brief    Methods from VirtualComponent
+    void willSaveToBuffer(uint8_t **buffer);
+    void didSaveToBuffer(uint8_t **buffer);
+    void didLoadFromBuffer(uint8_t **buffer);
+    
+    /*! @brief    Method from VirtualComponent
+     *  @details  Only RAM pages that have been written since the last call
+     *            are rehashed. ROMs are not included (see the ROM
+     *            fingerprint functions).
+     */
+    uint64_t fingerprint();
+    
+    //! @brief    Marks the RAM page containing addr as modified
+    void markDirty(uint16_t addr) { pageVersions[addr >> 8]++; }
+    
+    //! @brief    Marks all RAM pages overlapping the specified range as modified
+    void markDirty(uint16_t addr, size_t size);
+    
+    //! @brief    Marks all pages as modified (also used when a ROM changes)
+    void markAllDirty() { for (unsigned i = 0; i < 256; i++) pageVersions[i]++; }
 
 	//! @brief    Returns true, iff the Basic ROM has been loaded
 	bool basicRomIsLoaded() { return rom[0xA000] != 0x00; }
     
     //! @brief    Deletes the Basic ROM from memory
-    void deleteBasicRom() { memset(rom + 0xA000, 0, 0x2000); }
+    void deleteBasicRom() { memset(rom + 0xA000, 0, 0x2000); markAllDirty(); }
     
     //! @brief    Returns true, iff the Character ROM has been loaded
     bool characterRomIsLoaded() { return rom[0xD000] != 0x00; }
 
     //! @brief    Deletes the Character ROM from memory
-    void deleteCharacterRom() { memset(rom + 0xD000, 0, 0x1000); }
+    void deleteCharacterRom() { memset(rom + 0xD000, 0, 0x1000); markAllDirty(); }
 
     //! @brief    Returns true, iff the Kernal ROM has been loaded
 	bool kernalRomIsLoaded() { return rom[0xE000] != 0x00; }
 
     //! @brief    Deletes the Kernal ROM from memory
-    void deleteKernalRom() { memset(rom + 0xE000, 0, 0x2000); }
+    void deleteKernalRom() { memset(rom + 0xE000, 0, 0x2000); markAllDirty(); }
 
     /*! @brief    Computes a 64-bit fingerprint for the Basic ROM.
      *  @return   fingerprint or 0, if no Basic ROM is installed.
@@ -179,10 +310,14 @@ public:
     void updatePeekPokeLookupTables();
 
     //! @brief    Returns the current peek source of the specified memory address
-    MemoryType getPeekSource(uint16_t addr) { return peekSrc[addr >> 12]; }
-    
+    MemoryType getPeekSource(uint16_t addr) {
+        MemoryType src = peekSrc[addr >> 12];
+        return src == M_WATCH ? watchedPeekSrc[addr >> 12] : src; }
+
     //! @brief    Returns the current poke target of the specified memory address
-    MemoryType getPokeTarget(uint16_t addr) { return pokeTarget[addr >> 12]; }
+    MemoryType getPokeTarget(uint16_t addr) {
+        MemoryType target = pokeTarget[addr >> 12];
+        return target == M_WATCH ? watchedPokeTarget[addr >> 12] : target; }
 
     // Reading from memory
     uint8_t peek(uint16_t addr, MemoryType source);
@@ -201,8 +336,73 @@ public:
     void poke(uint16_t addr, uint8_t value, bool gameLine, bool exromLine);
     void poke(uint16_t addr, uint8_t value) { poke(addr, value, pokeTarget[addr >> 12]); }
     void pokeZP(uint8_t addr, uint8_t value);
+    void pokeStack(uint8_t sp, uint8_t value) { stack[sp] = value; pageVersions[1]++; }
     void pokeIO(uint16_t addr, uint8_t value);
     
+    //! @brief    Method from Memory (RAM and ROM pages can be cached)
+    uint64_t pageSignature(uint8_t page);
+    
+    
+    //
+    //! @functiongroup Handling watchpoints
+    //
+    
+    /*! @brief    Watches a range of memory cells.
+     *  @details  Watchpoints on I/O registers also trigger on the mirrored
+     *            addresses. E.g., a watchpoint on $D012 triggers on $D052, too.
+     *            Only the pages containing watched cells are instrumented.
+     *            Without watchpoints, memory accesses run at full speed.
+     *            The emulator is suspended while the tables are updated.
+     *  @param    condition Optional predicate (see Condition), may be NULL.
+     *  @param    halt      If false, the watchpoint only counts its hits.
+     *  @return   The watchpoint id or -1 if the condition is malformed.
+     */
+    int addWatchpoint(uint16_t from, uint16_t to, WatchType type,
+                      const char *condition = NULL, bool halt = true);
+    
+    //! @brief    Deletes a watchpoint. Returns false if the id is unknown.
+    bool deleteWatchpoint(int id);
+    
+    //! @brief    Deletes all watchpoints.
+    void deleteAllWatchpoints();
+    
+    //! @brief    Returns the number of watchpoints.
+    unsigned numberOfWatchpoints() { return (unsigned)watchpoints.size(); }
+    
+    //! @brief    Returns a watchpoint by id (NULL if the id is unknown).
+    const Watchpoint *getWatchpoint(int id);
+    
+    //! @brief    Returns the number of hits of a watchpoint.
+    uint64_t watchpointHits(int id);
+    
+    //! @brief    Resets the hit counters of all watchpoints.
+    void clearWatchpointHits();
+    
+private:
+    
+    //! @brief    Recomputes the watched pages and updates the lookup tables.
+    void updateWatchedPages();
+    
+    //! @brief    Maps all watched pages to M_WATCH.
+    void applyWatchOverlay();
+    
+    //! @brief    Restores the real sources and targets of all watched pages.
+    void removeWatchOverlay();
+    
+    //! @brief    Maps a mirrored I/O address to the register address.
+    uint16_t canonicalAddr(uint16_t addr, MemoryType type);
+    
+    //! @brief    Checks all watchpoints against a memory access.
+    void checkWatchpoints(uint16_t addr, uint8_t value, WatchType type, MemoryType real);
+    
+    //! @brief    Performs a read access on a watched page.
+    uint8_t peekWatched(uint16_t addr);
+    
+    //! @brief    Performs a write access on a watched page.
+    void pokeWatched(uint16_t addr, uint8_t value);
+    
+public:
+    
     //! @brief    Reads the NMI vector from memory.
     uint16_t nmiVector();
     
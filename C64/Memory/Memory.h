@@ -70,6 +70,15 @@ public:
 
     //! @brief    Pokes a byte onto the stack.
     virtual void pokeStack(uint8_t sp, uint8_t value) { stack[sp] = value; }
+    
+    /*! @brief    Returns a value identifying the visible contents of a page
+     *  @details  The value changes whenever spypeek() may return something
+     *            different for an address inside the page, e.g., after a
+     *            write or a bank switch. It is used to validate cached data
+     *            such as disassembled code. 0 indicates that the contents
+     *            can change at any time (e.g., I/O space).
+     */
+    virtual uint64_t pageSignature(uint8_t page) { return 0; }
 };
 
 #endif
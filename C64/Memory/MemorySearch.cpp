@@ -0,0 +1,199 @@
+/*!
+ * @header      MemorySearch.cpp
+ * @author      Dirk W. Hoffmann, www.dirkwhoffmann.de
+ * @copyright   Dirk W. Hoffmann. All rights reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "MemorySearch.h"
+
+/*! @brief    Packs 64 bytes (each 0 or 1) into a 64 bit mask
+ *  @note     Expects a little endian architecture.
+ */
+static inline uint64_t
+packBlock(const uint8_t *bytes)
+{
+    uint64_t result = 0;
+    
+    for (unsigned i = 0; i < 8; i++) {
+        uint64_t word;
+        memcpy(&word, bytes + 8 * i, 8);
+        result |= ((word * 0x0102040810204080ULL) >> 56) << (8 * i);
+    }
+    return result;
+}
+
+/*! @brief    Compares a block of 64 bytes
+ *  @details  Reads up to 64 bytes starting at cur and old, applies the
+ *            predicate, and returns the results as a bit mask. Bytes beyond
+ *            length are treated as mismatches.
+ */
+template <class Pred> static inline uint64_t
+matchBlock(const uint8_t *cur, const uint8_t *old, size_t length, Pred pred)
+{
+    uint8_t match[64];
+    
+    if (length >= 64) {
+        for (unsigned i = 0; i < 64; i++) match[i] = pred(cur[i], old[i]);
+    } else {
+        for (unsigned i = 0; i < 64; i++) match[i] = i < length && pred(cur[i], old[i]);
+    }
+    return packBlock(match);
+}
+
+MemorySearch::MemorySearch(const uint8_t *mem, size_t size)
+{
+    assert(size % 64 == 0);
+    
+    setDescription("MemorySearch");
+    this->mem = mem;
+    this->size = size;
+    candidates.resize(size / 64);
+    restart();
+}
+
+void
+MemorySearch::restart()
+{
+    std::fill(candidates.begin(), candidates.end(), UINT64_MAX);
+}
+
+void
+MemorySearch::takeReference()
+{
+    reference.assign(mem, mem + size);
+}
+
+template <class Pred> static size_t
+refineWith(std::vector<uint64_t> &candidates, const uint8_t *mem,
+           const uint8_t *ref, size_t size, size_t offset, Pred pred)
+{
+    size_t count = 0;
+    
+    for (size_t i = 0; i < candidates.size(); i++) {
+        
+        if (candidates[i] == 0) continue;
+        
+        size_t addr = 64 * i + offset;
+        size_t length = addr < size ? size - addr : 0;
+        candidates[i] &= matchBlock(mem + addr, ref + addr, length, pred);
+        count += __builtin_popcountll(candidates[i]);
+    }
+    return count;
+}
+
+size_t
+MemorySearch::refine(SearchCondition cond, uint8_t operand, uint8_t mask)
+{
+    const uint8_t *ref = reference.empty() ? mem : reference.data();
+    uint8_t v = operand, m = mask;
+    
+    switch (cond) {
+            
+        case SEARCH_EQUAL:
+            return refineWith(candidates, mem, ref, size, 0,
+                              [v, m](uint8_t c, uint8_t) { return (c & m) == (v & m); });
+        case SEARCH_NOT_EQUAL:
+            return refineWith(candidates, mem, ref, size, 0,
+                              [v, m](uint8_t c, uint8_t) { return (c & m) != (v & m); });
+        case SEARCH_GREATER:
+            return refineWith(candidates, mem, ref, size, 0,
+                              [v, m](uint8_t c, uint8_t) { return (c & m) > v; });
+        case SEARCH_LESS:
+            return refineWith(candidates, mem, ref, size, 0,
+                              [v, m](uint8_t c, uint8_t) { return (c & m) < v; });
+        default:
+            break;
+    }
+    
+    if (reference.empty()) {
+        warn("No reference copy. Call takeReference() first.\n");
+        return count();
+    }
+    
+    switch (cond) {
+            
+        case SEARCH_CHANGED:
+            return refineWith(candidates, mem, ref, size, 0,
+                              [](uint8_t c, uint8_t o) { return c != o; });
+        case SEARCH_UNCHANGED:
+            return refineWith(candidates, mem, ref, size, 0,
+                              [](uint8_t c, uint8_t o) { return c == o; });
+        case SEARCH_INCREASED:
+            return refineWith(candidates, mem, ref, size, 0,
+                              [](uint8_t c, uint8_t o) { return c > o; });
+        case SEARCH_DECREASED:
+            return refineWith(candidates, mem, ref, size, 0,
+                              [](uint8_t c, uint8_t o) { return c < o; });
+        case SEARCH_CHANGED_BY:
+            return refineWith(candidates, mem, ref, size, 0,
+                              [v](uint8_t c, uint8_t o) { return c == (uint8_t)(o + v); });
+        default:
+            warn("Unknown search condition %d\n", cond);
+            return count();
+    }
+}
+
+size_t
+MemorySearch::findPattern(const uint8_t *pattern, const uint8_t *mask, size_t length)
+{
+    assert(pattern != NULL);
+    
+    size_t result = count();
+    
+    // Check one pattern byte after the other (at an increasing offset)
+    for (size_t k = 0; k < length && result; k++) {
+        
+        uint8_t v = pattern[k], m = mask ? mask[k] : 0xFF;
+        result = refineWith(candidates, mem, mem, size, k,
+                            [v, m](uint8_t c, uint8_t) { return (c & m) == (v & m); });
+    }
+    return result;
+}
+
+size_t
+MemorySearch::count()
+{
+    size_t result = 0;
+    
+    for (size_t i = 0; i < candidates.size(); i++) {
+        result += __builtin_popcountll(candidates[i]);
+    }
+    return result;
+}
+
+long
+MemorySearch::next(size_t addr)
+{
+    for (size_t i = addr / 64; i < candidates.size(); i++) {
+        
+        uint64_t word = candidates[i];
+        if (i == addr / 64) word &= UINT64_MAX << (addr % 64);
+        if (word) return (long)(64 * i + __builtin_ctzll(word));
+    }
+    return -1;
+}
+
+size_t
+MemorySearch::getResults(uint16_t *buffer, size_t max)
+{
+    size_t n = 0;
+    
+    for (long addr = next(0); addr >= 0 && n < max; addr = next(addr + 1)) {
+        buffer[n++] = (uint16_t)addr;
+    }
+    return n;
+}
@@ -0,0 +1,117 @@
+/*!
+ * @header      MemorySearch.h
+ * @author      Dirk W. Hoffmann, www.dirkwhoffmann.de
+ * @copyright   Dirk W. Hoffmann. All rights reserved.
+ */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _MEMORYSEARCH_INC
+#define _MEMORYSEARCH_INC
+
+#include "VC64Object.h"
+#include "Memory_types.h"
+#include <vector>
+
+/*! @brief    Searches a RAM array for values, patterns, and changes
+ *  @details  The search keeps a set of candidate addresses (one bit per
+ *            address) which is narrowed down by each call to refine() or
+ *            findPattern(). Delta conditions compare the RAM contents with a
+ *            reference copy taken by takeReference(). A typical cheat search
+ *            takes a reference, lets the emulator run for a while, refines
+ *            with SEARCH_DECREASED, takes a new reference, and so on.
+ *            RAM is compared in blocks of 64 bytes. Each block is reduced to a
+ *            64 bit match mask which is ANDed into the candidate set. The
+ *            inner loops are free of branches so that the compiler can
+ *            vectorize them. Blocks without candidates are skipped, which
+ *            makes refining a small candidate set very cheap.
+ *            The RAM is accessed directly, i.e., without any side effects.
+ *            Suspend the emulator to get consistent results.
+ */
+class MemorySearch : public VC64Object {
+    
+    private:
+    
+    //! @brief    Searched memory
+    const uint8_t *mem = NULL;
+    
+    //! @brief    Size of the searched memory in bytes (multiple of 64)
+    size_t size = 0;
+    
+    //! @brief    Candidate addresses (one bit per address)
+    std::vector<uint64_t> candidates;
+    
+    //! @brief    Reference copy for delta conditions
+    std::vector<uint8_t> reference;
+    
+    public:
+    
+    //! @brief    Constructor
+    MemorySearch(const uint8_t *mem, size_t size);
+    
+    
+    //
+    //! @functiongroup Searching
+    //
+    
+    //! @brief    Makes all addresses candidates again
+    void restart();
+    
+    //! @brief    Copies the current RAM contents into the reference copy
+    void takeReference();
+    
+    //! @brief    Returns true if takeReference() has been called
+    bool hasReference() { return !reference.empty(); }
+    
+    /*! @brief    Removes all candidates not satisfying a condition
+     *  @param    operand Compare value or difference for SEARCH_CHANGED_BY
+     *  @param    mask    Applied to the value for non-delta conditions
+     *  @return   Number of remaining candidates
+     */
+    size_t refine(SearchCondition cond, uint8_t operand = 0, uint8_t mask = 0xFF);
+    
+    /*! @brief    Removes all candidates that are not the start of a pattern
+     *  @param    mask May be NULL to compare all bits. Otherwise, only the
+     *            bits set in mask[i] are compared for pattern[i].
+     *  @return   Number of remaining candidates
+     */
+    size_t findPattern(const uint8_t *pattern, const uint8_t *mask, size_t length);
+    
+    
+    //
+    //! @functiongroup Querying results
+    //
+    
+    //! @brief    Returns the number of candidates
+    size_t count();
+    
+    //! @brief    Returns true if addr is a candidate
+    bool contains(uint16_t addr) {
+        return addr < size && (candidates[addr / 64] >> (addr % 64)) & 1; }
+    
+    //! @brief    Returns the first candidate >= addr or -1 if there is none
+    long next(size_t addr);
+    
+    //! @brief    Writes up to max candidates into buffer. Returns the number written.
+    size_t getResults(uint16_t *buffer, size_t max);
+    
+    /*! @brief    Returns the candidate set
+     *  @details  Bit i of word j represents address 64 * j + i.
+     */
+    const uint64_t *getBitset() { return candidates.data(); }
+    size_t getBitsetSize() { return candidates.size(); }
+};
+
+#endif
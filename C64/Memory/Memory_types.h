@@ -35,9 +35,19 @@ typedef enum {
     M_CRTLO,
     M_CRTHI,
     M_PP,
-    M_NONE
+    M_NONE,
+    M_WATCH
 } MemoryType;
 
+/*! @brief    Watchpoint type
+ *  @details  Specifies the kind of memory access a watchpoint reacts to.
+ */
+typedef enum {
+    WATCH_READ   = 0x01,
+    WATCH_WRITE  = 0x02,
+    WATCH_ACCESS = 0x03
+} WatchType;
+
 //! @brief    RAM init pattern type
 typedef enum {
     INIT_PATTERN_C64 = 0,
@@ -48,4 +58,27 @@ inline bool isRamInitPattern(RamInitPattern pattern) {
     return (pattern == INIT_PATTERN_C64) || (pattern == INIT_PATTERN_C64C);
 }
 
+/*! @brief    Kernal loop waiting for keyboard input
+ *  @details  Addresses of the first and the last instruction of the loop.
+ */
+#define KERNAL_INPUT_LOOP_START 0xE5CD
+#define KERNAL_INPUT_LOOP_END   0xE5D4
+
+//! @brief    Conditions for refining a memory search
+typedef enum {
+    SEARCH_EQUAL = 0,  //!< (value & mask) == (operand & mask)
+    SEARCH_NOT_EQUAL,  //!< (value & mask) != (operand & mask)
+    SEARCH_GREATER,    //!< (value & mask) > operand
+    SEARCH_LESS,       //!< (value & mask) < operand
+    SEARCH_CHANGED,    //!< value differs from the reference copy
+    SEARCH_UNCHANGED,  //!< value equals the reference copy
+    SEARCH_INCREASED,  //!< value is greater than in the reference copy
+    SEARCH_DECREASED,  //!< value is less than in the reference copy
+    SEARCH_CHANGED_BY  //!< value equals the reference copy plus operand (mod 256)
+} SearchCondition;
+
+inline bool isSearchCondition(SearchCondition c) {
+    return c >= SEARCH_EQUAL && c <= SEARCH_CHANGED_BY;
+}
+
 #endif
@@ -268,6 +268,19 @@ ReSID::getInfo()
     return info;
 }
 
+bool
+ReSID::isSilent()
+{
+    reSID::SID::State state = sid->read_state();
+    
+    if ((state.sid_register[0x18] & 0x0F) == 0) return true;
+    
+    return
+    state.envelope_counter[0] == 0 &&
+    state.envelope_counter[1] == 0 &&
+    state.envelope_counter[2] == 0;
+}
+
 VoiceInfo
 ReSID::getVoiceInfo(unsigned voice)
 {
@@ -84,6 +84,9 @@ public:
     
     //! @brief    Gathers all debug information for a specific voice
     VoiceInfo getVoiceInfo(unsigned voice);
+    
+    //! @brief    Returns true if the master volume or all envelopes are zero
+    bool isSilent();
 
 	//! Special peek function for the I/O memory range.
 	uint8_t peek(uint16_t addr);
@@ -151,6 +151,19 @@ SIDBridge::getVoiceInfo(unsigned voice)
     return useReSID ? resid.getVoiceInfo(voice) : fastsid.getVoiceInfo(voice);
 }
 
+bool
+SIDBridge::isSilent()
+{
+    if (useReSID) return resid.isSilent();
+    
+    // FastSID doesn't expose its envelopes. Check the gate bits instead.
+    if (fastsid.getInfo().volume == 0) return true;
+    for (unsigned i = 0; i < 3; i++) {
+        if (fastsid.getVoiceInfo(i).gateBit) return false;
+    }
+    return true;
+}
+
 uint8_t 
 SIDBridge::peek(uint16_t addr)
 {
@@ -204,7 +217,12 @@ SIDBridge::executeUntil(uint64_t targetCycle)
         missingCycles = PAL_CYCLES_PER_SECOND;
     }
     
+    // Let the profiler know that SID is executed
+    uint8_t phase = c64->profilePhase;
+    c64->profilePhase = PROF_SID;
     execute(missingCycles);
+    c64->profilePhase = phase;
+    
     cycles = targetCycle;
 }
 
@@ -424,6 +442,13 @@ SIDBridge::writeData(short *data, size_t count)
         ringBuffer[writePtr] = float(data[i]) * scale;
         advanceWritePtr();
     }
+    
+    // Pass the samples to the frame pipeline
+    if (audioTap) {
+        for (unsigned i = 0; i < count; i++) {
+            audioTap->push_back(float(data[i]) * scale);
+        }
+    }
 }
 
 void
@@ -25,6 +25,7 @@
 #include "FastSID.h"
 #include "ReSID.h"
 #include "SID_types.h"
+#include <vector>
 
 class SIDBridge : public VirtualComponent {
 
@@ -47,6 +48,9 @@ private:
     //! @brief    Time stamp of the last write pointer alignment
     uint64_t lastAlignment = 0;
     
+    //! @brief    If set, all samples written to the ringbuffer are appended here
+    std::vector<float> *audioTap = NULL;
+    
 public:
     
     //! @brief    Number of buffer underflows since power up
@@ -132,6 +136,12 @@ public:
     //! @brief    Gathers all debug information for a specific voice
     VoiceInfo getVoiceInfo(unsigned voice);
     
+    /*! @brief    Returns true if SID doesn't produce any sound
+     *  @details  Digis played by modulating the master volume are not
+     *            detected if all voices are silent.
+     */
+    bool isSilent();
+    
     
     //
 	// Configuring the device
@@ -240,6 +250,9 @@ public:
      */
     void writeData(short *data, size_t count);
     
+    //! @brief    Sets or clears the audio tap
+    void setAudioTap(std::vector<float> *target) { audioTap = target; }
+    
     /*! @brief   Handles a buffer underflow condition.
      *  @details A buffer underflow occurs when the computer's audio device
      *           needs sound samples than SID hasn't produced, yet.
@@ -284,6 +297,9 @@ public:
     const uint32_t samplesAhead = 8 * 735;
     void alignWritePtr() { writePtr = (readPtr  + samplesAhead) % bufferSize; }
     
+    //! @brief    Returns the fill level established by alignWritePtr()
+    double targetFillLevel() { return (double)samplesAhead / (double)bufferSize; }
+    
 public:
     
     /*! @brief    Executes SID until a certain cycle is reached
@@ -58,6 +58,7 @@ SID::SID()
   bus_value = 0;
   bus_value_ttl = 0;
   write_pipeline = 0;
+  write_address = 0;
 
   databus_ttl = 0;
 }
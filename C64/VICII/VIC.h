@@ -557,7 +557,7 @@ private:
      *            this variable indicates which sources are holding the line
      *            low.
      */
-    TimeDelayed<uint16_t>baLine = TimeDelayed<uint16_t>(3);
+    TimeDelayed<uint16_t, 3> baLine;
     
     /*! @brief    Start address of the currently selected memory bank
      *  @details  There are four banks in total since the VIC chip can only
@@ -579,7 +579,7 @@ private:
     uint16_t bankAddr;
     
     //! @brief    Result of the lastest g-access
-    TimeDelayed<uint32_t>gAccessResult = TimeDelayed<uint32_t>(2);
+    TimeDelayed<uint32_t, 2> gAccessResult;
     
     
     //
@@ -141,6 +141,19 @@ struct AnyC64FileWrapper;
 - (void) setAlwaysWarp:(BOOL)b;
 - (BOOL) warpLoad;
 - (void) setWarpLoad:(BOOL)b;
+- (NSInteger) maxDriveLag;
+- (void) setMaxDriveLag:(NSInteger)cycles;
+- (BOOL) parallelDrives;
+- (void) setParallelDrives:(BOOL)b;
+- (void) requestWarp;
+- (void) releaseWarp;
+- (BOOL) warpReasonEnabled:(WarpReason)reason;
+- (void) setWarpReason:(WarpReason)reason enabled:(BOOL)b;
+- (WarpReasonConfig) warpReasonConfig:(WarpReason)reason;
+- (void) setWarpReason:(WarpReason)reason config:(WarpReasonConfig)config;
+- (WarpReasonStats) warpReasonStats:(WarpReason)reason;
+- (NSInteger) activeWarpReasons;
+- (void) dumpWarpPolicy;
 
 // Handling snapshots
 - (BOOL) takeAutoSnapshots;
@@ -197,6 +210,28 @@ struct AnyC64FileWrapper;
 // Flashing files
 - (BOOL)flash:(AnyC64FileProxy *)container;
 - (BOOL)flash:(AnyArchiveProxy *)archive item:(NSInteger)nr;
+- (BOOL)injectAndRun:(AnyArchiveProxy *)archive item:(NSInteger)nr;
+- (BOOL)isInjecting;
+
+// Boot cache
+- (NSString *)bootCacheDirectory;
+- (void)setBootCacheDirectory:(NSString *)path;
+- (void)invalidateBootCache;
+
+// State fingerprints
+- (BOOL)fingerprintsEnabled;
+- (void)setFingerprintsEnabled:(BOOL)value;
+- (BOOL)fingerprint:(FrameFingerprint *)fp forFrame:(NSInteger)frame;
+- (BOOL)latestFingerprint:(FrameFingerprint *)fp;
+- (uint64_t)fingerprint;
+
+// CPU trace
+- (BOOL)isRecordingCPUTrace;
+- (BOOL)startCPUTrace:(NSString *)path;
+- (void)stopCPUTrace;
+
+// Benchmarks
+- (BOOL)runBenchmarks:(NSString *)baseline;
 
 @end
 
@@ -235,6 +270,9 @@ struct AnyC64FileWrapper;
 - (void) setBreakpoint:(uint16_t)addr;
 - (void) deleteBreakpoint:(uint16_t)addr;
 - (void) toggleBreakpoint:(uint16_t)addr;
+- (BOOL) setConditionalBreakpoint:(uint16_t)addr condition:(NSString *)condition;
+- (void) deleteConditionalBreakpoint:(uint16_t)addr;
+- (NSInteger) breakpointHits:(uint16_t)addr;
 
 - (NSInteger) recordedInstructions;
 - (RecordedInstruction) readRecordedInstruction;
@@ -242,6 +280,8 @@ struct AnyC64FileWrapper;
 
 - (DisassembledInstruction) disassemble:(uint16_t)addr hex:(BOOL)h;
 - (DisassembledInstruction) disassembleRecordedInstr:(RecordedInstruction)instr hex:(BOOL)h;
+- (DecodedInstruction) decode:(uint16_t)addr;
+- (NSInteger) decode:(uint16_t)addr count:(NSInteger)count into:(DecodedInstruction *)buffer;
 
 @end
 
@@ -268,6 +308,17 @@ struct AnyC64FileWrapper;
 - (MemoryType) peekSource:(uint16_t)addr;
 - (MemoryType) pokeTarget:(uint16_t)addr;
 
+- (NSInteger) addWatchpoint:(uint16_t)from to:(uint16_t)to type:(WatchType)type condition:(NSString *)condition halt:(BOOL)halt;
+- (BOOL) deleteWatchpoint:(NSInteger)nr;
+- (void) deleteAllWatchpoints;
+- (NSInteger) watchpointHits:(NSInteger)nr;
+
+- (void) searchRestart;
+- (void) searchTakeReference;
+- (NSInteger) searchRefine:(SearchCondition)cond operand:(uint8_t)operand mask:(uint8_t)mask;
+- (NSInteger) searchPattern:(const uint8_t *)pattern mask:(const uint8_t *)mask length:(NSInteger)length;
+- (NSInteger) searchResults:(uint16_t *)buffer max:(NSInteger)max;
+
 - (uint8_t) spypeek:(uint16_t)addr source:(MemoryType)source;
 - (uint8_t) spypeek:(uint16_t)addr;
 - (uint8_t) spypeekIO:(uint16_t)addr;
@@ -439,6 +490,8 @@ struct AnyC64FileWrapper;
 - (void) releaseKeyAtRow:(NSInteger)row col:(NSInteger)col;
 - (void) releaseRestoreKey;
 - (void) releaseAll;
+- (BOOL) typeText:(NSString *)text;
+- (BOOL) isTyping;
 
 - (BOOL) leftShiftIsPressed;
 - (BOOL) rightShiftIsPressed;
@@ -491,6 +544,7 @@ struct AnyC64FileWrapper;
 - (CartridgeType) cartridgeType;
 - (void) attachCartridgeAndReset:(CRTFileProxy *)c;
 - (BOOL) attachGeoRamCartridge:(NSInteger)capacity;
+- (BOOL) attachReuCartridge:(NSInteger)capacity;
 - (void) attachIsepicCartridge;
 - (void) detachCartridgeAndReset;
 
@@ -532,6 +586,11 @@ struct AnyC64FileWrapper;
 - (BOOL) tracing;
 - (void) setTracing:(BOOL)b;
 
+- (BOOL) recording;
+- (void) setRecording:(BOOL)b;
+- (BOOL) saveRecording:(NSString *)path;
+- (void) dumpRecording;
+
 @end
 
 
@@ -10,6 +10,7 @@
 
 #import "C64Proxy.h"
 #import "C64.h"
+#import "Benchmark.h"
 #import "VirtualC64-Swift.h"
 
 struct C64Wrapper { C64 *c64; };
@@ -134,6 +135,18 @@ struct AnyC64FileWrapper { AnyC64File *file; };
 {
     wrapper->cpu->toggleHardBreakpoint(addr);
 }
+- (BOOL) setConditionalBreakpoint:(uint16_t)addr condition:(NSString *)condition
+{
+    return wrapper->cpu->setConditionalBreakpoint(addr, [condition UTF8String]);
+}
+- (void) deleteConditionalBreakpoint:(uint16_t)addr
+{
+    wrapper->cpu->deleteConditionalBreakpoint(addr);
+}
+- (NSInteger) breakpointHits:(uint16_t)addr
+{
+    return (NSInteger)wrapper->cpu->breakpointHits(addr);
+}
 - (NSInteger) recordedInstructions
 {
     return wrapper->cpu->recordedInstructions();
@@ -155,6 +168,14 @@ struct AnyC64FileWrapper { AnyC64File *file; };
 {
     return wrapper->cpu->disassemble(instr, h);
 }
+- (DecodedInstruction) decode:(uint16_t)addr
+{
+    return wrapper->cpu->disassembler.decode(addr);
+}
+- (NSInteger) decode:(uint16_t)addr count:(NSInteger)count into:(DecodedInstruction *)buffer
+{
+    return wrapper->cpu->disassembler.disassemble(addr, count, buffer);
+}
 
 @end
 
@@ -213,6 +234,50 @@ struct AnyC64FileWrapper { AnyC64File *file; };
 {
     return wrapper->mem->getPokeTarget(addr);
 }
+- (NSInteger) addWatchpoint:(uint16_t)from to:(uint16_t)to type:(WatchType)type condition:(NSString *)condition halt:(BOOL)halt
+{
+    return wrapper->mem->addWatchpoint(from, to, type, [condition UTF8String], halt);
+}
+- (BOOL) deleteWatchpoint:(NSInteger)nr
+{
+    return wrapper->mem->deleteWatchpoint((int)nr);
+}
+- (void) deleteAllWatchpoints
+{
+    wrapper->mem->deleteAllWatchpoints();
+}
+- (NSInteger) watchpointHits:(NSInteger)nr
+{
+    return (NSInteger)wrapper->mem->watchpointHits((int)nr);
+}
+- (void) searchRestart
+{
+    wrapper->mem->search.restart();
+}
+- (void) searchTakeReference
+{
+    wrapper->mem->suspend();
+    wrapper->mem->search.takeReference();
+    wrapper->mem->resume();
+}
+- (NSInteger) searchRefine:(SearchCondition)cond operand:(uint8_t)operand mask:(uint8_t)mask
+{
+    wrapper->mem->suspend();
+    NSInteger result = (NSInteger)wrapper->mem->search.refine(cond, operand, mask);
+    wrapper->mem->resume();
+    return result;
+}
+- (NSInteger) searchPattern:(const uint8_t *)pattern mask:(const uint8_t *)mask length:(NSInteger)length
+{
+    wrapper->mem->suspend();
+    NSInteger result = (NSInteger)wrapper->mem->search.findPattern(pattern, mask, (size_t)length);
+    wrapper->mem->resume();
+    return result;
+}
+- (NSInteger) searchResults:(uint16_t *)buffer max:(NSInteger)max
+{
+    return (NSInteger)wrapper->mem->search.getResults(buffer, (size_t)max);
+}
 - (uint8_t) spypeek:(uint16_t)addr source:(MemoryType)source
 {
     return wrapper->mem->spypeek(addr, source);
@@ -701,6 +766,22 @@ struct AnyC64FileWrapper { AnyC64File *file; };
 {
     b ? wrapper->iec->startTracing() : wrapper->iec->stopTracing();
 }
+- (BOOL) recording
+{
+    return wrapper->iec->trace.isRecording();
+}
+- (void) setRecording:(BOOL)b
+{
+    wrapper->iec->setRecording(b);
+}
+- (BOOL) saveRecording:(NSString *)path
+{
+    return wrapper->iec->saveRecording([path fileSystemRepresentation]);
+}
+- (void) dumpRecording
+{
+    wrapper->iec->dumpRecording(true);
+}
 
 @end
 
@@ -726,22 +807,30 @@ struct AnyC64FileWrapper { AnyC64File *file; };
 }
 - (void) pressKeyAtRow:(NSInteger)row col:(NSInteger)col
 {
-    wrapper->keyboard->pressKey(row, col);
+    wrapper->keyboard->c64->input.pressKey(row, col);
 }
 - (void) pressRestoreKey {
-    wrapper->keyboard->pressRestoreKey();
+    wrapper->keyboard->c64->input.pressRestoreKey();
 }
 - (void) releaseKeyAtRow:(NSInteger)row col:(NSInteger)col
 {
-    wrapper->keyboard->releaseKey(row, col);
+    wrapper->keyboard->c64->input.releaseKey(row, col);
 }
 - (void) releaseRestoreKey
 {
-    wrapper->keyboard->releaseRestoreKey();
+    wrapper->keyboard->c64->input.releaseRestoreKey();
 }
 - (void) releaseAll
 {
-    wrapper->keyboard->releaseAll();
+    wrapper->keyboard->c64->input.releaseAll();
+}
+- (BOOL) typeText:(NSString *)text
+{
+    return wrapper->keyboard->c64->input.typeText([text UTF8String]);
+}
+- (BOOL) isTyping
+{
+    return wrapper->keyboard->c64->input.isTyping();
 }
 - (BOOL) leftShiftIsPressed
 {
@@ -765,11 +854,11 @@ struct AnyC64FileWrapper { AnyC64File *file; };
 }
 - (void) lockShift
 {
-    wrapper->keyboard->pressShiftLockKey();
+    wrapper->keyboard->c64->input.setShiftLock(true);
 }
 - (void) unlockShift
 {
-    wrapper->keyboard->releaseShiftLockKey();
+    wrapper->keyboard->c64->input.setShiftLock(false);
 }
 - (BOOL) inUpperCaseMode
 {
@@ -823,7 +912,7 @@ struct AnyC64FileWrapper { AnyC64File *file; };
 }
 - (void) trigger:(JoystickEvent)event
 {
-    wrapper->port->trigger(event);
+    wrapper->port->c64->input.trigger(wrapper->port->getNr(), event);
 }
 
 @end
@@ -865,6 +954,10 @@ struct AnyC64FileWrapper { AnyC64File *file; };
 {
     return wrapper->expansionPort->attachGeoRamCartridge((uint32_t)capacity);
 }
+- (BOOL) attachReuCartridge:(NSInteger)capacity
+{
+    return wrapper->expansionPort->attachReuCartridge((uint32_t)capacity);
+}
 - (void) attachIsepicCartridge
 {
     wrapper->expansionPort->attachIsepicCartridge();
@@ -1541,6 +1634,58 @@ struct AnyC64FileWrapper { AnyC64File *file; };
 {
     wrapper->c64->setWarpLoad(b);
 }
+- (NSInteger) maxDriveLag
+{
+    return wrapper->c64->getMaxDriveLag();
+}
+- (void) setMaxDriveLag:(NSInteger)cycles
+{
+    wrapper->c64->setMaxDriveLag((unsigned)cycles);
+}
+- (BOOL) parallelDrives
+{
+    return wrapper->c64->getParallelDrives();
+}
+- (void) setParallelDrives:(BOOL)b
+{
+    wrapper->c64->setParallelDrives(b);
+}
+- (void) requestWarp
+{
+    wrapper->c64->requestWarp();
+}
+- (void) releaseWarp
+{
+    wrapper->c64->releaseWarp();
+}
+- (BOOL) warpReasonEnabled:(WarpReason)reason
+{
+    return wrapper->c64->warpPolicy.isEnabled(reason);
+}
+- (void) setWarpReason:(WarpReason)reason enabled:(BOOL)b
+{
+    wrapper->c64->warpPolicy.setEnabled(reason, b);
+}
+- (WarpReasonConfig) warpReasonConfig:(WarpReason)reason
+{
+    return wrapper->c64->warpPolicy.getConfig(reason);
+}
+- (void) setWarpReason:(WarpReason)reason config:(WarpReasonConfig)config
+{
+    wrapper->c64->warpPolicy.setConfig(reason, config);
+}
+- (WarpReasonStats) warpReasonStats:(WarpReason)reason
+{
+    return wrapper->c64->warpPolicy.getStats(reason);
+}
+- (NSInteger) activeWarpReasons
+{
+    return wrapper->c64->warpPolicy.getActiveReasons();
+}
+- (void) dumpWarpPolicy
+{
+    wrapper->c64->warpPolicy.dump();
+}
 
 // Handling snapshots
 - (BOOL) takeAutoSnapshots
@@ -1734,6 +1879,83 @@ struct AnyC64FileWrapper { AnyC64File *file; };
     AnyArchive *a = (AnyArchive *)([archive wrapper]->file);
     return wrapper->c64->flash(a, (unsigned)nr);
 }
+- (BOOL)injectAndRun:(AnyArchiveProxy *)archive item:(NSInteger)nr
+{
+    AnyArchive *a = (AnyArchive *)([archive wrapper]->file);
+    return wrapper->c64->injectAndRun(a, (unsigned)nr);
+}
+- (BOOL)isInjecting
+{
+    return wrapper->c64->isInjecting();
+}
+
+// Boot cache
+- (NSString *)bootCacheDirectory
+{
+    return [NSString stringWithUTF8String:wrapper->c64->bootCache.getDirectory()];
+}
+- (void)setBootCacheDirectory:(NSString *)path
+{
+    wrapper->c64->bootCache.setDirectory(path ? [path fileSystemRepresentation] : NULL);
+}
+- (void)invalidateBootCache
+{
+    wrapper->c64->bootCache.invalidate(wrapper->c64);
+}
+
+// State fingerprints
+- (BOOL)fingerprintsEnabled
+{
+    return wrapper->c64->fingerprints.isEnabled();
+}
+- (void)setFingerprintsEnabled:(BOOL)value
+{
+    wrapper->c64->fingerprints.setEnabled(value);
+}
+- (BOOL)fingerprint:(FrameFingerprint *)fp forFrame:(NSInteger)frame
+{
+    return wrapper->c64->fingerprints.get((uint64_t)frame, fp);
+}
+- (BOOL)latestFingerprint:(FrameFingerprint *)fp
+{
+    return wrapper->c64->fingerprints.latest(fp);
+}
+- (uint64_t)fingerprint
+{
+    wrapper->c64->suspend();
+    uint64_t result = wrapper->c64->fingerprint();
+    wrapper->c64->resume();
+    return result;
+}
+
+// CPU trace
+- (BOOL)isRecordingCPUTrace
+{
+    return wrapper->c64->cpuTrace.isRecording();
+}
+- (BOOL)startCPUTrace:(NSString *)path
+{
+    return wrapper->c64->startCPUTrace([path fileSystemRepresentation]);
+}
+- (void)stopCPUTrace
+{
+    wrapper->c64->stopCPUTrace();
+}
+
+// Benchmarks
+- (BOOL)runBenchmarks:(NSString *)baseline
+{
+    Benchmark benchmark;
+    const char *path = [baseline fileSystemRepresentation];
+    bool compare = benchmark.loadBaseline(path);
+    
+    bool result = benchmark.runAll();
+    benchmark.dump();
+    
+    // Record a baseline on the first run
+    if (!compare) benchmark.saveBaseline(path);
+    return result;
+}
 @end
 
 
@@ -579,6 +579,7 @@ extension MyController {
             break
             
         case MSG_CPU_HARD_BREAKPOINT_REACHED,
+             MSG_CPU_WATCHPOINT_REACHED,
              MSG_CPU_ILLEGAL_INSTRUCTION:
             self.debugOpenAction(self)
             refresh()